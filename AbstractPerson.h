@@ -8,76 +8,111 @@
 class AbstractPerson
 {
 protected:
-    string name;                                             ///< The name of the person.
-    string dateOfBirth;                                      ///< The date of birth of the person.
-    vector<pair<string, pair<string, string>>> appointments; ///< Appointments associated with the person.
+    PersonId id = 0;                        ///< The registry ID of the person.
+    string name;                            ///< The name of the person.
+    string_view dateOfBirth;                ///< The date of birth of the person, interned by the registry.
+    vector<AppointmentHandle> appointments; ///< Handles of the person's appointments in the registry store.
 
 public:
     /**
      * @brief Constructs an AbstractPerson object with the given name and date of birth.
      * @param name The name of the person.
-     * @param dateOfBirth The date of birth of the person.
+     * @param dateOfBirth The date of birth of the person; the text must outlive the person.
      */
-    AbstractPerson(const string &name, const string &dateOfBirth) : name(name), dateOfBirth(dateOfBirth) {}
+    AbstractPerson(string_view name, string_view dateOfBirth) : name(name), dateOfBirth(dateOfBirth) {}
 
     /**
      * @brief Constructs an AbstractPerson object with the given name.
      * @param name The name of the person.
      */
-    AbstractPerson(const string &name) : name(name) {}
+    AbstractPerson(string_view name) : name(name) {}
 
     /**
      * @brief Pure virtual function to print details of the person.
+     * @param registry The registry used to resolve the person's appointments.
      *
      * This function must be implemented by derived classes to print details specific to the person type.
      */
-    virtual void printDetails() = 0;
+    virtual void printDetails(IRegistry &registry) = 0;
 
     /**
      * @brief Gets the name of the person.
      * @return The name of the person.
      */
-    string &getName()
+    const string &getName() const
     {
         return name;
     }
 
+    /**
+     * @brief Gets the date of birth of the person.
+     * @return The date of birth, empty for doctors.
+     */
+    string_view getDateOfBirth() const
+    {
+        return dateOfBirth;
+    }
+
+    /**
+     * @brief Gets the registry ID of the person.
+     * @return The ID assigned when the person was added to the registry.
+     */
+    PersonId getId() const
+    {
+        return id;
+    }
+
+    /**
+     * @brief Sets the registry ID of the person.
+     * @param newId The ID assigned by the registry.
+     */
+    void setId(PersonId newId)
+    {
+        id = newId;
+    }
+
     /**
      * @brief Gets the appointments associated with the person.
-     * @return A reference to the vector of appointments.
+     * @return A reference to the vector of appointment handles.
      */
-    vector<pair<string, pair<string, string>>> &getAppointments()
+    vector<AppointmentHandle> &getAppointments()
     {
         return appointments;
     }
 
     /**
-     * @brief Adds an appointment for the person.
-     * @param dateTime The date and time of the appointment.
-     * @param patientName The name of the patient associated with the appointment.
-     * @param doctorName The name of the doctor associated with the appointment.
+     * @brief Gets the appointments associated with the person.
+     * @return A constant reference to the vector of appointment handles.
      */
-    void addAppointment(string &dateTime, string &patientName, string &doctorName)
+    const vector<AppointmentHandle> &getAppointments() const
     {
-        appointments.push_back(make_pair(dateTime, make_pair(patientName, doctorName)));
+        return appointments;
     }
 
     /**
-     * Deletes an appointment from the appointments list based on the specified date and time, patient name, and doctor name.
-     * @param dateTime The date and time of the appointment to delete.
-     * @param patientName The name of the patient associated with the appointment.
-     * @param doctorName The name of the doctor associated with the appointment.
+     * @brief Adds an appointment for the person.
+     * @param handle The handle of the appointment in the registry store.
+     * @return The position of the handle in the person's appointments list.
      */
-    void deleteAppointment(string &dateTime, string &patientName, string &doctorName)
+    uint32_t addAppointment(AppointmentHandle handle)
     {
-        auto it = std::remove_if(appointments.begin(), appointments.end(),
-                                 [&](pair<string, pair<string, string>> &appointment)
-                                 {
-                                     return (appointment.first == dateTime &&
-                                             appointment.second.first == patientName &&
-                                             appointment.second.second == doctorName);
-                                 });
+        appointments.push_back(handle);
+        return appointments.size() - 1;
+    }
 
-        appointments.erase(it, appointments.end());
+    /**
+     * @brief Deletes an appointment from the person's appointments list in O(1).
+     * @param position The position of the appointment's handle in the list.
+     * @return The handle that was moved into position, or the deleted handle if it was the last one.
+     *
+     * The last handle of the list takes the place of the deleted one, so the caller
+     * must record the new position of the returned handle.
+     */
+    AppointmentHandle deleteAppointment(uint32_t position)
+    {
+        AppointmentHandle moved = appointments.back();
+        appointments[position] = moved;
+        appointments.pop_back();
+        return moved;
     }
 };
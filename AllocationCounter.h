@@ -0,0 +1,105 @@
+#ifdef REGISTRY_ALLOCATION_CHECKS
+
+/**
+ * @class AllocationCounter
+ * @brief Counts the heap allocations of the process through the replaced global operator new.
+ *
+ * Building with -DREGISTRY_ALLOCATION_CHECKS replaces the global allocation functions
+ * with ones that count every allocation and track the bytes in use, taken as the usable
+ * size malloc gives each block, so allocator rounding is included. The benchmark reads
+ * the counters around each hot path to hold it to its allocation budget. Everything in
+ * this file is compiled out unless REGISTRY_ALLOCATION_CHECKS is defined.
+ */
+class AllocationCounter
+{
+private:
+    static std::atomic<uint64_t> &allocationCount()
+    {
+        static std::atomic<uint64_t> count{0};
+        return count;
+    }
+
+    static std::atomic<int64_t> &bytesCount()
+    {
+        static std::atomic<int64_t> bytes{0};
+        return bytes;
+    }
+
+public:
+    /**
+     * @brief Allocates a block and counts it.
+     * @param size The requested size in bytes.
+     * @return The block.
+     * @throws std::bad_alloc If malloc fails.
+     */
+    static void *allocate(size_t size)
+    {
+        void *block = malloc(size == 0 ? 1 : size);
+        if (block == nullptr)
+            throw std::bad_alloc();
+
+        allocationCount().fetch_add(1, std::memory_order_relaxed);
+        bytesCount().fetch_add(malloc_usable_size(block), std::memory_order_relaxed);
+        return block;
+    }
+
+    /**
+     * @brief Frees a block allocated by allocate().
+     * @param block The block; null is ignored.
+     *
+     * Kept out of line so that GCC, which inlines the replaced operator delete, does not
+     * take the call to free for one paired with its own operator new.
+     */
+    __attribute__((noinline)) static void release(void *block) noexcept
+    {
+        if (block == nullptr)
+            return;
+
+        bytesCount().fetch_sub(malloc_usable_size(block), std::memory_order_relaxed);
+        free(block);
+    }
+
+    /**
+     * @brief Gets the number of allocations since the process started.
+     * @return The number of allocations.
+     */
+    static uint64_t allocations()
+    {
+        return allocationCount().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the heap memory in use.
+     * @return The usable size of the blocks not yet freed, in bytes.
+     */
+    static int64_t bytesInUse()
+    {
+        return bytesCount().load(std::memory_order_relaxed);
+    }
+};
+
+void *operator new(size_t size) { return AllocationCounter::allocate(size); }
+void *operator new[](size_t size) { return AllocationCounter::allocate(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return AllocationCounter::allocate(size);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void operator delete(void *block, const std::nothrow_t &) noexcept { AllocationCounter::release(block); }
+void operator delete[](void *block, const std::nothrow_t &) noexcept { AllocationCounter::release(block); }
+
+void operator delete(void *block) noexcept { AllocationCounter::release(block); }
+void operator delete[](void *block) noexcept { AllocationCounter::release(block); }
+void operator delete(void *block, size_t) noexcept { AllocationCounter::release(block); }
+void operator delete[](void *block, size_t) noexcept { AllocationCounter::release(block); }
+
+#endif
@@ -1,51 +1,54 @@
+using PersonId = uint32_t; ///< Position of a doctor or patient in its registry table.
+
 /**
  * @class Appointment
  * @brief Represents an appointment between a doctor and a patient.
  *
  * This class encapsulates information about an appointment, including the date and time,
- * the doctor involved, and the patient attending the appointment.
+ * the doctor involved, and the patient attending the appointment. The doctor and patient
+ * are stored as registry IDs, so a record stays small and never goes stale.
  */
 class Appointment
 {
 private:
-    string _dateTime; ///< The date and time of the appointment.
-    Doctor _doctor;   ///< The doctor involved in the appointment.
-    Patient _patient; ///< The patient attending the appointment.
+    Timestamp _dateTime; ///< The date and time of the appointment.
+    PersonId _doctorId;  ///< The ID of the doctor involved in the appointment.
+    PersonId _patientId; ///< The ID of the patient attending the appointment.
 
 public:
     /**
      * @brief Constructs an Appointment object with the given date and time, doctor, and patient.
      * @param dateTime The date and time of the appointment.
-     * @param doctor The doctor involved in the appointment.
-     * @param patient The patient attending the appointment.
+     * @param doctorId The ID of the doctor involved in the appointment.
+     * @param patientId The ID of the patient attending the appointment.
      */
-    Appointment(string &dateTime, Doctor &doctor, Patient &patient)
-        : _dateTime(dateTime), _doctor(doctor), _patient(patient) {}
+    Appointment(Timestamp dateTime, PersonId doctorId, PersonId patientId)
+        : _dateTime(dateTime), _doctorId(doctorId), _patientId(patientId) {}
 
     /**
      * @brief Gets the date and time of the appointment.
-     * @return A constant reference to the date and time of the appointment.
+     * @return The date and time of the appointment.
      */
-    string &getDateTime()
+    Timestamp getDateTime() const
     {
         return _dateTime;
     }
 
     /**
      * @brief Gets the doctor involved in the appointment.
-     * @return A constant reference to the doctor involved in the appointment.
+     * @return The registry ID of the doctor.
      */
-    Doctor &getDoctor()
+    PersonId getDoctorId() const
     {
-        return _doctor;
+        return _doctorId;
     }
 
     /**
      * @brief Gets the patient attending the appointment.
-     * @return A constant reference to the patient attending the appointment.
+     * @return The registry ID of the patient.
      */
-    Patient &getPatient()
+    PersonId getPatientId() const
     {
-        return _patient;
+        return _patientId;
     }
 };
@@ -0,0 +1,350 @@
+/**
+ * @class AppointmentArchive
+ * @brief Compressed cold storage of the appointments of past days, one partition per day.
+ *
+ * A partition holds the appointments of one day sorted by doctor and time and encoded
+ * as varints: the doctor ID as the difference to the previous record, the minute of
+ * the day as the difference to the previous record of the same doctor, and the patient
+ * ID. A typical appointment takes four or five bytes instead of a store record and two
+ * handles. When the archive is opened on a directory, every partition is written to a
+ * file of its own and dropped from memory; otherwise partitions stay in memory in their
+ * encoded form. Partitions are decoded only when one of their days is queried.
+ *
+ * Storing is not thread-safe; loading is const and may run in parallel.
+ */
+class AppointmentArchive
+{
+public:
+    static constexpr uint32_t PARTITION_MAGIC = 0x31524148; ///< "HAR1" at the start of every partition.
+
+private:
+    /**
+     * @struct Partition
+     * @brief The encoded appointments of one day.
+     */
+    struct Partition
+    {
+        vector<uint8_t> data; ///< The encoded appointments; empty if the partition is only on disk.
+        size_t bytes = 0;     ///< Size of the encoded partition.
+    };
+
+    unordered_map<int32_t, Partition> _partitions; ///< Partitions by day index.
+    string _directory;                             ///< Directory holding the partition files, or empty.
+    int32_t _lastDay = INT32_MIN;                  ///< Latest archived day.
+
+    /**
+     * @brief Gets the path of the file of a partition.
+     * @param day The day index of the partition.
+     * @return The path inside the archive directory.
+     */
+    string partitionPath(int32_t day) const
+    {
+        return _directory + "/" + std::to_string(day) + ".day";
+    }
+
+    /**
+     * @brief Appends an unsigned integer in 7-bit groups, least significant first.
+     * @param out The buffer to append to.
+     * @param value The value to append.
+     */
+    static void putVarint(vector<uint8_t> &out, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    /**
+     * @brief Reads an integer written by putVarint.
+     * @param cursor The position to read from; receives the position after the value.
+     * @param end The end of the buffer.
+     * @param value Receives the value.
+     * @return True if a complete value was read, false otherwise.
+     */
+    static bool getVarint(const uint8_t *&cursor, const uint8_t *end, uint32_t &value)
+    {
+        value = 0;
+        for (int shift = 0; cursor < end && shift < 35; shift += 7)
+        {
+            uint8_t byte = *cursor++;
+            value |= uint32_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Encodes the appointments of a day.
+     * @param appointments The appointments, sorted by doctor and time.
+     * @return The encoded partition.
+     */
+    static vector<uint8_t> encode(const vector<Appointment> &appointments)
+    {
+        vector<uint8_t> data;
+        data.reserve(8 + appointments.size() * 5);
+
+        putVarint(data, PARTITION_MAGIC);
+        putVarint(data, appointments.size());
+
+        PersonId doctorId = 0;
+        int minute = 0;
+        for (const Appointment &appointment : appointments)
+        {
+            if (appointment.getDoctorId() != doctorId)
+                minute = 0;
+
+            putVarint(data, appointment.getDoctorId() - doctorId);
+            putVarint(data, appointment.getDateTime().minuteOfDay() - minute);
+            putVarint(data, appointment.getPatientId());
+
+            doctorId = appointment.getDoctorId();
+            minute = appointment.getDateTime().minuteOfDay();
+        }
+        return data;
+    }
+
+    /**
+     * @brief Decodes a partition.
+     * @param day The day index of the partition.
+     * @param data The encoded partition.
+     * @return The appointments, sorted by doctor and time.
+     * @throws std::runtime_error If the partition is damaged.
+     */
+    static vector<Appointment> decode(int32_t day, const vector<uint8_t> &data)
+    {
+        const uint8_t *cursor = data.data();
+        const uint8_t *end = cursor + data.size();
+
+        uint32_t magic = 0;
+        uint32_t count = 0;
+        if (!getVarint(cursor, end, magic) || magic != PARTITION_MAGIC || !getVarint(cursor, end, count) || count > data.size())
+            throw runtime_error("Damaged archive partition of day " + std::to_string(day));
+
+        vector<Appointment> appointments;
+        appointments.reserve(count);
+
+        PersonId doctorId = 0;
+        uint32_t minute = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t doctorDelta, minuteDelta, patientId;
+            if (!getVarint(cursor, end, doctorDelta) || !getVarint(cursor, end, minuteDelta) || !getVarint(cursor, end, patientId))
+                throw runtime_error("Damaged archive partition of day " + std::to_string(day));
+
+            if (doctorDelta != 0)
+                minute = 0;
+            doctorId += doctorDelta;
+            minute += minuteDelta;
+
+            appointments.emplace_back(Timestamp(day, minute), doctorId, patientId);
+        }
+        return appointments;
+    }
+
+    /**
+     * @brief Reads the file of a partition.
+     * @param day The day index of the partition.
+     * @return The encoded partition.
+     * @throws std::runtime_error If the file cannot be read.
+     */
+    vector<uint8_t> readPartition(int32_t day) const
+    {
+        string path = partitionPath(day);
+        ifstream file(path, std::ios::binary);
+        if (!file)
+            throw runtime_error("Cannot read archive partition " + path);
+
+        return vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * @brief Writes the file of a partition and fsyncs it.
+     * @param day The day index of the partition.
+     * @param data The encoded partition.
+     * @throws std::runtime_error If the file cannot be written.
+     *
+     * The file is written under a temporary name and renamed into place, so a crash
+     * leaves either the old partition or the new one.
+     */
+    void writePartition(int32_t day, const vector<uint8_t> &data) const
+    {
+        string path = partitionPath(day);
+        string temporaryPath = path + ".tmp";
+
+        int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw runtime_error("Cannot write archive partition " + path + ": " + strerror(errno));
+
+        size_t written = 0;
+        while (written < data.size())
+        {
+            ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0)
+            {
+                ::close(fd);
+                throw runtime_error("Cannot write archive partition " + path + ": " + strerror(errno));
+            }
+            written += result;
+        }
+
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+
+        if (!synced || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+            throw runtime_error("Cannot write archive partition " + path);
+    }
+
+public:
+    /**
+     * @brief Keeps the partitions in a directory from now on and registers the ones already there.
+     * @param directory The directory of the partition files; it is created if missing.
+     *
+     * Partitions stored in memory before are written to the directory.
+     */
+    void open(const string &directory)
+    {
+        ::mkdir(directory.c_str(), 0755);
+        _directory = directory;
+
+        for (auto &entry : _partitions)
+        {
+            if (!entry.second.data.empty())
+            {
+                writePartition(entry.first, entry.second.data);
+                entry.second.data = vector<uint8_t>();
+            }
+        }
+
+        DIR *listing = ::opendir(directory.c_str());
+        if (listing == nullptr)
+            return;
+
+        while (dirent *file = ::readdir(listing))
+        {
+            string name = file->d_name;
+            if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".day") != 0)
+                continue;
+
+            char *end = nullptr;
+            long day = strtol(name.c_str(), &end, 10);
+            if (end != name.c_str() + name.size() - 4)
+                continue;
+
+            struct stat info;
+            Partition &partition = _partitions[day];
+            _lastDay = std::max<int32_t>(_lastDay, day);
+            if (::stat((directory + "/" + name).c_str(), &info) == 0)
+                partition.bytes = info.st_size;
+        }
+        ::closedir(listing);
+    }
+
+    /**
+     * @brief Checks whether a day has been archived.
+     * @param day The day index.
+     * @return True if the day has a partition, false otherwise.
+     */
+    bool contains(int32_t day) const
+    {
+        return _partitions.find(day) != _partitions.end();
+    }
+
+    /**
+     * @brief Gets the latest archived day; days are archived in order, so every earlier day is closed as well.
+     * @return The day index, or INT32_MIN if nothing is archived.
+     */
+    int32_t lastDay() const
+    {
+        return _lastDay;
+    }
+
+    /**
+     * @brief Loads the appointments of an archived day.
+     * @param day The day index.
+     * @return The appointments of the day sorted by doctor and time, or none if the day is not archived.
+     * @throws std::runtime_error If the partition cannot be read or is damaged.
+     */
+    vector<Appointment> load(int32_t day) const
+    {
+        auto it = _partitions.find(day);
+        if (it == _partitions.end())
+            return vector<Appointment>();
+
+        if (!it->second.data.empty())
+            return decode(day, it->second.data);
+
+        return decode(day, readPartition(day));
+    }
+
+    /**
+     * @brief Adds appointments to the partition of a day.
+     * @param day The day index.
+     * @param appointments The appointments of the day; an appointment of a doctor at a
+     *                     time that is already archived replaces nothing and is dropped.
+     * @throws std::runtime_error If the partition cannot be read or written.
+     */
+    void store(int32_t day, vector<Appointment> appointments)
+    {
+        vector<Appointment> archived = load(day);
+        appointments.insert(appointments.begin(), archived.begin(), archived.end());
+
+        auto byDoctorAndTime = [](const Appointment &a, const Appointment &b)
+        {
+            return a.getDoctorId() != b.getDoctorId() ? a.getDoctorId() < b.getDoctorId() : a.getDateTime() < b.getDateTime();
+        };
+        stable_sort(appointments.begin(), appointments.end(), byDoctorAndTime);
+        appointments.erase(std::unique(appointments.begin(), appointments.end(), [](const Appointment &a, const Appointment &b)
+                                       { return a.getDoctorId() == b.getDoctorId() && a.getDateTime() == b.getDateTime(); }),
+                           appointments.end());
+
+        Partition &partition = _partitions[day];
+        partition.data = encode(appointments);
+        _lastDay = std::max(_lastDay, day);
+        partition.bytes = partition.data.size();
+
+        if (!_directory.empty())
+        {
+            writePartition(day, partition.data);
+            partition.data = vector<uint8_t>();
+        }
+    }
+
+    /**
+     * @brief Gets the number of archived days.
+     * @return The number of partitions.
+     */
+    size_t size() const
+    {
+        return _partitions.size();
+    }
+
+    /**
+     * @brief Gets the size of the archive in its encoded form.
+     * @return The bytes of all partitions, on disk or in memory.
+     */
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (const auto &entry : _partitions)
+            total += entry.second.bytes;
+        return total;
+    }
+
+    /**
+     * @brief Gets the number of bytes held in memory for the archive.
+     * @return The capacity of the partitions kept in memory.
+     */
+    size_t memoryUsage() const
+    {
+        size_t total = _partitions.size() * (sizeof(pair<const int32_t, Partition>) + 2 * sizeof(void *));
+        for (const auto &entry : _partitions)
+            total += entry.second.data.capacity();
+        return total;
+    }
+};
@@ -0,0 +1,119 @@
+/**
+ * @class AppointmentSeries
+ * @brief A recurring appointment, such as a weekly physiotherapy session, stored as a rule.
+ *
+ * A series books the same doctor, patient and time of day every intervalDays days for
+ * a number of occurrences, except on the days it skips. Only the occurrences inside
+ * the registry's active window are materialized as appointments; the rest of the
+ * series costs a few bytes no matter how far ahead it runs.
+ */
+class AppointmentSeries
+{
+public:
+    static constexpr int MAX_OCCURRENCES = 0xFFFF; ///< Longest series.
+
+private:
+    PersonId _doctorId;         ///< The doctor of every occurrence.
+    PersonId _patientId;        ///< The patient of every occurrence.
+    Timestamp _first;           ///< Date and time of the first occurrence.
+    uint16_t _intervalDays;     ///< Days from one occurrence to the next.
+    uint16_t _count;            ///< Number of occurrences, skipped ones included.
+    vector<int32_t> _skipped;   ///< Sorted day indices of the skipped occurrences.
+    uint16_t _materialized = 0; ///< Leading occurrences already booked or skipped.
+
+public:
+    /**
+     * @brief Constructs a series.
+     * @param doctorId The ID of the doctor.
+     * @param patientId The ID of the patient.
+     * @param first The date and time of the first occurrence.
+     * @param intervalDays The days between occurrences, at least 1.
+     * @param count The number of occurrences, between 1 and MAX_OCCURRENCES.
+     */
+    AppointmentSeries(PersonId doctorId, PersonId patientId, Timestamp first, int intervalDays, int count)
+        : _doctorId(doctorId), _patientId(patientId), _first(first), _intervalDays(intervalDays), _count(count) {}
+
+    PersonId getDoctorId() const { return _doctorId; }
+    PersonId getPatientId() const { return _patientId; }
+    Timestamp getFirst() const { return _first; }
+    int getIntervalDays() const { return _intervalDays; }
+    size_t size() const { return _count; }
+
+    /**
+     * @brief Gets the date and time of an occurrence.
+     * @param index The number of the occurrence, starting at 0.
+     * @return The date and time of the occurrence.
+     */
+    Timestamp occurrence(size_t index) const
+    {
+        return Timestamp(_first.day() + int32_t(index) * _intervalDays, _first.minuteOfDay());
+    }
+
+    /**
+     * @brief Finds the occurrence at a date and time.
+     * @param dateTime The date and time.
+     * @param index Receives the number of the occurrence.
+     * @return True if an occurrence, skipped or not, starts at dateTime, false otherwise.
+     */
+    bool findOccurrence(Timestamp dateTime, size_t &index) const
+    {
+        int32_t offset = dateTime.day() - _first.day();
+        if (dateTime.minuteOfDay() != _first.minuteOfDay() || offset < 0 || offset % _intervalDays != 0 || offset / _intervalDays >= _count)
+            return false;
+
+        index = offset / _intervalDays;
+        return true;
+    }
+
+    /**
+     * @brief Checks whether the occurrence of a day is skipped.
+     * @param day The day index.
+     * @return True if the day is an exception of the series, false otherwise.
+     */
+    bool isSkipped(int32_t day) const
+    {
+        return std::binary_search(_skipped.begin(), _skipped.end(), day);
+    }
+
+    /**
+     * @brief Adds an exception to the series.
+     * @param day The day index of the occurrence to skip.
+     * @return True if the day was not skipped before, false otherwise.
+     */
+    bool skip(int32_t day)
+    {
+        auto it = std::lower_bound(_skipped.begin(), _skipped.end(), day);
+        if (it != _skipped.end() && *it == day)
+            return false;
+
+        _skipped.insert(it, day);
+        return true;
+    }
+
+    /**
+     * @brief Gets the skipped days.
+     * @return The sorted day indices of the exceptions.
+     */
+    const vector<int32_t> &getSkipped() const
+    {
+        return _skipped;
+    }
+
+    /**
+     * @brief Gets the number of leading occurrences that were already booked or skipped.
+     * @return The number of materialized occurrences.
+     */
+    size_t materialized() const
+    {
+        return _materialized;
+    }
+
+    /**
+     * @brief Records how many leading occurrences were booked or skipped.
+     * @param count The number of materialized occurrences.
+     */
+    void setMaterialized(size_t count)
+    {
+        _materialized = count;
+    }
+};
@@ -0,0 +1,200 @@
+/**
+ * @struct AppointmentHandle
+ * @brief A stable reference to an appointment in the AppointmentStore.
+ *
+ * A handle stays valid until its appointment is erased and is never reused for a
+ * different appointment, because erasing bumps the generation of its slot.
+ */
+struct AppointmentHandle
+{
+    uint32_t slot = 0;       ///< The slot of the appointment in the store.
+    uint32_t generation = 0; ///< The generation of the slot when the handle was issued.
+
+    bool operator==(const AppointmentHandle &other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const AppointmentHandle &other) const { return !(*this == other); }
+};
+
+/**
+ * @class AppointmentStore
+ * @brief The single table holding every scheduled appointment.
+ *
+ * Appointments are kept densely packed for fast iteration, while a slot table maps
+ * handles to their current position. Inserting and erasing are O(1); erasing moves
+ * the last appointment into the freed position. The pages of the packed table that
+ * every insert and erase changes are stamped, so report views can copy just those.
+ */
+class AppointmentStore
+{
+private:
+    vector<Appointment> _records;     ///< Densely packed appointments.
+    vector<uint32_t> _recordSlot;     ///< Slot of each entry in _records.
+    vector<uint32_t> _slotPosition;   ///< Position in _records of each slot.
+    vector<uint32_t> _slotGeneration; ///< Current generation of each slot.
+    vector<uint32_t> _slotIndexPos;   ///< Position of each slot's handle in its patient's index.
+    vector<uint32_t> _freeSlots;      ///< Slots available for reuse.
+    PageStamps _pages;                ///< Changes of the pages of _records.
+
+public:
+    /**
+     * @brief Adds an appointment to the store.
+     * @param appointment The appointment to add.
+     * @return The handle of the stored appointment.
+     */
+    AppointmentHandle insert(const Appointment &appointment)
+    {
+        uint32_t slot;
+        if (_freeSlots.empty())
+        {
+            slot = _slotPosition.size();
+            _slotPosition.push_back(0);
+            _slotGeneration.push_back(0);
+            _slotIndexPos.push_back(0);
+        }
+        else
+        {
+            slot = _freeSlots.back();
+            _freeSlots.pop_back();
+        }
+
+        _slotPosition[slot] = _records.size();
+        _pages.touch(_records.size());
+        _records.push_back(appointment);
+        _recordSlot.push_back(slot);
+
+        return AppointmentHandle{slot, _slotGeneration[slot]};
+    }
+
+    /**
+     * @brief Checks whether a handle refers to a stored appointment.
+     * @param handle The handle to check.
+     * @return True if the appointment has not been erased, false otherwise.
+     */
+    bool contains(AppointmentHandle handle) const
+    {
+        return handle.slot < _slotGeneration.size() && _slotGeneration[handle.slot] == handle.generation &&
+               _slotPosition[handle.slot] < _records.size() && _recordSlot[_slotPosition[handle.slot]] == handle.slot;
+    }
+
+    /**
+     * @brief Retrieves an appointment by handle.
+     * @param handle The handle of the appointment.
+     * @return A reference to the appointment.
+     * @throws std::out_of_range If the handle does not refer to a stored appointment.
+     */
+    const Appointment &get(AppointmentHandle handle) const
+    {
+        if (!contains(handle))
+        {
+            throw std::out_of_range("Appointment not found.");
+        }
+        return _records[_slotPosition[handle.slot]];
+    }
+
+    /**
+     * @brief Removes an appointment from the store.
+     * @param handle The handle of the appointment to remove.
+     * @throws std::out_of_range If the handle does not refer to a stored appointment.
+     */
+    void erase(AppointmentHandle handle)
+    {
+        if (!contains(handle))
+        {
+            throw std::out_of_range("Appointment not found.");
+        }
+
+        uint32_t position = _slotPosition[handle.slot];
+        uint32_t last = _records.size() - 1;
+
+        _records[position] = _records[last];
+        _recordSlot[position] = _recordSlot[last];
+        _slotPosition[_recordSlot[position]] = position;
+        _pages.touch(position);
+        _pages.touch(last);
+
+        _records.pop_back();
+        _recordSlot.pop_back();
+
+        _slotGeneration[handle.slot]++;
+        _freeSlots.push_back(handle.slot);
+    }
+
+    /**
+     * @brief Gets where the handle of an appointment sits in its patient's index.
+     * @param handle The handle of a stored appointment.
+     * @return The position recorded by setIndexPosition().
+     */
+    uint32_t indexPosition(AppointmentHandle handle) const
+    {
+        return _slotIndexPos[handle.slot];
+    }
+
+    /**
+     * @brief Records where the handle of an appointment sits in its patient's index.
+     * @param handle The handle of a stored appointment.
+     * @param position The position of the handle in the patient's list of appointments.
+     */
+    void setIndexPosition(AppointmentHandle handle, uint32_t position)
+    {
+        _slotIndexPos[handle.slot] = position;
+    }
+
+    /**
+     * @brief Gets the handle of the appointment at a position in iteration order.
+     * @param position The position of the appointment.
+     * @return The handle of the appointment.
+     * @throws std::out_of_range If the position is out of bounds.
+     */
+    AppointmentHandle handleAt(size_t position) const
+    {
+        if (position >= _records.size())
+        {
+            throw std::out_of_range("Invalid index.");
+        }
+        uint32_t slot = _recordSlot[position];
+        return AppointmentHandle{slot, _slotGeneration[slot]};
+    }
+
+    /**
+     * @brief Reserves room for a number of appointments.
+     * @param count The number of appointments to reserve room for.
+     */
+    void reserve(size_t count)
+    {
+        _records.reserve(count);
+        _recordSlot.reserve(count);
+        _slotPosition.reserve(count);
+        _slotGeneration.reserve(count);
+        _slotIndexPos.reserve(count);
+    }
+
+    /**
+     * @brief Gets the number of stored appointments.
+     * @return The number of appointments.
+     */
+    size_t size() const
+    {
+        return _records.size();
+    }
+
+    /**
+     * @brief Gets the number of bytes allocated for the store.
+     * @return The capacity of all arrays in bytes.
+     */
+    size_t memoryUsage() const
+    {
+        return _records.capacity() * sizeof(Appointment) +
+               (_recordSlot.capacity() + _slotPosition.capacity() + _slotGeneration.capacity() + _slotIndexPos.capacity() + _freeSlots.capacity()) * sizeof(uint32_t);
+    }
+
+    /**
+     * @brief Gets the changes of the pages of the packed table.
+     * @return The page stamps, with rows numbered in iteration order.
+     */
+    const PageStamps &pages() const
+    {
+        return _pages;
+    }
+
+    vector<Appointment>::const_iterator begin() const { return _records.begin(); }
+    vector<Appointment>::const_iterator end() const { return _records.end(); }
+};
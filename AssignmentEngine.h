@@ -0,0 +1,226 @@
+/**
+ * @struct WaitingListEntry
+ * @brief A patient waiting for an appointment, with the slots the patient accepts.
+ */
+struct WaitingListEntry
+{
+    static constexpr PersonId ANY_DOCTOR = UINT32_MAX; ///< The patient accepts every doctor.
+
+    PersonId patientId;             ///< The ID of the patient.
+    PersonId doctorId = ANY_DOCTOR; ///< The ID of the wanted doctor, or ANY_DOCTOR.
+    Timestamp from;                 ///< Earliest accepted start of the appointment.
+    Timestamp to;                   ///< The start after the accepted window.
+};
+
+/**
+ * @struct Placement
+ * @brief The outcome of one waiting list entry.
+ */
+struct Placement
+{
+    bool placed = false;      ///< An appointment was booked for the entry.
+    FreeSlot slot{};          ///< The booked slot, if placed.
+    AppointmentHandle handle; ///< The booked appointment, if placed.
+};
+
+/**
+ * @class AssignmentEngine
+ * @brief Books a whole waiting list into free slots in one pass.
+ *
+ * The engine sweeps the free slots of every doctor in chronological order, straight
+ * from the slot calendars through FreeSlotRange. Each slot goes to the waiting patient
+ * it fits whose window closes first, and on a tie to a patient who wants that doctor
+ * over one who accepts anyone; this earliest-deadline rule places the most patients
+ * when patients accept any doctor, and otherwise gives doctor-specific patients their
+ * doctor's slots first. Patients are placed at the earliest slot the rule leaves them.
+ * While nobody is waiting, the sweep jumps straight to the next window that opens.
+ *
+ * The chosen slots are booked with one Registry::scheduleAppointments() call, so a
+ * list of thousands of patients costs one sort, one sweep and one logged batch.
+ */
+class AssignmentEngine
+{
+private:
+    Registry &registry;
+
+    /**
+     * @struct Candidate
+     * @brief A waiting entry whose window has opened, ordered by the end of its window.
+     */
+    struct Candidate
+    {
+        Timestamp to; ///< The end of the window.
+        size_t entry; ///< Position of the entry in the waiting list.
+
+        bool operator<(const Candidate &other) const
+        {
+            return to != other.to ? to > other.to : entry > other.entry;
+        }
+    };
+
+    using CandidateQueue = std::priority_queue<Candidate>; ///< Open entries, earliest window end on top.
+
+    /**
+     * @brief Drops the entries whose window closed before a time.
+     * @param queue The open entries.
+     * @param now The start of the current slot.
+     * @return The number of entries dropped.
+     */
+    static size_t dropExpired(CandidateQueue &queue, Timestamp now)
+    {
+        size_t dropped = 0;
+        while (!queue.empty() && queue.top().to <= now)
+        {
+            queue.pop();
+            dropped++;
+        }
+        return dropped;
+    }
+
+public:
+    /**
+     * @brief Constructs an engine booking into the given registry.
+     * @param reg Reference to the Registry object.
+     */
+    AssignmentEngine(Registry &reg) : registry(reg) {}
+
+    /**
+     * @brief Books as many entries of a waiting list as the free slots allow.
+     * @param waitingList The entries; entries naming unknown doctors or empty windows are not placed.
+     * @return One placement per entry, in the order of the waiting list.
+     */
+    vector<Placement> assign(const vector<WaitingListEntry> &waitingList)
+    {
+        vector<Placement> placements(waitingList.size());
+        deque<Doctor> &doctors = registry.getDoctors();
+
+        vector<size_t> order;
+        order.reserve(waitingList.size());
+        for (size_t i = 0; i < waitingList.size(); ++i)
+        {
+            const WaitingListEntry &entry = waitingList[i];
+            if (entry.from < entry.to && (entry.doctorId == WaitingListEntry::ANY_DOCTOR || entry.doctorId < doctors.size()))
+                order.push_back(i);
+        }
+        if (order.empty())
+            return placements;
+
+        stable_sort(order.begin(), order.end(), [&waitingList](size_t a, size_t b)
+                    { return waitingList[a].from < waitingList[b].from; });
+
+        Timestamp end = waitingList[order[0]].to;
+        for (size_t i : order)
+            end = std::max(end, waitingList[i].to);
+
+        CandidateQueue anyDoctor;
+        unordered_map<PersonId, CandidateQueue> byDoctor;
+        size_t waiting = 0;
+        size_t released = 0;
+
+        vector<ScheduleRequest> requests;
+        vector<size_t> requestEntries;
+
+        Timestamp from = waitingList[order[0]].from;
+        while (true)
+        {
+            bool jumped = false;
+            for (FreeSlot slot : registry.getFreeSlots(from, end.day() - from.day() + 1))
+            {
+                if (slot.dateTime >= end)
+                    break;
+
+                while (released < order.size() && waitingList[order[released]].from <= slot.dateTime)
+                {
+                    const WaitingListEntry &entry = waitingList[order[released]];
+                    CandidateQueue &queue = entry.doctorId == WaitingListEntry::ANY_DOCTOR ? anyDoctor : byDoctor[entry.doctorId];
+                    queue.push(Candidate{entry.to, order[released++]});
+                    waiting++;
+                }
+
+                waiting -= dropExpired(anyDoctor, slot.dateTime);
+                auto own = byDoctor.find(slot.doctorId);
+                if (own != byDoctor.end())
+                    waiting -= dropExpired(own->second, slot.dateTime);
+
+                if (waiting == 0)
+                {
+                    if (released < order.size())
+                    {
+                        from = waitingList[order[released]].from;
+                        jumped = true;
+                    }
+                    break;
+                }
+
+                CandidateQueue *queue = nullptr;
+                if (own != byDoctor.end() && !own->second.empty())
+                    queue = &own->second;
+                if (!anyDoctor.empty() && (queue == nullptr || anyDoctor.top().to < queue->top().to))
+                    queue = &anyDoctor;
+                if (queue == nullptr)
+                    continue;
+
+                size_t entry = queue->top().entry;
+                queue->pop();
+                waiting--;
+
+                placements[entry].slot = slot;
+                requests.push_back(ScheduleRequest{slot.dateTime, slot.doctorId, waitingList[entry].patientId});
+                requestEntries.push_back(entry);
+            }
+
+            if (!jumped)
+                break;
+        }
+
+        vector<ScheduleResult> results = registry.scheduleAppointments(requests);
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            Placement &placement = placements[requestEntries[i]];
+            placement.placed = results[i].status == ScheduleStatus::SCHEDULED;
+            placement.handle = results[i].handle;
+        }
+        return placements;
+    }
+
+    /**
+     * @brief Cancels a doctor's day and books its patients again.
+     * @param doctor The doctor who is absent.
+     * @param date The canceled day.
+     * @param windowDays The days after the canceled one in which the patients are rebooked.
+     * @return The number of patients rebooked; the others only lost their appointment.
+     *
+     * Every patient is first offered the same doctor within the window and, failing
+     * that, any doctor within the same window.
+     */
+    size_t rebookDay(Doctor &doctor, Timestamp date, int windowDays)
+    {
+        Timestamp dayStart(date.day(), 0);
+        Timestamp windowStart(date.day() + 1, 0);
+        Timestamp windowEnd(date.day() + 1 + windowDays, 0);
+
+        ScheduleRange schedule = doctor.getSchedule(dayStart, windowStart);
+        vector<AppointmentHandle> canceled(schedule.begin(), schedule.end());
+
+        vector<WaitingListEntry> waitingList;
+        for (AppointmentHandle handle : canceled)
+        {
+            waitingList.push_back(WaitingListEntry{registry.getAppointment(handle).getPatientId(), doctor.getId(), windowStart, windowEnd});
+            registry.cancelAppointment(handle);
+        }
+
+        vector<Placement> placements = assign(waitingList);
+
+        vector<WaitingListEntry> retry;
+        for (size_t i = 0; i < placements.size(); ++i)
+        {
+            if (!placements[i].placed)
+                retry.push_back(WaitingListEntry{waitingList[i].patientId, WaitingListEntry::ANY_DOCTOR, windowStart, windowEnd});
+        }
+
+        size_t rebooked = placements.size() - retry.size();
+        for (const Placement &placement : assign(retry))
+            rebooked += placement.placed;
+        return rebooked;
+    }
+};
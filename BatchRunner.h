@@ -0,0 +1,423 @@
+/**
+ * @struct BatchCommand
+ * @brief A parsed line of a batch script.
+ */
+struct BatchCommand
+{
+    size_t line = 0;       ///< Line number in the script, for error reports.
+    string verb;           ///< register, schedule, cancel, visit, series, skip, wait, assign or rebook.
+    vector<string> fields; ///< The '|'-separated arguments following the verb.
+};
+
+/**
+ * @class BatchRunner
+ * @brief Applies a script of registry commands without going through the interactive Menu.
+ *
+ * Each non-empty line not starting with '#' holds one command with '|'-separated fields:
+ *
+ *     register|<patient name>|<date of birth>
+ *     schedule|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>
+ *     cancel|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>
+ *     visit|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>|<diagnosis>
+ *     series|<doctor name>|<patient name>|<first YYYY-MM-DD HH:MM>|<interval days>|<occurrences>
+ *     skip|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>
+ *     wait|<patient name>|<doctor name or *>|<first YYYY-MM-DD>|<last YYYY-MM-DD>
+ *     assign
+ *     rebook|<doctor name>|<YYYY-MM-DD>|<window days>
+ *
+ * Commands are read and applied in batches of BATCH_SIZE. While a batch is applied,
+ * everything the registry prints is captured in memory and written out in one chunk,
+ * and the write-ahead log is synced once per batch. Consecutive schedule commands are
+ * handed to the registry as one bulk request, which is made before the next command
+ * that prints anything, so the output still follows the order of the script.
+ *
+ * Wait commands put a patient on the waiting list; the list is booked by the
+ * AssignmentEngine at the next assign command or at the end of the script, and each
+ * wait command counts as applied if its patient was placed. Rebook cancels a doctor's
+ * day and books its patients again within the given number of following days.
+ */
+class BatchRunner
+{
+public:
+    static constexpr size_t BATCH_SIZE = 1024; ///< Commands applied per batch.
+
+private:
+    /**
+     * @class ConsoleCapture
+     * @brief Sends cout into a string buffer for as long as it lives.
+     *
+     * The console buffer is put back by the destructor, so cout never keeps pointing at
+     * the destroyed capture buffer, whatever leaves the scope.
+     */
+    class ConsoleCapture
+    {
+    private:
+        ostringstream _captured;  ///< The output written while capturing.
+        std::streambuf *_console; ///< The buffer of cout before capturing.
+
+    public:
+        ConsoleCapture() : _console(cout.rdbuf(_captured.rdbuf())) {}
+
+        ConsoleCapture(const ConsoleCapture &) = delete;
+        ConsoleCapture &operator=(const ConsoleCapture &) = delete;
+
+        ~ConsoleCapture()
+        {
+            cout.rdbuf(_console);
+        }
+
+        string text() const { return _captured.str(); }
+    };
+
+    Registry &registry;
+
+    size_t _applied = 0;  ///< Commands that changed the registry.
+    size_t _rejected = 0; ///< Commands that were valid but could not be applied.
+    size_t _failed = 0;   ///< Commands that could not be parsed or referred to unknown people.
+
+    vector<ScheduleRequest> _requests; ///< Pending run of consecutive schedule commands.
+    vector<size_t> _requestLines;      ///< Script line of each pending schedule command.
+
+    vector<WaitingListEntry> _waitingList; ///< Patients of the wait commands since the last assign.
+
+public:
+    /**
+     * @brief Splits a script line into a command.
+     * @param text The line without its terminator.
+     * @param command Receives the verb and fields.
+     */
+    static void parse(const string &text, BatchCommand &command)
+    {
+        command.fields.clear();
+
+        size_t start = 0;
+        size_t separator = text.find('|');
+        command.verb = text.substr(0, separator);
+
+        while (separator != string::npos)
+        {
+            start = separator + 1;
+            separator = text.find('|', start);
+            command.fields.push_back(text.substr(start, separator == string::npos ? string::npos : separator - start));
+        }
+    }
+
+private:
+    /**
+     * @brief Applies a single command to the registry.
+     * @param command The command to apply.
+     * @return True if the registry was changed, false if the command was rejected.
+     * @throws std::exception If the command is malformed or refers to unknown people.
+     */
+    bool apply(BatchCommand &command)
+    {
+        vector<string> &fields = command.fields;
+
+        if (command.verb == "register" && fields.size() == 2)
+        {
+            if (registry.patientExists(fields[0]))
+                return false;
+
+            registry.addPatient(fields[0], fields[1]);
+            return true;
+        }
+
+        if (command.verb == "cancel" && fields.size() == 3)
+        {
+            Doctor &doctor = registry.findDoctorByName(fields[0]);
+            Patient &patient = registry.findPatientByName(fields[1]);
+            Timestamp dateTime = Timestamp::parse(fields[2]);
+
+            return registry.cancelAppointment(dateTime, patient.getName(), doctor.getName());
+        }
+
+        if (command.verb == "visit" && fields.size() == 4)
+        {
+            Doctor &doctor = registry.findDoctorByName(fields[0]);
+            Patient &patient = registry.findPatientByName(fields[1]);
+
+            registry.addHospitalVisitCard(doctor, patient, Timestamp::parse(fields[2]), fields[3]);
+            return true;
+        }
+
+        if (command.verb == "series" && fields.size() == 5)
+        {
+            Doctor &doctor = registry.findDoctorByName(fields[0]);
+            Patient &patient = registry.findPatientByName(fields[1]);
+
+            registry.addSeries(doctor, patient, Timestamp::parse(fields[2]), std::stoi(fields[3]), std::stoi(fields[4]));
+            return true;
+        }
+
+        if (command.verb == "rebook" && fields.size() == 3)
+        {
+            Doctor &doctor = registry.findDoctorByName(fields[0]);
+            Timestamp date = Timestamp::parse(fields[1]);
+
+            size_t canceled = doctor.getSchedule(Timestamp(date.day(), 0), Timestamp(date.day() + 1, 0)).size();
+            size_t rebooked = AssignmentEngine(registry).rebookDay(doctor, date, std::stoi(fields[2]));
+
+            cout << "Rebooked " << rebooked << " of " << canceled << " appointments of Dr. " << doctor.getName() << '\n';
+            return canceled > 0;
+        }
+
+        if (command.verb == "skip" && fields.size() == 3)
+        {
+            Doctor &doctor = registry.findDoctorByName(fields[0]);
+            Patient &patient = registry.findPatientByName(fields[1]);
+
+            registry.skipSeriesOccurrence(doctor, patient, Timestamp::parse(fields[2]));
+            return true;
+        }
+
+        throw std::invalid_argument("Unknown command " + command.verb + " with " + std::to_string(fields.size()) + " fields.");
+    }
+
+    /**
+     * @brief Resolves a schedule command and adds it to the pending bulk request.
+     * @param command The schedule command.
+     * @throws std::exception If the command refers to unknown people or an invalid time.
+     */
+    void queueSchedule(const BatchCommand &command)
+    {
+        const vector<string> &fields = command.fields;
+
+        ScheduleRequest request{Timestamp::parse(fields[2]), registry.findDoctorByName(fields[0]).getId(),
+                                registry.findPatientByName(fields[1]).getId()};
+
+        _requests.push_back(request);
+        _requestLines.push_back(command.line);
+    }
+
+    /**
+     * @brief Resolves a wait command and adds its patient to the waiting list.
+     * @param command The wait command.
+     * @throws std::exception If the command refers to unknown people or an invalid date.
+     */
+    void queueWaiting(const BatchCommand &command)
+    {
+        const vector<string> &fields = command.fields;
+
+        WaitingListEntry entry;
+        entry.patientId = registry.findPatientByName(fields[0]).getId();
+        if (fields[1] != "*")
+            entry.doctorId = registry.findDoctorByName(fields[1]).getId();
+        entry.from = Timestamp(Timestamp::parse(fields[2]).day(), 0);
+        entry.to = Timestamp(Timestamp::parse(fields[3]).day() + 1, 0);
+
+        _waitingList.push_back(entry);
+    }
+
+    /**
+     * @brief Books the waiting list with the assignment engine.
+     *
+     * If booking fails, every waiting patient counts as failed and the list is dropped.
+     */
+    void assignWaitingList()
+    {
+        if (_waitingList.empty())
+            return;
+
+        auto started = chrono::steady_clock::now();
+        vector<Placement> placements;
+        try
+        {
+            placements = AssignmentEngine(registry).assign(_waitingList);
+        }
+        catch (const std::exception &error)
+        {
+            _failed += _waitingList.size();
+            cout << "Waiting list of " << _waitingList.size() << " patients: " << error.what() << '\n';
+            _waitingList.clear();
+            return;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        size_t placed = 0;
+        for (const Placement &placement : placements)
+            placed += placement.placed;
+
+        _applied += placed;
+        _rejected += placements.size() - placed;
+
+        cout << "Assigned " << placed << " of " << placements.size() << " waiting patients in " << seconds << " s\n";
+        _waitingList.clear();
+    }
+
+    /**
+     * @brief Schedules the pending run of schedule commands with one bulk request.
+     *
+     * Every booking that is not made is reported under its line, with the reason. If
+     * the request fails as a whole, the error is reported under the line of every
+     * queued schedule command, which all count as failed.
+     */
+    void flushSchedules()
+    {
+        if (_requests.empty())
+            return;
+
+        vector<ScheduleResult> results;
+        try
+        {
+            results = registry.scheduleAppointments(_requests);
+        }
+        catch (const std::exception &error)
+        {
+            _failed += _requests.size();
+            for (size_t line : _requestLines)
+                cout << "Line " << line << ": " << error.what() << '\n';
+            _requests.clear();
+            _requestLines.clear();
+            return;
+        }
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            switch (results[i].status)
+            {
+            case ScheduleStatus::SCHEDULED:
+                _applied++;
+                break;
+            case ScheduleStatus::SLOT_TAKEN:
+                _rejected++;
+                cout << "Line " << _requestLines[i] << ": Dr. " << registry.getDoctorName(_requests[i].doctorId)
+                     << " is not available at " << _requests[i].dateTime << '\n';
+                break;
+            case ScheduleStatus::CONFLICT:
+                _rejected++;
+                cout << "Line " << _requestLines[i] << ": Dr. " << registry.getDoctorName(_requests[i].doctorId)
+                     << " is already booked at " << _requests[i].dateTime << " by an earlier line\n";
+                break;
+            default:
+                _failed++;
+                cout << "Line " << _requestLines[i] << ": Invalid appointment time " << _requests[i].dateTime << '\n';
+                break;
+            }
+        }
+
+        _requests.clear();
+        _requestLines.clear();
+    }
+
+    /**
+     * @brief Applies a batch of commands with the registry output captured in memory.
+     * @param batch The commands to apply.
+     * @param out The stream that receives the captured output.
+     * @param last True for the last batch of the script, which also books the waiting list.
+     */
+    void applyBatch(vector<BatchCommand> &batch, std::ostream &out, bool last)
+    {
+        string captured;
+        {
+            ConsoleCapture capture;
+            applyCommands(batch, last);
+            captured = capture.text();
+        }
+
+        out << captured;
+
+        registry.syncStorage();
+    }
+
+    /**
+     * @brief Applies a batch of commands, printing errors to cout.
+     * @param batch The commands to apply.
+     *
+     * Queued schedule commands are flushed before anything else is printed, so the
+     * reports of the script lines appear in line order.
+     * @param last True for the last batch of the script, which also books the waiting list.
+     */
+    void applyCommands(vector<BatchCommand> &batch, bool last)
+    {
+        for (auto &command : batch)
+        {
+            try
+            {
+                if (command.verb == "schedule" && command.fields.size() == 3)
+                {
+                    queueSchedule(command);
+                    continue;
+                }
+                if (command.verb == "wait" && command.fields.size() == 4)
+                {
+                    queueWaiting(command);
+                    continue;
+                }
+
+                flushSchedules();
+
+                if (command.verb == "assign" && command.fields.empty())
+                {
+                    assignWaitingList();
+                    continue;
+                }
+
+                if (apply(command))
+                    _applied++;
+                else
+                    _rejected++;
+            }
+            catch (const std::exception &error)
+            {
+                flushSchedules();
+                _failed++;
+                cout << "Line " << command.line << ": " << error.what() << '\n';
+            }
+        }
+
+        flushSchedules();
+        if (last)
+            assignWaitingList();
+    }
+
+public:
+    /**
+     * @brief Constructs a runner applying commands to the given registry.
+     * @param reg Reference to the Registry object.
+     */
+    BatchRunner(Registry &reg) : registry(reg) {}
+
+    /**
+     * @brief Reads and applies every command of a script.
+     * @param in The stream holding the script.
+     * @param out The stream that receives the registry output and the summary.
+     */
+    void run(std::istream &in, std::ostream &out)
+    {
+        auto started = chrono::steady_clock::now();
+
+        vector<BatchCommand> batch(BATCH_SIZE);
+        size_t pending = 0;
+        size_t line = 0;
+        string text;
+
+        while (getline(in, text))
+        {
+            line++;
+            if (!text.empty() && text.back() == '\r')
+                text.pop_back();
+            if (text.empty() || text[0] == '#')
+                continue;
+
+            batch[pending].line = line;
+            parse(text, batch[pending]);
+
+            if (++pending == BATCH_SIZE)
+            {
+                applyBatch(batch, out, false);
+                pending = 0;
+            }
+        }
+
+        batch.resize(pending);
+        applyBatch(batch, out, true);
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        size_t total = _applied + _rejected + _failed;
+
+        out << "Batch finished: " << total << " commands, " << _applied << " applied, " << _rejected
+            << " rejected, " << _failed << " failed in " << seconds << " s ("
+            << (seconds > 0 ? total / seconds : 0) << " commands/s)\n";
+        out.flush();
+    }
+};
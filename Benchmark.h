@@ -0,0 +1,326 @@
+/**
+ * @struct BenchmarkConfig
+ * @brief Size of the synthetic data set and number of measured calls per operation.
+ */
+struct BenchmarkConfig
+{
+    size_t doctors = 200;         ///< Doctors in the roster.
+    size_t patients = 20000;      ///< Registered patients.
+    size_t appointments = 100000; ///< Appointments booked before measuring.
+    size_t visitCards = 50000;    ///< Visit cards added before measuring.
+    size_t iterations = 20000;    ///< Measured calls per operation.
+    uint32_t seed = 42;           ///< Seed of the random generator.
+
+    /**
+     * @brief Reads settings from a comma-separated list of key=value pairs.
+     * @param spec The settings, for example "doctors=500,patients=100000".
+     * @throws std::invalid_argument If a key is unknown or a value is not a number.
+     */
+    void parse(const string &spec)
+    {
+        std::istringstream items(spec);
+        string item;
+
+        while (getline(items, item, ','))
+        {
+            size_t separator = item.find('=');
+            if (separator == string::npos)
+                throw std::invalid_argument("Expected key=value in benchmark settings: " + item);
+
+            string key = item.substr(0, separator);
+            size_t value = std::stoull(item.substr(separator + 1));
+
+            if (key == "doctors")
+                doctors = value;
+            else if (key == "patients")
+                patients = value;
+            else if (key == "appointments")
+                appointments = value;
+            else if (key == "visits")
+                visitCards = value;
+            else if (key == "iterations")
+                iterations = value;
+            else if (key == "seed")
+                seed = value;
+            else
+                throw std::invalid_argument("Unknown benchmark setting: " + key);
+        }
+    }
+};
+
+/**
+ * @class Benchmark
+ * @brief Measures the throughput and latency of the registry hot paths on synthetic data.
+ *
+ * The registry is filled with a generated roster, appointments spread over enough
+ * days to keep the calendars about half booked, and visit cards with a small set of
+ * repeated diagnoses. Every operation is then called a fixed number of times with
+ * random arguments and each call is timed individually, so the report shows the
+ * latency distribution as well as the throughput. Output printed by the registry is
+ * discarded while measuring.
+ *
+ * Built with -DREGISTRY_ALLOCATION_CHECKS, the benchmark also counts the allocations of
+ * every operation and the heap memory of each booked appointment, and holds them to
+ * fixed budgets; run() then fails when a change brings back per-call copies in a hot
+ * path, such as copying a patient's visit cards or a diagnosis.
+ */
+class Benchmark
+{
+public:
+    static constexpr double DEFAULT_APPOINTMENT_ALLOCATIONS = 5; ///< Allocations allowed per default appointment generated.
+    static constexpr double APPOINTMENT_BYTES = 96;              ///< Heap bytes allowed per booked appointment.
+
+private:
+    /**
+     * @class DiscardBuffer
+     * @brief A stream buffer that drops everything written to it without allocating.
+     */
+    class DiscardBuffer : public std::streambuf
+    {
+    protected:
+        std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+        int overflow(int character) override { return traits_type::not_eof(character); }
+    };
+
+    /**
+     * @struct Budget
+     * @brief A measured quantity and the largest value allowed for it.
+     */
+    struct Budget
+    {
+        string name;  ///< What was measured.
+        double value; ///< The measured value.
+        double limit; ///< The largest value allowed.
+    };
+
+    Registry &registry;
+    BenchmarkConfig _config;
+    std::mt19937 _random;
+
+    int32_t _firstDay = 0;   ///< First day holding generated appointments.
+    int32_t _dayCount = 1;   ///< Number of days holding generated appointments.
+    vector<Budget> _budgets; ///< The checked quantities, in the order they were measured.
+
+    /**
+     * @brief Draws a random number below a bound.
+     * @param bound The exclusive upper bound.
+     * @return A number in [0, bound).
+     */
+    size_t pick(size_t bound)
+    {
+        return std::uniform_int_distribution<size_t>(0, bound - 1)(_random);
+    }
+
+    /**
+     * @brief Draws a random day of the generated range.
+     * @return A timestamp at midnight of the day.
+     */
+    Timestamp pickDay()
+    {
+        return Timestamp(_firstDay + pick(_dayCount), 0);
+    }
+
+    /**
+     * @brief Draws a random slot of the generated range.
+     * @return The start of the slot.
+     */
+    Timestamp pickSlot()
+    {
+        return DefaultShift::slotStart(_firstDay + pick(_dayCount), pick(DefaultShift::SLOTS_PER_DAY));
+    }
+
+    /**
+     * @brief Fills the registry with the synthetic data set.
+     */
+    void generate()
+    {
+        for (size_t i = registry.getDoctors().size(); i < _config.doctors; ++i)
+            registry.addDoctor("Doctor " + std::to_string(i));
+
+        for (size_t i = registry.getPatients().size(); i < _config.patients; ++i)
+            registry.addPatient("Patient " + std::to_string(i), std::to_string(1 + i % 28) + ".0" + std::to_string(1 + i % 9) + "." + std::to_string(1940 + i % 80));
+
+        size_t slotsPerDay = registry.getDoctors().size() * DefaultShift::SLOTS_PER_DAY;
+        _firstDay = Timestamp::parse(getTodayDate()).day();
+        _dayCount = std::max<size_t>(1, 2 * _config.appointments / slotsPerDay + 1);
+
+        size_t booked = 0;
+#ifdef REGISTRY_ALLOCATION_CHECKS
+        int64_t bytesBefore = AllocationCounter::bytesInUse();
+#endif
+        for (size_t attempt = 0; attempt < 8 && booked < _config.appointments; ++attempt)
+        {
+            vector<ScheduleRequest> requests(_config.appointments - booked);
+            for (ScheduleRequest &request : requests)
+                request = ScheduleRequest{pickSlot(), static_cast<PersonId>(pick(registry.getDoctors().size())), static_cast<PersonId>(pick(registry.getPatients().size()))};
+
+            for (const ScheduleResult &result : registry.scheduleAppointments(requests))
+                booked += result.status == ScheduleStatus::SCHEDULED;
+        }
+#ifdef REGISTRY_ALLOCATION_CHECKS
+        if (booked > 0)
+            _budgets.push_back({"heap bytes per appointment", double(AllocationCounter::bytesInUse() - bytesBefore) / booked, APPOINTMENT_BYTES});
+#endif
+
+        for (size_t i = 0; i < _config.visitCards; ++i)
+            addVisitCard();
+    }
+
+    /**
+     * @brief Adds a visit card with random arguments and one of a few repeated diagnoses.
+     */
+    void addVisitCard()
+    {
+        static const char *const diagnoses[] = {"J06.9", "J11.1", "A09", "I10", "E11.9", "M54.5", "K21.9", "R51"};
+
+        registry.addHospitalVisitCard(registry.getDoctor(pick(registry.getDoctors().size())), registry.getPatient(pick(registry.getPatients().size())),
+                                      pickSlot(), diagnoses[pick(sizeof(diagnoses) / sizeof(diagnoses[0]))]);
+    }
+
+    /**
+     * @brief Times every call of an operation and prints a report line.
+     * @tparam Operation A callable taking the iteration number.
+     * @param out The stream receiving the report.
+     * @param name The name of the operation.
+     * @param allocationBudget The allocations allowed per call, checked when allocations are counted.
+     * @param operation The operation to measure.
+     */
+    template <typename Operation>
+    void measure(std::ostream &out, const string &name, [[maybe_unused]] double allocationBudget, Operation operation)
+    {
+        vector<uint64_t> samples(_config.iterations);
+
+#ifdef REGISTRY_ALLOCATION_CHECKS
+        uint64_t allocations = AllocationCounter::allocations();
+#endif
+        auto started = chrono::steady_clock::now();
+        for (size_t i = 0; i < _config.iterations; ++i)
+        {
+            auto begin = chrono::steady_clock::now();
+            operation(i);
+            samples[i] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+#ifdef REGISTRY_ALLOCATION_CHECKS
+        double perCall = samples.empty() ? 0 : double(AllocationCounter::allocations() - allocations) / samples.size();
+        _budgets.push_back({name, perCall, allocationBudget});
+#endif
+
+        sort(samples.begin(), samples.end());
+        auto percentile = [&samples](double fraction)
+        {
+            return samples.empty() ? 0 : samples[std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()))];
+        };
+
+        out << left << setw(26) << name << right
+            << setw(14) << std::fixed << std::setprecision(0) << (seconds > 0 ? samples.size() / seconds : 0)
+            << setw(11) << percentile(0.50) << setw(11) << percentile(0.90)
+            << setw(11) << percentile(0.99) << setw(12) << (samples.empty() ? 0 : samples.back()) << '\n';
+    }
+
+public:
+    /**
+     * @brief Constructs a benchmark for the given registry.
+     * @param reg Reference to a freshly constructed in-memory Registry object, so every run measures the same data set.
+     * @param config The size of the data set and the number of measured calls.
+     */
+    Benchmark(Registry &reg, const BenchmarkConfig &config) : registry(reg), _config(config), _random(config.seed) {}
+
+    /**
+     * @brief Generates the data set, measures every operation and prints the report.
+     * @param output The stream receiving the report; it may be cout.
+     * @return False if allocations are counted and an operation exceeded its budget, true otherwise.
+     * @throws std::logic_error If the registry is logging to storage or already holds appointments.
+     */
+    bool run(std::ostream &output)
+    {
+        if (registry.isLogging() || registry.getAppointments().size() > 0)
+            throw std::logic_error("The benchmark needs a fresh in-memory registry.");
+
+        std::ostream out(output.rdbuf());
+        DiscardBuffer discarded;
+        std::streambuf *console = cout.rdbuf(&discarded);
+
+#ifdef REGISTRY_ALLOCATION_CHECKS
+        uint64_t allocations = AllocationCounter::allocations();
+        registry.generateDefaultAppointments();
+        if (registry.getAppointments().size() > 0)
+            _budgets.push_back({"generateDefaultAppointments",
+                                double(AllocationCounter::allocations() - allocations) / registry.getAppointments().size(), DEFAULT_APPOINTMENT_ALLOCATIONS});
+#endif
+
+        auto started = chrono::steady_clock::now();
+        generate();
+        double generation = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        out << "Data set: " << registry.getDoctors().size() << " doctors, " << registry.getPatients().size() << " patients, "
+            << registry.getAppointments().size() << " appointments over " << _dayCount << " days, "
+            << _config.visitCards << " visit cards (generated in " << generation << " s)\n\n";
+        out << left << setw(26) << "operation" << right << setw(14) << "ops/s" << setw(11) << "p50 ns"
+            << setw(11) << "p90 ns" << setw(11) << "p99 ns" << setw(12) << "max ns" << '\n';
+
+        vector<string> names(_config.iterations);
+        for (string &name : names)
+            name = registry.getPatient(pick(registry.getPatients().size())).getName();
+        measure(out, "findPatientByName", 0, [&](size_t i)
+                { registry.findPatientByName(names[i]); });
+
+        vector<string> doctorNames(_config.iterations);
+        for (string &name : doctorNames)
+            name = registry.getDoctor(pick(registry.getDoctors().size())).getName();
+        measure(out, "findDoctorByName", 0, [&](size_t i)
+                { registry.findDoctorByName(doctorNames[i]); });
+
+        measure(out, "getDoctorName", 0, [&](size_t)
+                { registry.getDoctorName(registry.getDoctor(pick(registry.getDoctors().size())).getId()); });
+
+        measure(out, "getPatientName", 0, [&](size_t)
+                { registry.getPatientName(registry.getPatient(pick(registry.getPatients().size())).getId()); });
+
+        measure(out, "getAvailableTimes", 32, [&](size_t)
+                { registry.getAvailableTimes(pickDay()); });
+
+        measure(out, "getAvailableDoctors", 16, [&](size_t)
+                { registry.getAvailableDoctors(pickDay()); });
+
+        size_t before = registry.getAppointments().size();
+        measure(out, "scheduleAppointment", 5, [&](size_t)
+                { registry.scheduleAppointment(pickSlot(), registry.getDoctor(pick(registry.getDoctors().size())),
+                                               registry.getPatient(pick(registry.getPatients().size()))); });
+
+        vector<AppointmentHandle> handles;
+        for (size_t position = before; position < registry.getAppointments().size(); ++position)
+            handles.push_back(registry.getAppointments().handleAt(position));
+        std::shuffle(handles.begin(), handles.end(), _random);
+        handles.resize(std::min(handles.size(), _config.iterations));
+
+        BenchmarkConfig all = _config;
+        _config.iterations = handles.size();
+        measure(out, "cancelAppointment", 5, [&](size_t i)
+                { registry.cancelAppointment(handles[i]); });
+        _config = all;
+
+        measure(out, "addHospitalVisitCard", 1, [&](size_t)
+                { addVisitCard(); });
+
+        measure(out, "getVisitCardsForPatient", 0, [&](size_t)
+                { registry.getVisitCardsForPatient(registry.getPatient(pick(registry.getPatients().size()))); });
+
+        cout.rdbuf(console);
+
+        bool withinBudget = true;
+        if (!_budgets.empty())
+        {
+            out << '\n' << left << setw(30) << "allocation budget" << right << setw(14) << "measured" << setw(11) << "limit" << '\n';
+            for (const Budget &budget : _budgets)
+            {
+                withinBudget = withinBudget && budget.value <= budget.limit;
+                out << left << setw(30) << budget.name << right << std::fixed << std::setprecision(2) << setw(14) << budget.value
+                    << setw(11) << budget.limit << (budget.value <= budget.limit ? "" : "  over budget") << '\n';
+            }
+        }
+
+        out.flush();
+        return withinBudget;
+    }
+};
@@ -0,0 +1,527 @@
+/**
+ * @class ConcurrentRegistry
+ * @brief A thread-safe IRegistry that serves several front-desk terminals from one Registry.
+ * @inherit IRegistry
+ *
+ * Each doctor's slot calendar belongs to one of SHARD_COUNT shard locks chosen by doctor
+ * ID. Bookings and cancellations take the write locks of the shards of their doctors
+ * and the table lock only as readers, so bookings for doctors in different shards run
+ * at the same time; the appointment store and the patients' handle lists they share
+ * are guarded inside the registry by a store lock held for the few instructions of each
+ * insert or erase, and the masks of the free slot board are updated atomically. Changes of the other tables (patients, visit
+ * cards, the roster-wide default appointments and replicated entries) take the table
+ * lock as writers and wait for every booking in flight.
+ *
+ * Availability queries (free times, available doctors, capacities and free slot
+ * searches) take no lock of the registry at all: they read the registry's free slot
+ * board, whose masks bookings and cancellations update atomically, so a query never
+ * waits for a booking and a booking never waits for a query. Each doctor's day is seen
+ * either before or after a booking in flight. Other reads of one doctor, such as its
+ * schedule, hold the read lock of the doctor's shard. Reports read a ReportView.
+ *
+ * No lock of the registry is held while the log is written: changes only append to the
+ * write-ahead log, which has locks of its own, and the group commit with its fsync runs
+ * after the change released its locks. Compaction copies the tables under the write
+ * table lock, which costs a pass over the tables in memory, and writes and fsyncs the
+ * snapshot after releasing it.
+ *
+ * Locks are always taken shard locks first, in ascending shard order, and the table
+ * lock last, so no two operations can deadlock. Doctors are fixed after construction,
+ * and people live in deques, so the Doctor and Patient references handed out stay valid
+ * while patients are added; appointments are referred to by handles, which stay valid
+ * until the appointment is canceled.
+ *
+ * The containers returned by getDoctors(), getPatients(), getAppointments() and
+ * getVisitCardsForPatient() are not locked; iterate them only while no other thread
+ * changes the registry, and use the query methods otherwise.
+ *
+ * Every change bumps the version of the registry once it is applied. Long reports read
+ * a ReportView instead: reportView() builds one view per version, copying only the
+ * pages of the tables that changed since the previous view, and publishes it, so any
+ * number of reports can then scan it without a lock while bookings continue. A stale
+ * view is replaced, not changed, and is freed once the last report holding it is done.
+ *
+ * While it wraps the registry, the registry does not print its messages about changes,
+ * so threads making changes do not write over each other or over the server's output.
+ */
+class ConcurrentRegistry : public IRegistry
+{
+public:
+    static constexpr size_t SHARD_COUNT = 16; ///< Number of doctor calendar locks.
+
+private:
+    Registry &registry;
+    InputOutput interface;
+
+    std::array<std::shared_mutex, SHARD_COUNT> _doctorLocks; ///< Calendar locks, doctor ID modulo SHARD_COUNT.
+    std::shared_mutex _tableMutex;                           ///< Guards the tables shared by all doctors.
+
+    std::mutex _compactionMutex;             ///< Held by the thread that compacts the log.
+    std::atomic<uint64_t> _version{0};       ///< Number of changes made; bumped after each change, before its locks are released.
+    std::shared_ptr<const ReportView> _view; ///< The latest report view; loaded and replaced atomically.
+    std::mutex _viewMutex;                   ///< Serializes the building of report views.
+
+#ifdef REGISTRY_METRICS
+    using ReadLock = MeasuredLock<std::shared_lock<std::shared_mutex>, MetricLock::SHARED>;
+    using WriteLock = MeasuredLock<std::unique_lock<std::shared_mutex>, MetricLock::EXCLUSIVE>;
+#else
+    using ReadLock = std::shared_lock<std::shared_mutex>;
+    using WriteLock = std::unique_lock<std::shared_mutex>;
+#endif
+
+    /**
+     * @brief Gets the calendar lock of a doctor.
+     * @param doctorId The ID of the doctor.
+     * @return The shard lock guarding the doctor's calendar.
+     */
+    std::shared_mutex &doctorLock(PersonId doctorId)
+    {
+        return _doctorLocks[doctorId % SHARD_COUNT];
+    }
+
+    /**
+     * @brief Locks a set of calendar shards in ascending order.
+     * @tparam Lock ReadLock or WriteLock.
+     * @param shards Bit i is set if shard i is to be locked.
+     * @return The held locks.
+     */
+    template <typename Lock>
+    vector<Lock> lockShards(uint32_t shards)
+    {
+        vector<Lock> locks;
+        locks.reserve(SHARD_COUNT);
+
+        for (size_t shard = 0; shard < SHARD_COUNT; ++shard)
+        {
+            if (shards & (uint32_t(1) << shard))
+                locks.emplace_back(_doctorLocks[shard]);
+        }
+
+        return locks;
+    }
+
+    static constexpr uint32_t ALL_SHARDS = (uint32_t(1) << SHARD_COUNT) - 1; ///< Shard set holding every shard.
+
+    /**
+     * @brief Commits the log and compacts it when due, once a change released its locks.
+     *
+     * Only one thread compacts at a time; the others go on while it writes the snapshot.
+     */
+    void runStorageWork()
+    {
+        if (registry.commitDue())
+            registry.syncStorage();
+
+        if (!registry.compactionDue())
+            return;
+
+        std::unique_lock<std::mutex> compacting(_compactionMutex, std::try_to_lock);
+        if (!compacting.owns_lock())
+            return;
+
+        Registry::Checkpoint checkpoint;
+        {
+            WriteLock table(_tableMutex);
+            if (!registry.compactionDue())
+                return;
+            registry.captureSnapshot(checkpoint);
+        }
+        registry.writeSnapshot(checkpoint);
+    }
+
+public:
+    /**
+     * @brief Constructs a thread-safe view of a registry.
+     * @param reg Reference to the Registry object; it must not be used directly while shared.
+     */
+    ConcurrentRegistry(Registry &reg) : registry(reg)
+    {
+        registry.deferStorageWork(true);
+        registry.setQuiet(true);
+    }
+
+    ~ConcurrentRegistry()
+    {
+        registry.setQuiet(false);
+        registry.deferStorageWork(false);
+    }
+
+    bool patientExists(string_view name) override
+    {
+        ReadLock table(_tableMutex);
+        return registry.patientExists(name);
+    }
+
+    Doctor &findDoctorByName(string_view name) override
+    {
+        return registry.findDoctorByName(name);
+    }
+
+    Patient &findPatientByName(string_view name) override
+    {
+        ReadLock table(_tableMutex);
+        return registry.findPatientByName(name);
+    }
+
+    vector<PersonId> searchPatients(string_view query, size_t limit) override
+    {
+        ReadLock table(_tableMutex);
+        return registry.searchPatients(query, limit);
+    }
+
+    vector<PersonId> searchDoctors(string_view query, size_t limit) override
+    {
+        return registry.searchDoctors(query, limit);
+    }
+
+    Doctor &getDoctor(PersonId id) override { return registry.getDoctor(id); }
+
+    Patient &getPatient(PersonId id) override
+    {
+        ReadLock table(_tableMutex);
+        return registry.getPatient(id);
+    }
+
+    const string &getDoctorName(PersonId id) override { return registry.getDoctorName(id); }
+
+    const string &getPatientName(PersonId id) override
+    {
+        ReadLock table(_tableMutex);
+        return registry.getPatientName(id);
+    }
+
+    deque<Doctor> &getDoctors() override { return registry.getDoctors(); }
+
+    deque<Patient> &getPatients() override { return registry.getPatients(); }
+
+    AppointmentStore &getAppointments() override { return registry.getAppointments(); }
+
+    /**
+     * @brief Retrieves an appointment by handle.
+     * @param handle The handle of the appointment.
+     * @return A reference to the appointment, valid until the next booking or cancellation of any doctor.
+     * @throws std::out_of_range If the appointment no longer exists.
+     */
+    const Appointment &getAppointment(AppointmentHandle handle) override
+    {
+        ReadLock table(_tableMutex);
+        auto store = registry.readStore();
+        return registry.getAppointment(handle);
+    }
+
+    void scheduleDefaulteAppointmentsForDate(Timestamp date, int defaultTimeIndex, int doctorCount, int patientCount, int startIndex) override
+    {
+        {
+            auto shards = lockShards<WriteLock>(ALL_SHARDS);
+            WriteLock table(_tableMutex);
+            registry.scheduleDefaulteAppointmentsForDate(date, defaultTimeIndex, doctorCount, patientCount, startIndex);
+            _version++;
+        }
+        runStorageWork();
+    }
+
+    void generateDefaultAppointments() override
+    {
+        {
+            auto shards = lockShards<WriteLock>(ALL_SHARDS);
+            WriteLock table(_tableMutex);
+            registry.generateDefaultAppointments();
+            _version++;
+        }
+        runStorageWork();
+    }
+
+    bool cancelAppointment(Timestamp dateTime, string_view patientName, string_view doctorName) override
+    {
+        bool canceled;
+        {
+            WriteLock shard(doctorLock(registry.findDoctorByName(doctorName).getId()));
+            ReadLock table(_tableMutex);
+            canceled = registry.cancelAppointment(dateTime, patientName, doctorName);
+            _version++;
+        }
+        runStorageWork();
+        return canceled;
+    }
+
+    /**
+     * @brief Cancels an appointment by handle.
+     * @param handle The handle of the appointment to cancel.
+     * @throws std::out_of_range If the appointment no longer exists.
+     *
+     * The doctor is looked up first, so its calendar shard can be taken before the
+     * table lock; the handle is checked again once both are held.
+     */
+    void cancelAppointment(AppointmentHandle handle) override
+    {
+        PersonId doctorId = registry.copyAppointment(handle).getDoctorId();
+        {
+            WriteLock shard(doctorLock(doctorId));
+            ReadLock table(_tableMutex);
+            registry.cancelAppointment(handle);
+            _version++;
+        }
+        runStorageWork();
+    }
+
+    const vector<HospitalVisitCard> &getVisitCardsForPatient(const Patient &patient) override
+    {
+        ReadLock table(_tableMutex);
+        return registry.getVisitCardsForPatient(patient);
+    }
+
+    const HospitalVisitCard &addHospitalVisitCard(const Doctor &doctor, const Patient &patient, Timestamp dateTime, string_view diagnosis) override
+    {
+        const HospitalVisitCard *visitCard;
+        {
+            WriteLock table(_tableMutex);
+            visitCard = &registry.addHospitalVisitCard(doctor, patient, dateTime, diagnosis);
+            _version++;
+        }
+        runStorageWork();
+        return *visitCard;
+    }
+
+    Patient &addPatient(string_view name, string_view dateOfBirth) override
+    {
+        Patient *patient;
+        {
+            WriteLock table(_tableMutex);
+            patient = &registry.addPatient(name, dateOfBirth);
+            _version++;
+        }
+        runStorageWork();
+        return *patient;
+    }
+
+    vector<pair<Timestamp, PersonId>> getAvailableTimesForDoctor(Timestamp date, string_view doctorName) override
+    {
+        return registry.getAvailableTimesForDoctor(date, doctorName);
+    }
+
+    void scheduleAppointment(Timestamp dateTime, Doctor &doctor, Patient &patient) override
+    {
+        {
+            WriteLock shard(doctorLock(doctor.getId()));
+            ReadLock table(_tableMutex);
+            registry.scheduleAppointment(dateTime, doctor, patient);
+            _version++;
+        }
+        runStorageWork();
+    }
+
+    /**
+     * @brief Schedules many appointments in one pass.
+     * @param requests The bookings to make.
+     * @return One result per request, in the order of the requests.
+     *
+     * Only the shards of the doctors named in the requests are locked.
+     */
+    vector<ScheduleResult> scheduleAppointments(const vector<ScheduleRequest> &requests) override
+    {
+        uint32_t shards = 0;
+        for (const ScheduleRequest &request : requests)
+        {
+            shards |= uint32_t(1) << (request.doctorId % SHARD_COUNT);
+        }
+
+        vector<ScheduleResult> results;
+        {
+            auto locks = lockShards<WriteLock>(shards);
+            ReadLock table(_tableMutex);
+            results = registry.scheduleAppointments(requests);
+            _version++;
+        }
+        runStorageWork();
+        return results;
+    }
+
+    vector<string> getAvailableDoctors(Timestamp date) override
+    {
+        return registry.getAvailableDoctors(date);
+    }
+
+    vector<pair<PersonId, int>> getDoctorsByCapacity(Timestamp date) override
+    {
+        return registry.getDoctorsByCapacity(date);
+    }
+
+    vector<pair<Timestamp, PersonId>> getAvailableTimes(Timestamp date) override
+    {
+        return registry.getAvailableTimes(date);
+    }
+
+    bool findEarliestFreeSlot(Timestamp from, int days, FreeSlot &slot) override
+    {
+        return registry.findEarliestFreeSlot(from, days, slot);
+    }
+
+    bool findEarliestFreeSlot(Timestamp from, int days, string_view doctorName, FreeSlot &slot) override
+    {
+        return registry.findEarliestFreeSlot(from, days, doctorName, slot);
+    }
+
+    vector<PersonId> getDoctorsWithFreeSlots(Timestamp date, int days, int minimum) override
+    {
+        return registry.getDoctorsWithFreeSlots(date, days, minimum);
+    }
+
+    void showAppointments() override
+    {
+        showAppointments(0, SIZE_MAX);
+    }
+
+    /**
+     * @brief Displays a page of the scheduled appointments from the current report view.
+     * @param first The position of the first appointment to display.
+     * @param count The maximum number of appointments to display.
+     *
+     * The page is formatted and written without holding a lock.
+     */
+    void showAppointments(size_t first, size_t count) override
+    {
+        std::shared_ptr<const ReportView> view = reportView();
+
+        interface.headerMsg("Appointments");
+        for (const string &part : view->formatAppointments(first, count))
+            interface.printText(part);
+    }
+
+    /**
+     * @brief Gets a consistent read-only copy of the registry for reports.
+     * @return The view of the current version; it is built if the registry changed since the last one.
+     *
+     * Reports of an unchanged registry share one view, and only one thread builds a new
+     * view at a time. Building holds the read table lock and the store lock while the
+     * changed pages are copied, so bookings wait for that copy: a few pages after a few
+     * changes, and every page only for the first view.
+     */
+    std::shared_ptr<const ReportView> reportView()
+    {
+        std::shared_ptr<const ReportView> view = std::atomic_load(&_view);
+        if (view != nullptr && view->version() == _version.load())
+            return view;
+
+        std::lock_guard<std::mutex> building(_viewMutex);
+        ReadLock table(_tableMutex);
+        auto store = registry.readStore();
+
+        uint64_t version = _version.load();
+        view = std::atomic_load(&_view);
+        if (view == nullptr || view->version() != version)
+        {
+            view = std::make_shared<const ReportView>(registry, version, view.get());
+            std::atomic_store(&_view, view);
+        }
+        return view;
+    }
+
+    /**
+     * @brief Copies the visit cards of a patient.
+     * @param patient The patient whose visit cards are copied.
+     * @return The visit cards, safe to read while the registry changes.
+     */
+    vector<HospitalVisitCard> copyVisitCardsForPatient(const Patient &patient)
+    {
+        ReadLock table(_tableMutex);
+        return registry.getVisitCardsForPatient(patient);
+    }
+
+    /**
+     * @brief Retrieves a doctor's appointments on a date.
+     * @param doctor The doctor whose schedule is retrieved.
+     * @param date The date of the schedule.
+     * @return The appointment times paired with the patient names, in time order.
+     * @throws std::runtime_error If the archive partition of an archived date cannot be read.
+     */
+    vector<pair<Timestamp, string>> getDoctorSchedule(Doctor &doctor, Timestamp date)
+    {
+        ReadLock shard(doctorLock(doctor.getId()));
+        ReadLock table(_tableMutex);
+
+        return registry.getDoctorSchedule(doctor, date);
+    }
+
+    /**
+     * @brief Retrieves a doctor's appointments in a time range.
+     * @param doctor The doctor whose schedule is retrieved.
+     * @param from The earliest start of an appointment in the range.
+     * @param to The start after the range.
+     * @return The appointment times paired with the patient names, in time order.
+     * @throws std::runtime_error If an archive partition of the range cannot be read.
+     */
+    vector<pair<Timestamp, string>> getDoctorSchedule(Doctor &doctor, Timestamp from, Timestamp to)
+    {
+        ReadLock shard(doctorLock(doctor.getId()));
+        ReadLock table(_tableMutex);
+
+        return registry.getDoctorSchedule(doctor, from, to);
+    }
+
+    /**
+     * @brief Makes every logged mutation durable.
+     *
+     * Holds no lock of the registry, so changes go on while the batch is written.
+     */
+    void syncStorage()
+    {
+        registry.syncStorage();
+    }
+
+    /**
+     * @brief Sets the function that receives the log entries of every commit once they are durable.
+     * @param listener Called with the committed entries by the committing thread, in commit order, or empty to stop.
+     */
+    void setCommitListener(std::function<void(string_view)> listener)
+    {
+        registry.setCommitListener(std::move(listener));
+    }
+
+    /**
+     * @brief Encodes the registry as log entries with no change in between.
+     * @tparam Callback A callable taking the encoded entries as a const string reference.
+     * @param attach Called with the entries while the write table lock is still held,
+     *               so entries committed afterwards continue exactly where they end.
+     *
+     * Pending log entries are committed first, so they reach the commit listener
+     * instead of being encoded twice.
+     */
+    template <typename Callback>
+    void exportState(Callback attach)
+    {
+        WriteLock table(_tableMutex);
+        registry.syncStorage();
+
+        string state;
+        registry.encodeState(state);
+        attach(state);
+    }
+
+    /**
+     * @brief Applies log entries shipped from a primary registry, all at once.
+     * @param entries The entries in log order.
+     * @throws std::runtime_error If a roster entry names another doctor than this registry has.
+     */
+    void applyReplicated(const vector<LogRecord> &entries)
+    {
+        auto shards = lockShards<WriteLock>(ALL_SHARDS);
+        WriteLock table(_tableMutex);
+
+        for (const LogRecord &entry : entries)
+            registry.applyReplicated(entry);
+        _version++;
+    }
+
+#ifdef REGISTRY_METRICS
+    /**
+     * @brief Describes the operation histograms, lock waits, index sizes and table memory.
+     * @return The report, one "name{labels} value" metric per line.
+     */
+    vector<string> metricsReport()
+    {
+        vector<ReadLock> shards = lockShards<ReadLock>(ALL_SHARDS);
+        ReadLock table(_tableMutex);
+        return registry.metricsReport();
+    }
+#endif
+};
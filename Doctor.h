@@ -1,46 +1,155 @@
+/**
+ * @struct ScheduleRange
+ * @brief The handles of a doctor's appointments in a time range, in chronological order.
+ *
+ * The range views the doctor's index and stays valid until the doctor's appointments change.
+ */
+struct ScheduleRange
+{
+    vector<AppointmentHandle>::const_iterator first; ///< The first appointment in the range.
+    vector<AppointmentHandle>::const_iterator last;  ///< Past the last appointment in the range.
+
+    vector<AppointmentHandle>::const_iterator begin() const { return first; }
+    vector<AppointmentHandle>::const_iterator end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
 /**
  * @class Doctor
  * @brief Represents a doctor in the hospital system.
  *
  * This class inherits from the AbstractPerson class and represents a doctor
  * with functionalities such as checking availability, printing schedule details,
- * and canceling appointments.
+ * and canceling appointments. The doctor's appointment handles are kept sorted by
+ * time, with the start times in a parallel array, so a time range of the schedule is
+ * found with two binary searches.
  */
 class Doctor : public AbstractPerson
 {
 private:
     InputOutput interface; ///< InputOutput object for displaying information.
+    SlotCalendar calendar; ///< Booked slots of the doctor, one bit mask per day.
+    vector<Timestamp> times; ///< Start of each appointment, sorted and parallel to appointments.
 
 public:
     /**
      * @brief Constructs a Doctor object with the given name.
      * @param name The name of the doctor.
      */
-    Doctor(const string &name) : AbstractPerson(name) {}
+    Doctor(string_view name) : AbstractPerson(name) {}
 
     /**
      * @brief Checks if the doctor is available at the given date and time.
      * @param dateTime The date and time to check for availability.
      * @return True if the doctor is available, false otherwise.
      */
-    bool isAvailable(string &dateTime)
+    bool isAvailable(Timestamp dateTime)
+    {
+        int slot = calendar.slotIndex(dateTime.minuteOfDay());
+
+        return slot >= 0 && calendar.isFree(dateTime.day(), slot);
+    }
+
+    /**
+     * @brief Gets the slot calendar of the doctor.
+     * @return A constant reference to the doctor's calendar.
+     */
+    const SlotCalendar &getCalendar() const
+    {
+        return calendar;
+    }
+
+    /**
+     * @brief Sets the working hours and slot length of the doctor.
+     * @param shift The shift of the doctor.
+     * @throws std::logic_error If the doctor has booked slots already.
+     */
+    void setShift(const ShiftPattern &shift)
+    {
+        calendar.setShift(shift);
+    }
+
+    /**
+     * @brief Adds an appointment for the doctor and books the matching slot.
+     * @param handle The handle of the appointment in the registry store.
+     * @param dateTime The date and time of the appointment.
+     */
+    void addAppointment(AppointmentHandle handle, Timestamp dateTime)
     {
-        for (auto &app : appointments)
+        size_t position = std::upper_bound(times.begin(), times.end(), dateTime) - times.begin();
+        times.insert(times.begin() + position, dateTime);
+        appointments.insert(appointments.begin() + position, handle);
+
+        int slot = calendar.slotIndex(dateTime.minuteOfDay());
+        if (slot >= 0)
+            calendar.book(dateTime.day(), slot);
+    }
+
+    /**
+     * @brief Deletes an appointment of the doctor and frees the matching slot.
+     * @param handle The handle of the appointment to delete.
+     * @param dateTime The date and time of the appointment.
+     */
+    void deleteAppointment(AppointmentHandle handle, Timestamp dateTime)
+    {
+        size_t position = std::lower_bound(times.begin(), times.end(), dateTime) - times.begin();
+        while (position < times.size() && times[position] == dateTime && appointments[position] != handle)
+            ++position;
+
+        if (position < times.size() && times[position] == dateTime)
         {
-            if (app.first == dateTime)
-                return false;
+            times.erase(times.begin() + position);
+            appointments.erase(appointments.begin() + position);
         }
-        return true;
+
+        int slot = calendar.slotIndex(dateTime.minuteOfDay());
+        if (slot >= 0)
+            calendar.release(dateTime.day(), slot);
+    }
+
+    /**
+     * @brief Gets the doctor's appointments in a time range in O(log n).
+     * @param from The earliest start of an appointment in the range.
+     * @param to The start after the range; appointments starting at to are excluded.
+     * @return The handles of the appointments, in chronological order.
+     */
+    ScheduleRange getSchedule(Timestamp from, Timestamp to) const
+    {
+        size_t first = std::lower_bound(times.begin(), times.end(), from) - times.begin();
+        size_t last = std::max(first, size_t(std::lower_bound(times.begin(), times.end(), to) - times.begin()));
+
+        return ScheduleRange{appointments.begin() + first, appointments.begin() + last};
+    }
+
+    /**
+     * @brief Drops the appointments that start before a time from the index, keeping their slots booked.
+     * @param limit The earliest start of an appointment that is kept.
+     */
+    void dropAppointmentsBefore(Timestamp limit)
+    {
+        size_t count = std::lower_bound(times.begin(), times.end(), limit) - times.begin();
+
+        times.erase(times.begin(), times.begin() + count);
+        appointments.erase(appointments.begin(), appointments.begin() + count);
     }
 
     /**
      * @brief Prints the schedule details of the doctor.
+     * @param registry The registry used to resolve the doctor's appointments.
      *
      * This method prints the schedule details of the doctor, including the
-     * appointments booked.
+     * appointments booked, in chronological order.
      */
-    void printDetails() override
+    void printDetails(IRegistry &registry) override
     {
-        interface.printDoctorSchedule(appointments);
+        interface.printDivider();
+        for (auto &handle : appointments)
+        {
+            const Appointment &appointment = registry.getAppointment(handle);
+
+            interface.printScheduleEntry(appointment.getDateTime(), registry.getPatientName(appointment.getPatientId()));
+        }
+        interface.printDivider();
     }
 };
@@ -0,0 +1,163 @@
+/**
+ * @class FreeSlotBoard
+ * @brief The free slots of every doctor by day, readable while bookings change them.
+ *
+ * Each day with bookings has a row holding the free slot mask of every doctor as an
+ * atomic: a booking or cancellation flips one bit of one mask, and readers load the
+ * masks without taking a lock of the registry, so availability queries never wait for
+ * bookings and bookings never wait for them. A day without a row has every slot of
+ * every doctor free, and the free count of a doctor is the population count of its mask.
+ *
+ * Rows are only added, under the writer lock of the board, which is held for one hash
+ * insert; lookups take it as readers for one hash lookup. A row found once stays valid,
+ * since rows are never removed or moved while the board is shared. Doctors and shifts
+ * are only changed before the registry is shared, like the roster itself.
+ */
+class FreeSlotBoard
+{
+public:
+    using SlotMask = ShiftPattern::SlotMask; ///< One bit per slot of a day, bit 0 is the first slot.
+
+    /**
+     * @class Day
+     * @brief The free slots of every doctor on one day.
+     */
+    class Day
+    {
+    private:
+        const std::atomic<SlotMask> *_row; ///< The masks of the day, or null if nothing is booked on it.
+        const vector<SlotMask> *_fullDays; ///< The mask of a working day of every doctor.
+
+    public:
+        Day(const std::atomic<SlotMask> *row, const vector<SlotMask> &fullDays) : _row(row), _fullDays(&fullDays) {}
+
+        /**
+         * @brief Gets the free slots of a doctor.
+         * @param doctorId The ID of the doctor.
+         * @return A mask with a bit set for every free slot.
+         */
+        SlotMask freeMask(PersonId doctorId) const
+        {
+            return _row == nullptr ? (*_fullDays)[doctorId] : _row[doctorId].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Counts the free slots of a doctor.
+         * @param doctorId The ID of the doctor.
+         * @return The number of free slots.
+         */
+        int freeCount(PersonId doctorId) const
+        {
+            return __builtin_popcountll(freeMask(doctorId));
+        }
+    };
+
+private:
+    using Row = std::unique_ptr<std::atomic<SlotMask>[]>; ///< The mask of every doctor on one day.
+
+    unordered_map<int32_t, Row> _rows;    ///< Rows of the days with bookings, by day index.
+    vector<SlotMask> _fullDays;           ///< The mask of a working day of every doctor.
+    mutable std::shared_mutex _rowsMutex; ///< Guards the map of rows, not the masks in them.
+
+    /**
+     * @brief Gets the row of a day, adding it with every slot free if it is missing.
+     * @param day The day index.
+     * @return The masks of the day.
+     */
+    std::atomic<SlotMask> *rowFor(int32_t day)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(_rowsMutex);
+            auto it = _rows.find(day);
+            if (it != _rows.end())
+                return it->second.get();
+        }
+
+        std::lock_guard<std::shared_mutex> lock(_rowsMutex);
+        Row &row = _rows[day];
+        if (row == nullptr)
+        {
+            row.reset(new std::atomic<SlotMask>[_fullDays.size()]);
+            for (size_t id = 0; id < _fullDays.size(); ++id)
+                row[id].store(_fullDays[id], std::memory_order_relaxed);
+        }
+        return row.get();
+    }
+
+public:
+    /**
+     * @brief Adds a doctor whose slots are all free.
+     * @param fullDay The mask with a bit set for every slot of the doctor's working day.
+     */
+    void addDoctor(SlotMask fullDay)
+    {
+        std::lock_guard<std::shared_mutex> lock(_rowsMutex);
+        for (auto &day : _rows)
+        {
+            Row row(new std::atomic<SlotMask>[_fullDays.size() + 1]);
+            for (size_t id = 0; id < _fullDays.size(); ++id)
+                row[id].store(day.second[id].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            row[_fullDays.size()].store(fullDay, std::memory_order_relaxed);
+            day.second = std::move(row);
+        }
+        _fullDays.push_back(fullDay);
+    }
+
+    /**
+     * @brief Changes the working day of a doctor without bookings.
+     * @param doctorId The ID of the doctor.
+     * @param fullDay The mask with a bit set for every slot of the new working day.
+     */
+    void setShift(PersonId doctorId, SlotMask fullDay)
+    {
+        std::lock_guard<std::shared_mutex> lock(_rowsMutex);
+        _fullDays[doctorId] = fullDay;
+        for (auto &day : _rows)
+            day.second[doctorId].store(fullDay, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the free slots of a day.
+     * @param day The day index.
+     * @return The view of the day, valid for as long as the board.
+     */
+    Day day(int32_t day) const
+    {
+        std::shared_lock<std::shared_mutex> lock(_rowsMutex);
+        auto it = _rows.find(day);
+        return Day(it == _rows.end() ? nullptr : it->second.get(), _fullDays);
+    }
+
+    /**
+     * @brief Marks a slot of a doctor as booked.
+     * @param day The day index.
+     * @param doctorId The ID of the doctor.
+     * @param slot The slot index.
+     */
+    void book(int32_t day, PersonId doctorId, int slot)
+    {
+        rowFor(day)[doctorId].fetch_and(~(SlotMask(1) << slot), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Marks a slot of a doctor as free again.
+     * @param day The day index.
+     * @param doctorId The ID of the doctor.
+     * @param slot The slot index.
+     */
+    void release(int32_t day, PersonId doctorId, int slot)
+    {
+        rowFor(day)[doctorId].fetch_or(SlotMask(1) << slot, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Estimates the number of bytes allocated for the board.
+     * @return The size of the rows, their map and the working day masks.
+     */
+    size_t memoryUsage() const
+    {
+        std::shared_lock<std::shared_mutex> lock(_rowsMutex);
+        return _rows.size() * (_fullDays.size() * sizeof(SlotMask) + sizeof(pair<const int32_t, Row>) + 2 * sizeof(void *)) +
+               _fullDays.capacity() * sizeof(SlotMask);
+    }
+};
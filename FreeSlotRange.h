@@ -0,0 +1,217 @@
+/**
+ * @class FreeSlotRange
+ * @brief A lazily evaluated sequence of the free slots of a group of doctors over several days.
+ *
+ * Slots are produced in chronological order, and slots at the same time in ascending
+ * doctor order, straight from the doctors' slot masks: only the masks of the current
+ * day are held, so walking a few slots of a long range costs a few bit operations
+ * instead of building the list of every free slot. The masks are read from the free
+ * slot board as the range advances, so a walk runs while bookings change them and
+ * sees each doctor's day as it is when the walk reaches it.
+ *
+ * Slot indices only line up in time when every doctor of the group works the same
+ * shift. Groups mixing shifts are merged by time instead, one day at a time.
+ */
+class FreeSlotRange
+{
+private:
+    deque<Doctor> &_doctors;     ///< Roster the doctors belong to.
+    const FreeSlotBoard &_board; ///< Free slots of the doctors by day.
+    PersonId _firstDoctor;       ///< First doctor of the group.
+    PersonId _endDoctor;         ///< One past the last doctor of the group.
+    Timestamp _from;             ///< Earliest start of a produced slot.
+    int32_t _endDay;             ///< One past the last day of the range.
+    bool _uniform = true;        ///< Every doctor of the group works the same shift.
+
+public:
+    /**
+     * @class iterator
+     * @brief Walks the free slots of the range.
+     */
+    class iterator
+    {
+    private:
+        const FreeSlotRange *_range = nullptr; ///< The range being walked.
+        int32_t _day = 0;                      ///< The current day.
+        int _slot = 0;                         ///< The current slot of the day.
+        PersonId _doctor = 0;                  ///< The doctor owning the current slot.
+        vector<SlotCalendar::SlotMask> _masks; ///< Free slots of each doctor of the group on the current day.
+        SlotCalendar::SlotMask _pending = 0;   ///< Slots of the current day free for at least one doctor.
+        vector<FreeSlot> _mixed;               ///< Free slots of the current day in time order, for groups mixing shifts.
+        size_t _next = 0;                      ///< The current slot in _mixed.
+
+        /**
+         * @brief Gets the free slots of a doctor on the current day that start late enough.
+         * @param calendar The calendar of the doctor.
+         * @return The mask of the free slots.
+         */
+        SlotCalendar::SlotMask freeInRange(const FreeSlotBoard::Day &day, PersonId id) const
+        {
+            const SlotCalendar &calendar = _range->_doctors[id].getCalendar();
+            SlotCalendar::SlotMask mask = day.freeMask(id);
+            if (_day == _range->_from.day())
+                mask &= calendar.slotsFrom(calendar.firstSlotFrom(_range->_from.minuteOfDay()));
+            return mask;
+        }
+
+        /**
+         * @brief Lists the free slots of the current day of a group mixing shifts in time order.
+         */
+        void loadMixedDay()
+        {
+            _mixed.clear();
+            _next = 0;
+            FreeSlotBoard::Day day = _range->_board.day(_day);
+            for (PersonId id = _range->_firstDoctor; id < _range->_endDoctor; ++id)
+            {
+                const SlotCalendar &calendar = _range->_doctors[id].getCalendar();
+                for (SlotCalendar::SlotMask mask = freeInRange(day, id); mask != 0; mask &= mask - 1)
+                    _mixed.push_back(FreeSlot{calendar.slotStart(_day, __builtin_ctzll(mask)), id});
+            }
+
+            stable_sort(_mixed.begin(), _mixed.end(), [](const FreeSlot &a, const FreeSlot &b)
+                        { return a.dateTime < b.dateTime; });
+        }
+
+        /**
+         * @brief Loads the free masks of the current day, skipping days without free slots.
+         */
+        void loadDay()
+        {
+            for (; _day < _range->_endDay; ++_day)
+            {
+                if (!_range->_uniform)
+                {
+                    loadMixedDay();
+                    if (!_mixed.empty())
+                        return;
+                    continue;
+                }
+
+                _pending = 0;
+                FreeSlotBoard::Day day = _range->_board.day(_day);
+                for (PersonId id = _range->_firstDoctor; id < _range->_endDoctor; ++id)
+                {
+                    SlotCalendar::SlotMask mask = freeInRange(day, id);
+                    _masks[id - _range->_firstDoctor] = mask;
+                    _pending |= mask;
+                }
+
+                if (_pending != 0)
+                {
+                    _slot = __builtin_ctzll(_pending);
+                    _doctor = _range->_firstDoctor;
+                    seekDoctor();
+                    return;
+                }
+            }
+        }
+
+        /**
+         * @brief Moves to the first doctor at or after the current one that is free in the current slot.
+         * @return True if such a doctor exists, false otherwise.
+         */
+        bool seekDoctor()
+        {
+            SlotCalendar::SlotMask bit = SlotCalendar::SlotMask(1) << _slot;
+            for (; _doctor < _range->_endDoctor; ++_doctor)
+            {
+                if (_masks[_doctor - _range->_firstDoctor] & bit)
+                    return true;
+            }
+            return false;
+        }
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = FreeSlot;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const FreeSlot *;
+        using reference = FreeSlot;
+
+        iterator() = default;
+
+        /**
+         * @brief Constructs an iterator at the first free slot of a range.
+         * @param range The range to walk.
+         */
+        explicit iterator(const FreeSlotRange &range)
+            : _range(&range), _day(range._from.day()), _masks(range._endDoctor - range._firstDoctor)
+        {
+            loadDay();
+        }
+
+        FreeSlot operator*() const
+        {
+            if (!_range->_uniform)
+                return _mixed[_next];
+            return FreeSlot{_range->_doctors[_doctor].getCalendar().slotStart(_day, _slot), _doctor};
+        }
+
+        iterator &operator++()
+        {
+            if (!_range->_uniform)
+            {
+                if (++_next < _mixed.size())
+                    return *this;
+
+                ++_day;
+                loadDay();
+                return *this;
+            }
+
+            ++_doctor;
+            if (seekDoctor())
+                return *this;
+
+            _pending &= _pending - 1;
+            if (_pending != 0)
+            {
+                _slot = __builtin_ctzll(_pending);
+                _doctor = _range->_firstDoctor;
+                seekDoctor();
+                return *this;
+            }
+
+            ++_day;
+            loadDay();
+            return *this;
+        }
+
+        bool atEnd() const
+        {
+            return _range == nullptr || _day >= _range->_endDay;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            if (atEnd() || other.atEnd())
+                return atEnd() == other.atEnd();
+            if (!_range->_uniform)
+                return _day == other._day && _next == other._next;
+            return _day == other._day && _slot == other._slot && _doctor == other._doctor;
+        }
+
+        bool operator!=(const iterator &other) const { return !(*this == other); }
+    };
+
+    /**
+     * @brief Constructs the range of free slots of a group of doctors.
+     * @param doctors The roster the doctors belong to.
+     * @param board The free slots of the doctors by day.
+     * @param firstDoctor The ID of the first doctor of the group.
+     * @param endDoctor One past the ID of the last doctor of the group.
+     * @param from The earliest start of a produced slot.
+     * @param days The number of days in the range, starting with the day of from.
+     */
+    FreeSlotRange(deque<Doctor> &doctors, const FreeSlotBoard &board, PersonId firstDoctor, PersonId endDoctor, Timestamp from, int days)
+        : _doctors(doctors), _board(board), _firstDoctor(firstDoctor), _endDoctor(endDoctor), _from(from),
+          _endDay(from.day() + std::max(0, days))
+    {
+        for (PersonId id = firstDoctor; id + 1 < endDoctor && _uniform; ++id)
+            _uniform = doctors[id].getCalendar().getShift() == doctors[id + 1].getCalendar().getShift();
+    }
+
+    iterator begin() const { return iterator(*this); }
+    iterator end() const { return iterator(); }
+};
@@ -3,46 +3,61 @@
  * @brief Represents a hospital visit card containing details of a patient's visit.
  *
  * This class encapsulates information about a patient's visit to the hospital, including
- * the attending doctor, patient, date and time of the visit, and diagnosis given.
+ * the attending doctor, patient, date and time of the visit, and diagnosis given. The
+ * doctor and patient are stored as registry IDs and resolved through the registry.
  */
 class HospitalVisitCard
 {
 private:
-    Doctor _doctor;        ///< The doctor attending the patient.
-    Patient _patient;      ///< The patient receiving the visit.
-    InputOutput interface; ///< InputOutput object for displaying information.
-    string _dateTime;      ///< The date and time of the visit.
-    string _diagnosis;     ///< The diagnosis given to the patient.
+    PersonId _doctorId;     ///< The ID of the doctor attending the patient.
+    PersonId _patientId;    ///< The ID of the patient receiving the visit.
+    Timestamp _dateTime;    ///< The date and time of the visit.
+    string_view _diagnosis; ///< The diagnosis given to the patient, interned by the registry.
 
 public:
     /**
      * @brief Constructs a HospitalVisitCard object.
-     * @param doc The doctor attending the patient.
-     * @param pat The patient receiving the visit.
+     * @param doctorId The ID of the doctor attending the patient.
+     * @param patientId The ID of the patient receiving the visit.
      * @param date The date and time of the visit.
-     * @param diag The diagnosis given to the patient.
+     * @param diag The diagnosis given to the patient; the text must outlive the card.
      */
-    HospitalVisitCard(Doctor &doc, Patient &pat, string &date, string &diag)
-        : _doctor(doc), _patient(pat), _dateTime(date), _diagnosis(diag) {}
+    HospitalVisitCard(PersonId doctorId, PersonId patientId, Timestamp date, string_view diag)
+        : _doctorId(doctorId), _patientId(patientId), _dateTime(date), _diagnosis(diag) {}
 
     /**
-     * @brief Displays the visit card information.
-     *
-     * This method prints the details of the hospital visit card, including
-     * the patient's name, attending doctor's name, visit date and time,
-     * and the diagnosis given.
+     * @brief Gets the doctor who attended the patient.
+     * @return The registry ID of the doctor.
      */
-    void showVisitCard()
+    PersonId getDoctorId() const
     {
-        interface.printVisitCard(_patient.getName(), _doctor.getName(), _dateTime, _diagnosis);
+        return _doctorId;
     }
 
     /**
-     * @brief Gets the name of the patient associated with the visit card.
-     * @return The name of the patient.
+     * @brief Gets the patient associated with the visit card.
+     * @return The registry ID of the patient.
      */
-    string &getPatientName()
+    PersonId getPatientId() const
     {
-        return _patient.getName();
+        return _patientId;
+    }
+
+    /**
+     * @brief Gets the date and time of the visit.
+     * @return The date and time of the visit.
+     */
+    Timestamp getDateTime() const
+    {
+        return _dateTime;
+    }
+
+    /**
+     * @brief Gets the diagnosis given to the patient.
+     * @return A constant reference to the diagnosis.
+     */
+    string_view getDiagnosis() const
+    {
+        return _diagnosis;
     }
 };
@@ -1,3 +1,51 @@
+class Doctor;
+class Patient;
+class HospitalVisitCard;
+
+/**
+ * @struct ScheduleRequest
+ * @brief One booking of a bulk scheduling call.
+ */
+struct ScheduleRequest
+{
+    Timestamp dateTime; ///< The requested date and time.
+    PersonId doctorId;  ///< The ID of the doctor.
+    PersonId patientId; ///< The ID of the patient.
+};
+
+/**
+ * @enum ScheduleStatus
+ * @brief Outcome of one booking of a bulk scheduling call.
+ */
+enum class ScheduleStatus : uint8_t
+{
+    SCHEDULED,       ///< The appointment was booked.
+    SLOT_TAKEN,      ///< The doctor already has an appointment at that time.
+    CONFLICT,        ///< An earlier request of the same batch took the slot.
+    OFF_GRID,        ///< The time is outside the working hours or not on a slot boundary.
+    UNKNOWN_PERSON   ///< The doctor or patient ID does not exist.
+};
+
+/**
+ * @struct ScheduleResult
+ * @brief Result of one booking of a bulk scheduling call.
+ */
+struct ScheduleResult
+{
+    ScheduleStatus status = ScheduleStatus::UNKNOWN_PERSON; ///< The outcome of the request.
+    AppointmentHandle handle;                               ///< The booked appointment, if scheduled.
+};
+
+/**
+ * @struct FreeSlot
+ * @brief A free appointment slot of a doctor.
+ */
+struct FreeSlot
+{
+    Timestamp dateTime; ///< The start of the slot.
+    PersonId doctorId;  ///< The ID of the doctor.
+};
+
 /**
  * @interface IRegistry
  * @brief Interface for managing hospital appointments, doctors, patients, and visit cards.
@@ -13,63 +61,110 @@ public:
 
     /**
      * @brief Checks if a patient with the given name exists.
-     * @param name Reference to the name of the patient to check.
+     * @param name The name of the patient to check.
      * @return True if the patient exists, false otherwise.
      */
-    virtual bool patientExists(string &name) = 0;
+    virtual bool patientExists(string_view name) = 0;
 
     /**
      * @brief Retrieves a doctor by name.
-     * @param name Reference to the name of the doctor to find.
+     * @param name The name of the doctor to find.
      * @return A reference to the found Doctor object.
      * @throws std::runtime_error If no doctor with the given name is found.
      */
-    virtual Doctor &findDoctorByName(string &name) = 0;
+    virtual Doctor &findDoctorByName(string_view name) = 0;
 
     /**
      * @brief Retrieves a patient by name.
-     * @param name Reference to the name of the patient to find.
+     * @param name The name of the patient to find.
      * @return A reference to the found Patient object.
      * @throws std::runtime_error If no patient with the given name is found.
      */
-    virtual Patient &findPatientByName(string &name) = 0;
+    virtual Patient &findPatientByName(string_view name) = 0;
+
+    /**
+     * @brief Searches patients by date of birth, name prefix and similar spelling.
+     * @param query A date of birth, the beginning of a name or of a word of it, or a misspelled name.
+     * @param limit The maximum number of patients returned.
+     * @return The IDs of the matches: exact dates of birth first, then prefix matches, then similar names.
+     */
+    virtual vector<PersonId> searchPatients(string_view query, size_t limit) = 0;
+
+    /**
+     * @brief Searches doctors by name prefix and similar spelling.
+     * @param query The beginning of a name or of a word of it, or a misspelled name.
+     * @param limit The maximum number of doctors returned.
+     * @return The IDs of the matches: prefix matches first, then similar names.
+     */
+    virtual vector<PersonId> searchDoctors(string_view query, size_t limit) = 0;
+
+    /**
+     * @brief Retrieves a doctor by registry ID.
+     * @param id The ID of the doctor.
+     * @return A reference to the Doctor object.
+     */
+    virtual Doctor &getDoctor(PersonId id) = 0;
+
+    /**
+     * @brief Retrieves a patient by registry ID.
+     * @param id The ID of the patient.
+     * @return A reference to the Patient object.
+     */
+    virtual Patient &getPatient(PersonId id) = 0;
+
+    /**
+     * @brief Retrieves the name of a doctor by registry ID.
+     * @param id The ID of the doctor.
+     * @return A reference to the doctor's name.
+     */
+    virtual const string &getDoctorName(PersonId id) = 0;
+
+    /**
+     * @brief Retrieves the name of a patient by registry ID.
+     * @param id The ID of the patient.
+     * @return A reference to the patient's name.
+     */
+    virtual const string &getPatientName(PersonId id) = 0;
 
     /**
      * @brief Retrieves the list of all doctors.
-     * @return A reference to a vector containing all doctors.
+     * @return A reference to a deque containing all doctors.
+     *
+     * A deque is used so that references to doctors stay valid as the roster grows.
      */
-    virtual vector<Doctor> &getDoctors() = 0;
+    virtual deque<Doctor> &getDoctors() = 0;
 
     /**
      * @brief Retrieves the list of all patients.
-     * @return A reference to a vector containing all patients.
+     * @return A reference to a deque containing all patients.
+     *
+     * A deque is used so that references to patients stay valid as new patients are added.
      */
-    virtual vector<Patient> &getPatients() = 0;
+    virtual deque<Patient> &getPatients() = 0;
 
     /**
-     * @brief Retrieves the list of all appointments.
-     * @return A reference to a vector containing all appointments.
+     * @brief Retrieves the table of all appointments.
+     * @return A reference to the store containing all appointments.
      */
-    virtual vector<Appointment> &getAppointments() = 0;
+    virtual AppointmentStore &getAppointments() = 0;
 
     /**
-     * @brief Schedules default appointments for a given date.
-     * @param date Reference to the date string for scheduling appointments.
-     * @param defaultTimeIndex Index to start from predefined default times.
-     * @param doctorCount Number of doctors to schedule.
-     * @param patientCount Number of patients to schedule.
-     * @param startIndex Starting index for selecting doctors and patients.
+     * @brief Retrieves an appointment by handle.
+     * @param handle The handle of the appointment.
+     * @return A reference to the appointment.
+     * @throws std::out_of_range If the appointment no longer exists.
      */
+    virtual const Appointment &getAppointment(AppointmentHandle handle) = 0;
 
     /**
      * @brief Schedules default appointments for a given date.
-     * @param date Reference to the date string for scheduling appointments.
+     * @param date The date for scheduling appointments.
      * @param defaultTimeIndex Index to start from predefined default times.
      * @param doctorCount Number of doctors to schedule.
      * @param patientCount Number of patients to schedule.
      * @param startIndex Starting index for selecting doctors and patients.
      */
-    virtual void scheduleDefaulteAppointmentsForDate(string &date, int defaultTimeIndex, int doctorCount, int patientCount, int startIndex) = 0;
+    virtual void scheduleDefaulteAppointmentsForDate(Timestamp date, int defaultTimeIndex, int doctorCount, int patientCount, int startIndex) = 0;
 
     /**
      * @brief Generates default appointments for demonstration purposes.
@@ -78,69 +173,131 @@ public:
 
     /**
      * @brief Cancels a specific appointment.
-     * @param dateTime Reference to the date and time of the appointment to cancel.
-     * @param patientName Reference to the name of the patient associated with the appointment.
-     * @param doctorName Reference to the name of the doctor associated with the appointment.
+     * @param dateTime The date and time of the appointment to cancel.
+     * @param patientName The name of the patient associated with the appointment.
+     * @param doctorName The name of the doctor associated with the appointment.
+     * @return True if the appointment existed and was canceled, false otherwise.
+     */
+    virtual bool cancelAppointment(Timestamp dateTime, string_view patientName, string_view doctorName) = 0;
+
+    /**
+     * @brief Cancels an appointment by handle.
+     * @param handle The handle of the appointment to cancel.
+     * @throws std::out_of_range If the appointment no longer exists.
      */
-    virtual void cancelAppointment(string &dateTime, string &patientName, string &doctorName) = 0;
+    virtual void cancelAppointment(AppointmentHandle handle) = 0;
 
     /**
      * @brief Retrieves visit cards for a specific patient.
      * @param patient Reference to the patient whose visit cards are to be retrieved.
-     * @return A vector of HospitalVisitCard objects for the specified patient.
+     * @return A constant reference to the patient's visit cards, in the order they were added.
+     *
+     * The returned reference is a view into the registry and stays valid until the next visit card is added.
      */
-    virtual vector<HospitalVisitCard> getVisitCardsForPatient(Patient &patient) = 0;
+    virtual const vector<HospitalVisitCard> &getVisitCardsForPatient(const Patient &patient) = 0;
 
     /**
      * @brief Adds a new hospital visit card for a patient.
      * @param doctor Reference to the attending doctor.
      * @param patient Reference to the patient receiving the visit card.
-     * @param dateTime Reference to the date and time of the visit.
-     * @param diagnosis Reference to the diagnosis given to the patient.
-     * @return The newly created HospitalVisitCard object.
+     * @param dateTime The date and time of the visit.
+     * @param diagnosis The diagnosis given to the patient.
+     * @return A reference to the stored visit card, valid until the patient's next visit card is added.
      */
-    virtual HospitalVisitCard addHospitalVisitCard(Doctor &doctor, Patient &patient, string &dateTime, string &diagnosis) = 0;
+    virtual const HospitalVisitCard &addHospitalVisitCard(const Doctor &doctor, const Patient &patient, Timestamp dateTime, string_view diagnosis) = 0;
 
     /**
      * @brief Adds a new patient to the registry.
-     * @param name Reference to the name of the new patient.
-     * @param age Reference to the age of the new patient.
-     * @return The newly added Patient object.
+     * @param name The name of the new patient.
+     * @param dateOfBirth The date of birth of the new patient.
+     * @return A reference to the stored patient, or to the existing one with the same name.
      */
-    virtual Patient addPatient(string &name, string &age) = 0;
+    virtual Patient &addPatient(string_view name, string_view dateOfBirth) = 0;
 
     /**
      * @brief Retrieves available appointment times for a specific doctor on a given date.
-     * @param date Reference to the date for which to retrieve available times.
-     * @param doctorName Reference to the name of the doctor.
-     * @return A vector of pairs representing available times and the corresponding doctor's name.
+     * @param date The date for which to retrieve available times.
+     * @param doctorName The name of the doctor.
+     * @return The start of each free slot paired with the doctor's ID.
      */
-    virtual vector<pair<string, string>> getAvailableTimesForDoctor(string &date, string &doctorName) = 0;
+    virtual vector<pair<Timestamp, PersonId>> getAvailableTimesForDoctor(Timestamp date, string_view doctorName) = 0;
 
     /**
      * @brief Schedules an appointment for a specific date and time.
-     * @param dateTime Reference to the date and time of the appointment.
+     * @param dateTime The date and time of the appointment.
      * @param doctor Reference to the doctor who will conduct the appointment.
      * @param patient Reference to the patient who will attend the appointment.
      */
-    virtual void scheduleAppointment(string &dateTime, Doctor &doctor, Patient &patient) = 0;
+    virtual void scheduleAppointment(Timestamp dateTime, Doctor &doctor, Patient &patient) = 0;
+
+    /**
+     * @brief Schedules many appointments in one pass.
+     * @param requests The bookings to make, applied as if in order.
+     * @return One result per request, in the order of the requests.
+     *
+     * Nothing is printed; callers report the results themselves.
+     */
+    virtual vector<ScheduleResult> scheduleAppointments(const vector<ScheduleRequest> &requests) = 0;
 
     /**
      * @brief Retrieves the names of doctors available on a specific date.
-     * @param date Reference to the date for which to retrieve available doctors.
+     * @param date The date for which to retrieve available doctors.
      * @return A vector containing the names of available doctors.
      */
-    virtual vector<string> getAvailableDoctors(string &date) = 0;
+    virtual vector<string> getAvailableDoctors(Timestamp date) = 0;
+
+    /**
+     * @brief Retrieves the doctors with free slots on a date, most free slots first.
+     * @param date The date to check.
+     * @return The ID and number of free slots of each doctor with at least one free slot; ties keep roster order.
+     */
+    virtual vector<pair<PersonId, int>> getDoctorsByCapacity(Timestamp date) = 0;
 
     /**
      * @brief Retrieves available appointment times on a given date.
-     * @param date Reference to the date for which to retrieve available times.
-     * @return A vector of pairs representing available times and the corresponding doctor's name.
+     * @param date The date for which to retrieve available times.
+     * @return The start of each free slot paired with the ID of its doctor.
+     */
+    virtual vector<pair<Timestamp, PersonId>> getAvailableTimes(Timestamp date) = 0;
+
+    /**
+     * @brief Finds the earliest free slot of any doctor in a range of days.
+     * @param from The earliest acceptable start of the slot.
+     * @param days The number of days to search, starting with the day of from.
+     * @param slot Receives the earliest free slot; ties go to the lowest doctor ID.
+     * @return True if a free slot was found, false otherwise.
      */
-    virtual vector<pair<string, string>> getAvailableTimes(string &date) = 0;
+    virtual bool findEarliestFreeSlot(Timestamp from, int days, FreeSlot &slot) = 0;
+
+    /**
+     * @brief Finds the earliest free slot of one doctor in a range of days.
+     * @param from The earliest acceptable start of the slot.
+     * @param days The number of days to search, starting with the day of from.
+     * @param doctorName The name of the doctor.
+     * @param slot Receives the earliest free slot.
+     * @return True if a free slot was found, false otherwise.
+     * @throws std::runtime_error If the doctor with the given name is not found.
+     */
+    virtual bool findEarliestFreeSlot(Timestamp from, int days, string_view doctorName, FreeSlot &slot) = 0;
+
+    /**
+     * @brief Retrieves the doctors with at least a given number of free slots in a range of days.
+     * @param date The first day of the range.
+     * @param days The number of days in the range.
+     * @param minimum The number of free slots a doctor needs.
+     * @return The IDs of the matching doctors, in roster order.
+     */
+    virtual vector<PersonId> getDoctorsWithFreeSlots(Timestamp date, int days, int minimum) = 0;
 
     /**
      * @brief Displays all scheduled appointments.
      */
     virtual void showAppointments() = 0;
+
+    /**
+     * @brief Displays a page of the scheduled appointments.
+     * @param first The position of the first appointment to display.
+     * @param count The maximum number of appointments to display.
+     */
+    virtual void showAppointments(size_t first, size_t count) = 0;
 };
\ No newline at end of file
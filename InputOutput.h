@@ -7,22 +7,43 @@ using std::endl;
  * @brief Handles input and output operations for the Appointment Scheduling System.
  *
  * This class provides methods for displaying menus, headers, messages, and collecting user input.
+ * Output goes to cout without flushing line by line; the stream is flushed before every
+ * prompt, so listings are written in large chunks and the user still sees everything
+ * before typing.
  */
 class InputOutput
 {
+private:
+    /**
+     * @brief Gets the buffer that listings are formatted into before they are written.
+     * @return The emptied buffer of the calling thread.
+     *
+     * The buffer is shared by every InputOutput of a thread rather than held by each one,
+     * so the people that embed an InputOutput do not grow by it, and it keeps its capacity
+     * from one listing to the next.
+     */
+    static string &scratchText()
+    {
+        static thread_local string text;
+        text.clear();
+        return text;
+    }
+
 public:
+    static constexpr size_t WRITE_CHUNK = 64 * 1024; ///< Formatted text written to cout at a time by long listings.
+
     /**
      * @brief Displays the role selection menu.
      */
     void optionMenu()
     {
-        cout << "=========================================" << endl;
-        cout << "Please, select your role" << endl;
-        cout << "(1) Role: Patient" << endl;
-        cout << "(2) Role: Registrator" << endl;
-        cout << "(3) Exit" << endl;
-        cout << "=========================================" << endl;
-        cout << endl;
+        cout << "=========================================" << '\n';
+        cout << "Please, select your role" << '\n';
+        cout << "(1) Role: Patient" << '\n';
+        cout << "(2) Role: Registrator" << '\n';
+        cout << "(3) Exit" << '\n';
+        cout << "=========================================" << '\n';
+        cout << '\n';
     }
 
     /**
@@ -30,16 +51,19 @@ public:
      */
     void optionMenuForRegistrator()
     {
-        cout << endl;
-        cout << "=========================================" << endl;
-        cout << "(1) Schedule appointment" << endl;
-        cout << "(2) Cancel appointment" << endl;
-        cout << "(3) Add visit card for appointment" << endl;
-        cout << "(4) Get visit cards for a patient" << endl;
-        cout << "(5) Check doctor's schedule" << endl;
-        cout << "(6) Exit" << endl;
-        cout << "=========================================" << endl;
-        cout << endl;
+        cout << '\n';
+        cout << "=========================================" << '\n';
+        cout << "(1) Schedule appointment" << '\n';
+        cout << "(2) Cancel appointment" << '\n';
+        cout << "(3) Add visit card for appointment" << '\n';
+        cout << "(4) Get visit cards for a patient" << '\n';
+        cout << "(5) Check doctor's schedule" << '\n';
+        cout << "(6) Exit" << '\n';
+#ifdef REGISTRY_METRICS
+        cout << "(7) Show metrics" << '\n';
+#endif
+        cout << "=========================================" << '\n';
+        cout << '\n';
     }
 
     /**
@@ -47,14 +71,14 @@ public:
      */
     void optionMenuForPatient()
     {
-        cout << endl;
-        cout << "=========================================" << endl;
-        cout << "(1) Schedule appointment" << endl;
-        cout << "(2) Cancel appointment" << endl;
-        cout << "(3) Check existing appointments" << endl;
-        cout << "(4) Exit" << endl;
-        cout << "=========================================" << endl;
-        cout << endl;
+        cout << '\n';
+        cout << "=========================================" << '\n';
+        cout << "(1) Schedule appointment" << '\n';
+        cout << "(2) Cancel appointment" << '\n';
+        cout << "(3) Check existing appointments" << '\n';
+        cout << "(4) Exit" << '\n';
+        cout << "=========================================" << '\n';
+        cout << '\n';
     }
 
     /**
@@ -64,40 +88,41 @@ public:
      * @param dateTime The date and time of the visit.
      * @param diagnosis The diagnosis given to the patient.
      */
-    void printVisitCard(string patientName, string doctorName, string dateTime, string diagnosis)
+    void printVisitCard(const string &patientName, const string &doctorName, Timestamp dateTime, std::string_view diagnosis)
     {
-        cout << "Patient Name: " << patientName << endl;
-        cout << "Doctor Name: " << doctorName << endl;
-        cout << "Date & Time: " << dateTime << endl;
-        cout << "Diagnosis: " << diagnosis << endl;
-        cout << "--------------------------------------" << endl;
-        cout << endl;
+        cout << "Patient Name: " << patientName << '\n';
+        cout << "Doctor Name: " << doctorName << '\n';
+        cout << "Date & Time: " << dateTime << '\n';
+        cout << "Diagnosis: " << diagnosis << '\n';
+        cout << "--------------------------------------" << '\n';
+        cout << '\n';
     }
 
     /**
      * @brief Prints a message to the console.
      * @param msg The message to be printed.
      */
-    void headerMsg(string msg)
+    void headerMsg(const string &msg)
     {
-        cout << endl;
-        cout << "=========================================" << endl;
-        cout << msg << endl;
-        cout << "=========================================" << endl;
-        cout << endl;
+        cout << '\n';
+        cout << "=========================================" << '\n';
+        cout << msg << '\n';
+        cout << "=========================================" << '\n';
+        cout << '\n';
     }
 
     /**
      * @brief Shows a single appointment.
      * @param index The index of the appointment.
-     * @param appointment A pair containing the date and time of the appointment and the doctor's name.
+     * @param dateTime The date and time of the appointment.
+     * @param doctorName The name of the doctor.
      */
-    void showAppointment(int index, pair<string, pair<string, string>> appointment)
+    void showAppointment(int index, Timestamp dateTime, const string &doctorName)
     {
         cout << "(" << index << ") "
-             << "-----------------------------" << endl;
-        cout << "    Date & Time: " << appointment.first << endl;
-        cout << "    Doctor: " << appointment.second.second << endl;
+             << "-----------------------------" << '\n';
+        cout << "    Date & Time: " << dateTime << '\n';
+        cout << "    Doctor: " << doctorName << '\n';
     }
 
     /**
@@ -107,7 +132,7 @@ public:
     int getUserChoice()
     {
         int choice;
-        cout << "Enter your choice: ";
+        cout << "Enter your choice: " << std::flush;
         cin >> choice;
         return choice;
     }
@@ -117,48 +142,61 @@ public:
      * @param text The message to be printed.
      * @return The user's input.
      */
-    string getInfo(string text)
+    string getInfo(const string &text)
     {
         string data;
-        cout << text;
+        cout << text << std::flush;
         cin >> data;
         return data;
     }
 
     /**
-     * @brief Displays the schedule of a doctor.
-     * @param appointments A vector of pairs containing appointment information.
-     *
-     * This method prints the schedule of a doctor by iterating through the vector of appointments
-     * and displaying each appointment's date and time along with the patient's name.
+     * @brief Prints a divider line around a doctor's schedule.
      */
-    void printDoctorSchedule(vector<pair<string, pair<string, string>>> &appointments)
+    void printDivider()
     {
-        cout << "=========================================" << endl;
-        for (auto &appointment : appointments)
-        {
-            cout << "Date & Time: " << appointment.first << ", Patient: " << appointment.second.first << endl;
-        }
-        cout << "=========================================" << endl;
+        cout << "=========================================" << '\n';
+    }
+
+    /**
+     * @brief Prints a single entry of a doctor's schedule.
+     * @param dateTime The date and time of the appointment.
+     * @param patientName The name of the patient.
+     */
+    void printScheduleEntry(Timestamp dateTime, const string &patientName)
+    {
+        cout << "Date & Time: " << dateTime << ", Patient: " << patientName << '\n';
     }
 
     /**
      * @brief Retrieves a valid choice from the user.
-     * @tparam T The type of elements in the vector.
-     * @param vec The vector of choices.
+     * @tparam Container The container type holding the choices.
+     * @param vec The container of choices.
      * @return The user's valid choice index.
      *
      * This method prompts the user for a choice and validates it against the size of the vector.
      * If the choice is invalid, it displays a message and returns -1; otherwise, it returns the
      * index of the valid choice.
      */
-    template <typename T>
-    int getValidChoice(vector<T> &vec)
+    template <typename Container>
+    int getValidChoice(Container &vec)
+    {
+        return validateChoice(getUserChoice(), vec);
+    }
+
+    /**
+     * @brief Validates a choice the user already entered.
+     * @tparam Container The container type holding the choices.
+     * @param choice The user's choice, counting from 1.
+     * @param vec The container of choices.
+     * @return The choice if it is valid; otherwise -1, after telling the user.
+     */
+    template <typename Container>
+    int validateChoice(int choice, Container &vec)
     {
-        int choice = getUserChoice();
-        if (choice < 1 || choice > vec.size())
+        if (choice < 1 || static_cast<size_t>(choice) > vec.size())
         {
-            cout << endl;
+            cout << '\n';
             printMsg("\n Invalid choice. Please try again.");
 
             return -1;
@@ -176,55 +214,89 @@ public:
      * This method displays the information of an appointment, including its index, date and time,
      * the name of the doctor, and the name of the patient.
      */
-    void showAppointment(int index, string date, string doctorName, string patientName)
+    void showAppointment(int index, Timestamp date, const string &doctorName, const string &patientName)
     {
-        cout << "(" << index << ") "
-             << "-----------------------------" << endl;
-        cout << "     Date & Time: " << date << endl;
-        cout << "     Doctor: " << doctorName << endl;
-        cout << "     Patient: " << patientName << endl;
-        cout << endl;
+        string &text = scratchText();
+        formatAppointment(text, index, date, doctorName, patientName);
+        printText(text);
+    }
+
+    /**
+     * @brief Formats a single appointment with patient details the way showAppointment prints it.
+     * @param out The text to append to.
+     * @param index The index of the appointment.
+     * @param date The date and time of the appointment.
+     * @param doctorName The name of the doctor.
+     * @param patientName The name of the patient.
+     */
+    static void formatAppointment(string &out, int index, Timestamp date, const string &doctorName, const string &patientName)
+    {
+        char buffer[24];
+        out += "(" + std::to_string(index) + ") -----------------------------\n";
+        out += "     Date & Time: ";
+        out.append(buffer, date.format(buffer));
+        out += "\n     Doctor: " + doctorName + "\n     Patient: " + patientName + "\n\n";
+    }
+
+    /**
+     * @brief Prints preformatted text.
+     * @param text The text to print.
+     */
+    void printText(const string &text)
+    {
+        cout.write(text.data(), text.size());
     }
 
     /**
      * @brief Displays available appointment times.
+     * @tparam Id The type of the doctor ID paired with each time.
      * @param availableTimes A vector of pairs containing available appointment times and corresponding doctors.
      *
      * This method displays the available appointment times along with their indices for selection.
      */
-    void showAvailableTimes(vector<pair<string, string>> &availableTimes)
+    template <typename Id>
+    void showAvailableTimes(const vector<pair<Timestamp, Id>> &availableTimes)
     {
+        char buffer[24];
         int index = 1;
+
+        string &text = scratchText();
         for (auto &timeDoctorPair : availableTimes)
         {
-            cout << "Time: " << timeDoctorPair.first << "  (" << index << ")" << endl;
+            text += "Time: ";
+            text.append(buffer, timeDoctorPair.first.format(buffer));
+            text += "  (" + std::to_string(index) + ")\n";
             index++;
         }
-        cout << endl;
+        text += '\n';
+
+        printText(text);
     }
 
     /**
      * @brief Displays information about people.
-     * @tparam T The type of elements in the vector.
-     * @param items The vector containing information about people.
+     * @tparam Container The container type holding the people.
+     * @param items The container holding information about people.
      *
-     * This method displays information about people stored in the vector, including their names.
+     * This method displays information about people stored in the container, including their names.
      */
-    template <typename T>
-    void showPeople(vector<T> &items)
+    template <typename Container>
+    void showPeople(Container &items)
     {
+        string &text = scratchText();
         for (size_t i = 0; i < items.size(); ++i)
         {
-            cout << "(" << i + 1 << ") " << items[i].getName() << endl;
+            text += "(" + std::to_string(i + 1) + ") " + items[i].getName() + '\n';
         }
-    };
+        printText(text);
+    }
 
     /**
      * @brief Prints a message to the console.
      * @param prompt The message to be printed.
      */
-    void printMsg(string prompt)
+    void printMsg(const string &prompt)
     {
-        cout << prompt << endl;
+        cout << prompt << '\n';
     }
 };
@@ -12,6 +12,10 @@ private:
     Registry &registry;
     InputOutput &interface;
 
+    static constexpr size_t APPOINTMENTS_PER_PAGE = 50; ///< Appointments listed before the user is asked to page on.
+    static constexpr size_t PATIENTS_LISTED = 50;       ///< Largest roster listed in full; larger ones are searched.
+    static constexpr size_t SEARCH_RESULTS = 10;        ///< Matches shown for a patient search.
+
     /**
      * @enum UserChoice
      * @brief Enumerates the possible choices a user can make in the registrator menu.
@@ -23,7 +27,10 @@ private:
         ADD_VISIT_CARD,           ///< Option to add a new visit card.
         GET_VISIT_CARD,           ///< Option to retrieve a visit card.
         DOCTOR_SCHEDULE,          ///< Option to check a doctor's schedule.
-        RETURN_TO_MAIN_MENU       ///< Option to return to the main menu.
+        RETURN_TO_MAIN_MENU,      ///< Option to return to the main menu.
+#ifdef REGISTRY_METRICS
+        SHOW_METRICS              ///< Option to dump the registry metrics.
+#endif
     };
 
 public:
@@ -36,18 +43,30 @@ public:
 
     /**
      * Retrieves an appointment selected by the user from the registry.
-     * Displays the list of appointments to the user and prompts for a selection.
-     * @return The appointment chosen by the user.
+     * Displays the list of appointments to the user page by page and prompts for a selection.
+     * @return The handle of the appointment chosen by the user.
      */
-    Appointment getAppointmentFromUser()
+    AppointmentHandle getAppointmentFromUser()
     {
-        registry.showAppointments();
+        AppointmentStore &appointments = registry.getAppointments();
+
+        for (size_t first = 0;; first += APPOINTMENTS_PER_PAGE)
+        {
+            registry.showAppointments(first, APPOINTMENTS_PER_PAGE);
 
-        vector<Appointment> appointments = registry.getAppointments();
+            if (first + APPOINTMENTS_PER_PAGE >= appointments.size())
+                break;
+
+            interface.printMsg("Enter 0 to see the next page, or the number of an appointment.");
+
+            int choice = interface.getUserChoice();
+            if (choice != 0)
+                return appointments.handleAt(interface.validateChoice(choice, appointments) - 1);
+        }
 
         int choice = interface.getValidChoice(appointments);
 
-        return registry.getByIndex(choice - 1, appointments);
+        return appointments.handleAt(choice - 1);
     }
 
     /**
@@ -55,15 +74,7 @@ public:
      */
     void cancelAppointmentMenu()
     {
-        auto appointment = getAppointmentFromUser();
-
-        string patientName = appointment.getPatient().getName();
-        string doctorName = appointment.getDoctor().getName();
-        string dateTime = appointment.getDateTime();
-
-        Doctor doctor = registry.findDoctorByName(doctorName);
-
-        registry.cancelAppointment(dateTime, patientName, doctorName);
+        registry.cancelAppointment(getAppointmentFromUser());
     }
 
     /**
@@ -74,37 +85,31 @@ public:
     {
         int choice;
 
-        Patient registratedPatient = registry.findPatientByName(patient->getName());
+        patient->printDetails(registry);
 
-        registratedPatient.printDetails();
-
-        if (registratedPatient.getAppointments().size() == 0)
+        if (patient->getAppointments().size() == 0)
             return;
 
         cout << endl;
         choice = interface.getUserChoice();
 
-        vector<pair<string, pair<string, string>>> appoinments = registratedPatient.getAppointments();
-
-        string doctorName = appoinments[choice - 1].second.second;
-
-        string dateTime = appoinments[choice - 1].first;
+        AppointmentHandle handle = registry.getByIndex(choice - 1, patient->getAppointments());
 
-        registry.cancelAppointment(dateTime, patient->getName(), doctorName);
+        registry.cancelAppointment(handle);
     }
 
     /**
      * @brief Prompts the user for a valid date input.
-     * @return string A valid date string in the format YYYY-MM-DD.
+     * @return Timestamp A valid date entered in the format YYYY-MM-DD.
      */
-    string getValidDateFromUser()
+    Timestamp getValidDateFromUser()
     {
         string date;
         do
         {
             date = interface.getInfo("Enter date (YYYY-MM-DD): ");
         } while (!isValidDate(date));
-        return date;
+        return Timestamp::parse(date);
     }
 
     /**
@@ -149,9 +154,9 @@ public:
             return;
         }
 
-        string date = getValidDateFromUser();
+        Timestamp date = getValidDateFromUser();
 
-        vector<pair<string, string>> availableTimes = registry.getAvailableTimesForDoctor(date, doctor->getName());
+        vector<pair<Timestamp, PersonId>> availableTimes = registry.getAvailableTimesForDoctor(date, doctor->getName());
 
         displayAvailableTimes(availableTimes, doctor->getName(), date);
 
@@ -160,7 +165,7 @@ public:
         if (choice == -1)
             return;
 
-        string selectedTime = availableTimes[choice - 1].first;
+        Timestamp selectedTime = availableTimes[choice - 1].first;
 
         registry.scheduleAppointment(selectedTime, *doctor, *patient);
     }
@@ -171,30 +176,28 @@ public:
      */
     void showAppointmentsForPatient(Patient *patient)
     {
-        Patient registeredPatient = registry.findPatientByName(patient->getName());
-
-        registeredPatient.printDetails();
+        patient->printDetails(registry);
     }
 
     /**
      * @brief Displays available appointment times for a specific doctor and date.
-     * @param availableTimes A vector of available times and corresponding doctor names.
+     * @param availableTimes A vector of available times and corresponding doctor IDs.
      * @param doctorName The name of the doctor.
      * @param date The date for which to display available times.
      */
     void
-    displayAvailableTimes(vector<pair<string, string>> &availableTimes, string &doctorName, string &date)
+    displayAvailableTimes(const vector<pair<Timestamp, PersonId>> &availableTimes, const string &doctorName, Timestamp date)
     {
-        interface.headerMsg("Available Times for Dr. " + doctorName + " on " + date + ": ");
+        interface.headerMsg("Available Times for Dr. " + doctorName + " on " + date.dateString() + ": ");
 
         interface.showAvailableTimes(availableTimes);
     }
 
     /**
      * @brief Registers a new patient and adds them to the registry.
-     * @return Patient The newly registered patient object.
+     * @return Patient& The registered patient.
      */
-    Patient registerPatient()
+    Patient &registerPatient()
     {
         interface.headerMsg("Registration form");
 
@@ -206,9 +209,7 @@ public:
 
         string dateOfBirth = interface.getInfo("Enter your date of birth (DD.MM.YYYY): ");
 
-        Patient patient = registry.addPatient(patientName, dateOfBirth);
-
-        return patient;
+        return registry.addPatient(patientName, dateOfBirth);
     }
 
     /**
@@ -216,19 +217,11 @@ public:
      */
     void addVisitCardMenu()
     {
-        Appointment *appointment = nullptr;
-
-        registry.showAppointments();
-
-        vector<Appointment> appointments = registry.getAppointments();
-
-        int choice = interface.getValidChoice(appointments);
-
-        appointment = &registry.getByIndex(choice - 1, appointments);
+        const Appointment &appointment = registry.getAppointment(getAppointmentFromUser());
 
-        Patient patient = appointment->getPatient();
-        Doctor doctor = appointment->getDoctor();
-        string dateTime = appointment->getDateTime();
+        Patient &patient = registry.getPatient(appointment.getPatientId());
+        Doctor &doctor = registry.getDoctor(appointment.getDoctorId());
+        Timestamp dateTime = appointment.getDateTime();
 
         string diagnosis = interface.getInfo("Enter diagnosis: ");
 
@@ -247,6 +240,11 @@ public:
     {
         Patient *patient = nullptr;
 
+        if (registry.getPatients().size() > PATIENTS_LISTED)
+        {
+            return searchPatient();
+        }
+
         interface.headerMsg("List of registered patients");
 
         interface.showPeople(registry.getPatients());
@@ -258,6 +256,44 @@ public:
         return patient;
     }
 
+    /**
+     * @brief Lets the user find a patient of a large roster by name or date of birth.
+     * @return Pointer to the selected patient.
+     *
+     * The user enters part of a name, a misspelled name or a date of birth and picks one
+     * of the best matches, or enters 0 to search again.
+     */
+    Patient *searchPatient()
+    {
+        while (true)
+        {
+            interface.headerMsg("Patient search");
+
+            string query = interface.getInfo("Enter a name, the beginning of a name or a date of birth: ");
+            vector<PersonId> matches = registry.searchPatients(query, SEARCH_RESULTS);
+
+            if (matches.empty())
+            {
+                interface.printMsg("No patients found.");
+                continue;
+            }
+
+            vector<Patient *> candidates;
+            for (PersonId id : matches)
+            {
+                candidates.push_back(&registry.getPatient(id));
+                interface.printMsg("(" + std::to_string(candidates.size()) + ") " + candidates.back()->getName() + ", born " + string(candidates.back()->getDateOfBirth()));
+            }
+            interface.printMsg("(0) Search again");
+
+            int choice = interface.getUserChoice();
+            if (choice == 0)
+                continue;
+
+            return registry.getByIndex(choice - 1, candidates);
+        }
+    }
+
     /**
      * @brief Displays the menu for retrieving visit cards for a specific patient.
      */
@@ -265,7 +301,7 @@ public:
     {
         Patient *patient = choosePatient();
 
-        vector<HospitalVisitCard> patientVisitCards = registry.getVisitCardsForPatient(*patient);
+        const vector<HospitalVisitCard> &patientVisitCards = registry.getVisitCardsForPatient(*patient);
 
         interface.headerMsg("Hospital Visit Cards for " + patient->getName() + ":");
 
@@ -278,7 +314,7 @@ public:
 
         for (auto &visitCard : patientVisitCards)
         {
-            visitCard.showVisitCard();
+            interface.printVisitCard(patient->getName(), registry.getDoctor(visitCard.getDoctorId()).getName(), visitCard.getDateTime(), visitCard.getDiagnosis());
         }
     }
 
@@ -289,7 +325,7 @@ public:
     {
         Doctor *doctor = selectDoctorFromList();
 
-        doctor->printDetails();
+        doctor->printDetails(registry);
     }
 
     /**
@@ -324,9 +360,23 @@ public:
             case RETURN_TO_MAIN_MENU:
                 interface.printMsg("Returning to main menu...");
                 return;
+#ifdef REGISTRY_METRICS
+            case SHOW_METRICS:
+            {
+                string report;
+                for (const string &line : registry.metricsReport())
+                    report += line + '\n';
+
+                interface.headerMsg("Metrics");
+                interface.printText(report);
+                break;
+            }
+#endif
             default:
                 interface.printMsg("\n Invalid choice. Please try again.");
             }
+
+            registry.syncStorage();
         } while (choice != RETURN_TO_MAIN_MENU);
     }
 
@@ -335,7 +385,7 @@ public:
      */
     void patientRoute()
     {
-        Patient patient = registerPatient();
+        Patient &patient = registerPatient();
 
         int choice;
 
@@ -361,15 +411,16 @@ public:
             default:
                 interface.printMsg("\n Invalid choice. Please try again.");
             }
+
+            registry.syncStorage();
         } while (choice != 4);
-        }
+    }
 
     /**
      * @brief Starts the main menu and handles user interaction.
      */
     void start()
     {
-        registry.generateDefaultAppointments();
         int choice;
 
         do
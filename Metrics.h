@@ -0,0 +1,208 @@
+#ifdef REGISTRY_METRICS
+
+/**
+ * @enum MetricOperation
+ * @brief The registry operations whose calls are counted and timed.
+ */
+enum class MetricOperation : uint8_t
+{
+    FIND_PATIENT,      ///< findPatientByName.
+    AVAILABLE_TIMES,   ///< getAvailableTimes and getAvailableTimesForDoctor.
+    AVAILABLE_DOCTORS, ///< getAvailableDoctors.
+    FREE_SLOT_SEARCH,  ///< findEarliestFreeSlot and getDoctorsWithFreeSlots.
+    SCHEDULE,          ///< scheduleAppointment.
+    SCHEDULE_BATCH,    ///< scheduleAppointments.
+    CANCEL,            ///< cancelAppointment.
+    ADD_PATIENT,       ///< addPatient.
+    ADD_VISIT_CARD,    ///< addHospitalVisitCard.
+    VISIT_CARDS,       ///< getVisitCardsForPatient.
+    SYNC,              ///< syncStorage.
+    COUNT              ///< Number of operations.
+};
+
+/**
+ * @enum MetricLock
+ * @brief The ways a registry lock is taken, each with its own wait time histogram.
+ */
+enum class MetricLock : uint8_t
+{
+    SHARED,    ///< Reader side of a calendar shard or the table lock.
+    EXCLUSIVE, ///< Writer side of a calendar shard or the table lock.
+    COUNT      ///< Number of lock modes.
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free histogram of durations with one bucket per power of two nanoseconds.
+ *
+ * Recording is a handful of relaxed atomic increments, so it can run on every call of
+ * a hot path from any thread. Quantiles are reported as the upper bound of the bucket
+ * they fall into, which is exact to within a factor of two.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t BUCKET_COUNT = 40; ///< Bucket i counts durations below 2^(i+1) ns; the last one is open.
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> _buckets{}; ///< Number of durations per bucket.
+    std::atomic<uint64_t> _count{0};                           ///< Number of recorded durations.
+    std::atomic<uint64_t> _total{0};                           ///< Sum of the recorded durations in nanoseconds.
+
+public:
+    /**
+     * @brief Records one duration.
+     * @param nanoseconds The duration.
+     */
+    void record(uint64_t nanoseconds)
+    {
+        size_t bucket = nanoseconds < 2 ? 0 : 63 - __builtin_clzll(nanoseconds);
+        _buckets[std::min(bucket, BUCKET_COUNT - 1)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _total.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the number of recorded durations.
+     * @return The count.
+     */
+    uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Gets the sum of the recorded durations.
+     * @return The sum in nanoseconds.
+     */
+    uint64_t total() const { return _total.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Estimates a quantile of the recorded durations.
+     * @param fraction The quantile, between 0 and 1.
+     * @return The upper bound of the bucket holding the quantile in nanoseconds, or 0 if nothing was recorded.
+     */
+    uint64_t quantile(double fraction) const
+    {
+        uint64_t target = static_cast<uint64_t>(fraction * count());
+        uint64_t seen = 0;
+
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            seen += _buckets[bucket].load(std::memory_order_relaxed);
+            if (seen > target)
+                return uint64_t(1) << (bucket + 1);
+        }
+        return 0;
+    }
+};
+
+/**
+ * @class RegistryMetrics
+ * @brief Process-wide call counters and latency histograms of the registry.
+ *
+ * The application runs a single registry per process, so the histograms live in one
+ * shared instance that Registry and ConcurrentRegistry record into without having to
+ * pass it around. Everything in this class is compiled out unless REGISTRY_METRICS is
+ * defined; the macros below then expand to nothing.
+ */
+class RegistryMetrics
+{
+private:
+    std::array<LatencyHistogram, size_t(MetricOperation::COUNT)> _operations; ///< Call latency per operation.
+    std::array<LatencyHistogram, size_t(MetricLock::COUNT)> _lockWaits;       ///< Time spent waiting for locks per mode.
+
+    /**
+     * @brief Appends the lines describing one histogram.
+     * @param lines The report to append to.
+     * @param name The metric name.
+     * @param label The label identifying the histogram.
+     * @param histogram The histogram.
+     */
+    static void describe(vector<string> &lines, const string &name, const string &label, const LatencyHistogram &histogram)
+    {
+        static const pair<const char *, double> quantiles[] = {{"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}};
+
+        lines.push_back(name + "_count{" + label + "} " + std::to_string(histogram.count()));
+        lines.push_back(name + "_sum_ns{" + label + "} " + std::to_string(histogram.total()));
+        for (const auto &quantile : quantiles)
+            lines.push_back(name + "_ns{" + label + ",quantile=\"" + quantile.first + "\"} " + std::to_string(histogram.quantile(quantile.second)));
+    }
+
+public:
+    /**
+     * @brief Gets the metrics of the process.
+     * @return The shared instance.
+     */
+    static RegistryMetrics &global()
+    {
+        static RegistryMetrics metrics;
+        return metrics;
+    }
+
+    LatencyHistogram &operation(MetricOperation operation) { return _operations[size_t(operation)]; }
+
+    LatencyHistogram &lockWait(MetricLock mode) { return _lockWaits[size_t(mode)]; }
+
+    /**
+     * @brief Describes every histogram as lines of "name{labels} value".
+     * @param lines The report to append to.
+     */
+    void report(vector<string> &lines) const
+    {
+        static const char *const operations[] = {"find_patient", "available_times", "available_doctors", "free_slot_search", "schedule",
+                                                 "schedule_batch", "cancel", "add_patient", "add_visit_card", "visit_cards", "sync"};
+        static_assert(sizeof(operations) / sizeof(operations[0]) == size_t(MetricOperation::COUNT), "Every operation needs a name.");
+
+        for (size_t i = 0; i < _operations.size(); ++i)
+            describe(lines, "registry_operation", string("operation=\"") + operations[i] + '"', _operations[i]);
+
+        describe(lines, "registry_lock_wait", "mode=\"shared\"", _lockWaits[size_t(MetricLock::SHARED)]);
+        describe(lines, "registry_lock_wait", "mode=\"exclusive\"", _lockWaits[size_t(MetricLock::EXCLUSIVE)]);
+    }
+};
+
+/**
+ * @class ScopedLatency
+ * @brief Records the time between its construction and destruction in a histogram.
+ */
+class ScopedLatency
+{
+private:
+    LatencyHistogram &_histogram;
+    std::chrono::steady_clock::time_point _started;
+
+public:
+    explicit ScopedLatency(LatencyHistogram &histogram) : _histogram(histogram), _started(std::chrono::steady_clock::now()) {}
+
+    ScopedLatency(const ScopedLatency &) = delete;
+    ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+    ~ScopedLatency()
+    {
+        _histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _started).count());
+    }
+};
+
+/**
+ * @class MeasuredLock
+ * @brief A std::shared_lock or std::unique_lock that records how long it waited for the mutex.
+ * @tparam Lock The lock type to acquire.
+ * @tparam Mode The histogram receiving the wait time.
+ */
+template <typename Lock, MetricLock Mode>
+class MeasuredLock : public Lock
+{
+public:
+    explicit MeasuredLock(typename Lock::mutex_type &mutex) : Lock(mutex, std::defer_lock)
+    {
+        ScopedLatency wait(RegistryMetrics::global().lockWait(Mode));
+        this->lock();
+    }
+};
+
+/// Times the rest of the enclosing scope as a call of the given MetricOperation.
+#define REGISTRY_MEASURE(name) ScopedLatency registryMeasure_(RegistryMetrics::global().operation(MetricOperation::name))
+
+#else
+
+#define REGISTRY_MEASURE(name)
+
+#endif
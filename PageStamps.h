@@ -0,0 +1,51 @@
+/**
+ * @class PageStamps
+ * @brief Tells which pages of a table changed since a copy of them was taken.
+ *
+ * A table is split into pages of ROWS_PER_PAGE rows. Every change of a row gives its
+ * page a new stamp from a counter that only grows, so a page whose stamp is the one a
+ * copy recorded is unchanged since the copy. Report views use the stamps to copy only
+ * the pages that changed and to share the others with the previous view.
+ */
+class PageStamps
+{
+public:
+    static constexpr size_t ROWS_PER_PAGE = 4096; ///< Rows of a table in one page.
+
+private:
+    vector<uint64_t> _stamps; ///< Stamp of each page; 0 for a page that was never changed.
+    uint64_t _last = 0;       ///< The latest stamp handed out.
+
+public:
+    /**
+     * @brief Records a change of a row.
+     * @param row The position of the row in the table.
+     */
+    void touch(size_t row)
+    {
+        size_t page = row / ROWS_PER_PAGE;
+        if (page >= _stamps.size())
+            _stamps.resize(page + 1, 0);
+        _stamps[page] = ++_last;
+    }
+
+    /**
+     * @brief Gets the stamp of a page.
+     * @param page The index of the page.
+     * @return The stamp of the latest change of the page, or 0 if it never changed.
+     */
+    uint64_t stamp(size_t page) const
+    {
+        return page < _stamps.size() ? _stamps[page] : 0;
+    }
+
+    /**
+     * @brief Gets the number of pages a table of a given size has.
+     * @param rows The number of rows of the table.
+     * @return The number of pages, the last one possibly partial.
+     */
+    static size_t pageCount(size_t rows)
+    {
+        return (rows + ROWS_PER_PAGE - 1) / ROWS_PER_PAGE;
+    }
+};
@@ -15,17 +15,18 @@ public:
     /**
      * @brief Constructs a Patient object with the given name and date of birth.
      * @param name The name of the patient.
-     * @param dateOfBirth The date of birth of the patient.
+     * @param dateOfBirth The date of birth of the patient; the text must outlive the patient.
      */
-    Patient(const string &name, const string &dateOfBirth) : AbstractPerson(name, dateOfBirth) {}
+    Patient(string_view name, string_view dateOfBirth) : AbstractPerson(name, dateOfBirth) {}
 
     /**
      * @brief Prints the details of appointments for the patient.
+     * @param registry The registry used to resolve the patient's appointments.
      *
      * This method displays the details of appointments for the patient, including the date and time
      * of each appointment and the name of the doctor involved.
      */
-    void printDetails() override
+    void printDetails(IRegistry &registry) override
     {
         interface.headerMsg("Appointments");
 
@@ -36,9 +37,11 @@ public:
         }
 
         int index = 1;
-        for (auto &appointment : appointments)
+        for (auto &handle : appointments)
         {
-            interface.showAppointment(index, appointment);
+            const Appointment &appointment = registry.getAppointment(handle);
+
+            interface.showAppointment(index, appointment.getDateTime(), registry.getDoctorName(appointment.getDoctorId()));
             index++;
         }
     }
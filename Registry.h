@@ -11,9 +11,13 @@
 class Registry : public IRegistry
 {
 private:
-    vector<HospitalVisitCard> _visitCards;
+    MappedSnapshot _snapshot; ///< The snapshot restored from; restored strings point into its mapping.
+    StringPool _strings;      ///< Interned diagnoses and dates of birth, referenced by the tables below.
 
-    vector<Doctor> _doctors = {
+    vector<vector<HospitalVisitCard>> _visitCards; ///< Visit cards bucketed by patient ID.
+    PageStamps _patientPages;                      ///< Changes of the patients and their visit cards, by patient ID.
+
+    deque<Doctor> _doctors = {
         Doctor("John Smith"),
         Doctor("Emily Johnson"),
         Doctor("David Brown"),
@@ -23,40 +27,1222 @@ private:
         Doctor("Matthew Taylor"),
         Doctor("Olivia Martinez")};
 
-    vector<Patient> _patients = {
-        Patient("Alice Smith", "23.08.1997"),
-        Patient("Bob Johnson", "22.06.2000"),
-        Patient("Charlie Brown", "12.01.1998"),
-        Patient("Diana Davis", "03.03.2003"),
-        Patient("Eva Martinez", "02.08.2008"),
-        Patient("Frank Lopez", "14.02.2012"),
-        Patient("Grace Lee", "14.08.2012"),
-        Patient("Henry Jackson", "22.08.2006")};
+    deque<Patient> _patients = {
+        Patient("Alice Smith", "23.08.1997"),
+        Patient("Bob Johnson", "22.06.2000"),
+        Patient("Charlie Brown", "12.01.1998"),
+        Patient("Diana Davis", "03.03.2003"),
+        Patient("Eva Martinez", "02.08.2008"),
+        Patient("Frank Lopez", "14.02.2012"),
+        Patient("Grace Lee", "14.08.2012"),
+        Patient("Henry Jackson", "22.08.2006")};
+
+    AppointmentStore _appointments; ///< Appointments of the hot window, today and later plus past days not archived yet.
+    AppointmentArchive _archive;    ///< Compressed appointments of archived past days.
+
+    mutable std::shared_mutex _storeMutex; ///< Guards the store and patient handle lists when bookings of several doctors run at once.
+
+    vector<AppointmentSeries> _series;                         ///< Recurring appointment series by series ID.
+    unordered_map<PersonId, vector<uint32_t>> _seriesByDoctor; ///< IDs of the series of each doctor.
+
+    FreeSlotBoard _freeSlots; ///< Free slots of every doctor by day, readable while bookings run.
+
+    unordered_map<string_view, size_t> _doctorIndex;  ///< Doctor name to position in _doctors; keys view the stored names.
+    unordered_map<string_view, size_t> _patientIndex; ///< Patient name to position in _patients; keys view the stored names.
+
+    NameSearchIndex _doctorSearch;                                     ///< Prefix and fuzzy index of doctor names.
+    NameSearchIndex _patientSearch;                                    ///< Prefix and fuzzy index of patient names.
+    unordered_map<string_view, vector<PersonId>> _patientsByBirthDate; ///< Patients by date of birth; keys view the stored dates.
+
+    InputOutput interface;
+
+    WriteAheadLog _log;         ///< Durable log of mutations; closed when the registry is in-memory only.
+    string _snapshotPath;       ///< Path of the compacted snapshot next to the log.
+    uint32_t _epoch = 0;        ///< Epoch of the current snapshot; the log only holds entries after it.
+    bool _deferStorage = false; ///< Due commits and compactions are left to the caller.
+    bool _quiet = false;        ///< The messages about changes are not printed.
+
+    static constexpr size_t COMPACTION_THRESHOLD = 10000; ///< Log entries after which a snapshot is taken.
+
+    static constexpr int SERIES_WINDOW_DAYS = 28; ///< Days from today within which series occurrences are booked.
+
+    static constexpr size_t PARALLEL_THRESHOLD = 512; ///< Items from which roster-wide work runs on the worker pool.
+    static constexpr size_t ITEMS_PER_CHUNK = 128;    ///< Items handed to a pool thread at a time.
+
+    /**
+     * @brief Records a mutation in the log, committing and compacting it when due.
+     * @param record The mutation to record.
+     *
+     * With deferStorageWork() the entry is only appended, and the caller commits and
+     * compacts once it released its locks.
+     */
+    void record(const LogRecord &record)
+    {
+        if (!_log.isOpen())
+            return;
+
+        _log.append(record);
+
+        if (_deferStorage)
+            return;
+        if (_log.commitDue())
+            _log.commit();
+        if (compactionDue())
+            compactStorage();
+    }
+
+    /**
+     * @brief Checks whether a day has been moved to the archive and is closed for booking.
+     * @param day The day index.
+     * @return True if the day is archived, false otherwise.
+     */
+    bool isArchived(int32_t day) const
+    {
+        return day <= _archive.lastDay();
+    }
+
+    /**
+     * @brief Stores an appointment and indexes it for the doctor and the patient.
+     * @param dateTime The date and time of the appointment.
+     * @param doctor The doctor of the appointment.
+     * @param patient The patient of the appointment.
+     * @return The handle of the new appointment.
+     */
+    AppointmentHandle bookAppointment(Timestamp dateTime, Doctor &doctor, Patient &patient)
+    {
+        AppointmentHandle handle;
+        {
+            std::lock_guard<std::shared_mutex> store(_storeMutex);
+            handle = _appointments.insert(Appointment(dateTime, doctor.getId(), patient.getId()));
+            _appointments.setIndexPosition(handle, patient.addAppointment(handle));
+        }
+
+        doctor.addAppointment(handle, dateTime);
+        int slot = doctor.getCalendar().slotIndex(dateTime.minuteOfDay());
+        if (slot >= 0)
+            _freeSlots.book(dateTime.day(), doctor.getId(), slot);
+
+        LogRecord entry;
+        entry.operation = LogOperation::SCHEDULE;
+        entry.doctorId = doctor.getId();
+        entry.patientId = patient.getId();
+        entry.dateTime = dateTime;
+        record(entry);
+
+        return handle;
+    }
+
+    /**
+     * @brief Removes an appointment from the store and from the doctor's and patient's indices.
+     * @param handle The handle of the appointment.
+     * @throws std::out_of_range If the appointment no longer exists.
+     */
+    void removeAppointment(AppointmentHandle handle)
+    {
+        LogRecord entry;
+        entry.operation = LogOperation::CANCEL;
+        {
+            std::lock_guard<std::shared_mutex> store(_storeMutex);
+            const Appointment &appointment = _appointments.get(handle);
+            entry.doctorId = appointment.getDoctorId();
+            entry.patientId = appointment.getPatientId();
+            entry.dateTime = appointment.getDateTime();
+
+            uint32_t position = _appointments.indexPosition(handle);
+            AppointmentHandle moved = _patients[entry.patientId].deleteAppointment(position);
+            if (moved != handle)
+                _appointments.setIndexPosition(moved, position);
+
+            _appointments.erase(handle);
+        }
+
+        Doctor &doctor = _doctors[entry.doctorId];
+        doctor.deleteAppointment(handle, entry.dateTime);
+        int slot = doctor.getCalendar().slotIndex(entry.dateTime.minuteOfDay());
+        if (slot >= 0)
+            _freeSlots.release(entry.dateTime.day(), entry.doctorId, slot);
+
+        record(entry);
+    }
+
+    /**
+     * @brief Finds an appointment in a doctor's index.
+     * @param doctor The doctor of the appointment.
+     * @param patientId The ID of the patient of the appointment.
+     * @param dateTime The date and time of the appointment.
+     * @param handle Receives the handle of the appointment.
+     * @return True if the appointment was found, false otherwise.
+     */
+    bool findAppointment(Doctor &doctor, PersonId patientId, Timestamp dateTime, AppointmentHandle &handle)
+    {
+        std::shared_lock<std::shared_mutex> store(_storeMutex);
+        for (AppointmentHandle candidate : doctor.getSchedule(dateTime, Timestamp::fromMinutes(dateTime.minutes() + 1)))
+        {
+            if (_appointments.get(candidate).getPatientId() == patientId)
+            {
+                handle = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Stores and indexes a recurring series without logging or booking it.
+     * @param doctorId The ID of the doctor.
+     * @param patientId The ID of the patient.
+     * @param first The date and time of the first occurrence.
+     * @param intervalDays The days between occurrences.
+     * @param count The number of occurrences.
+     * @return A reference to the stored series, valid until the next series is stored.
+     */
+    AppointmentSeries &storeSeries(PersonId doctorId, PersonId patientId, Timestamp first, int intervalDays, int count)
+    {
+        _seriesByDoctor[doctorId].push_back(_series.size());
+        return _series.emplace_back(doctorId, patientId, first, intervalDays, count);
+    }
+
+    /**
+     * @brief Finds the series with an occurrence at a date and time.
+     * @param doctorId The ID of the doctor of the occurrence.
+     * @param patientId The ID of the patient of the occurrence.
+     * @param dateTime The date and time of the occurrence.
+     * @return The series, or nullptr if no series of the doctor and patient occurs then.
+     */
+    AppointmentSeries *findSeries(PersonId doctorId, PersonId patientId, Timestamp dateTime)
+    {
+        auto it = _seriesByDoctor.find(doctorId);
+        if (it == _seriesByDoctor.end())
+            return nullptr;
+
+        for (uint32_t id : it->second)
+        {
+            size_t index;
+            if (_series[id].getPatientId() == patientId && _series[id].findOccurrence(dateTime, index))
+                return &_series[id];
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Adds an exception to a series and logs it.
+     * @param series The series.
+     * @param day The day index of the skipped occurrence.
+     */
+    void skipOccurrence(AppointmentSeries &series, int32_t day)
+    {
+        if (!series.skip(day))
+            return;
+
+        LogRecord entry;
+        entry.operation = LogOperation::SKIP_OCCURRENCE;
+        entry.doctorId = series.getDoctorId();
+        entry.patientId = series.getPatientId();
+        entry.dateTime = Timestamp(day, series.getFirst().minuteOfDay());
+        record(entry);
+    }
+
+    /**
+     * @brief Books the occurrences of a series that start before a day.
+     * @param series The series.
+     * @param endDay The first day that is not booked yet.
+     * @param conflicts Incremented for every occurrence skipped because its slot was taken.
+     * @return The number of appointments booked.
+     *
+     * Occurrences that are already booked for the series' patient count as booked, so
+     * the series can be materialized again after a restart. Occurrences on archived
+     * days are history and are left alone.
+     */
+    size_t materializeSeries(AppointmentSeries &series, int32_t endDay, size_t &conflicts)
+    {
+        Doctor &doctor = _doctors[series.getDoctorId()];
+        Patient &patient = _patients[series.getPatientId()];
+
+        size_t booked = 0;
+        size_t index = series.materialized();
+        for (; index < series.size() && series.occurrence(index).day() < endDay; ++index)
+        {
+            Timestamp dateTime = series.occurrence(index);
+
+            AppointmentHandle handle;
+            if (series.isSkipped(dateTime.day()) || isArchived(dateTime.day()) || findAppointment(doctor, patient.getId(), dateTime, handle))
+                continue;
+
+            if (doctor.isAvailable(dateTime))
+            {
+                bookAppointment(dateTime, doctor, patient);
+                booked++;
+            }
+            else
+            {
+                skipOccurrence(series, dateTime.day());
+                conflicts++;
+            }
+        }
+
+        series.setMaterialized(index);
+        return booked;
+    }
+
+    /**
+     * @brief Rejects a text that a log entry could not hold, before any table is changed.
+     * @param text The text.
+     * @param what What the text is, for the error message.
+     * @throws std::invalid_argument If the text is longer than WriteAheadLog::MAX_TEXT_SIZE.
+     *
+     * The limit applies with and without storage, so a registry behaves the same whether
+     * it is logged, replayed or replicated.
+     */
+    static void checkLoggable(string_view text, const char *what)
+    {
+        if (text.size() > WriteAheadLog::MAX_TEXT_SIZE)
+            throw std::invalid_argument(string("The ") + what + " is longer than " + std::to_string(WriteAheadLog::MAX_TEXT_SIZE) + " bytes.");
+    }
+
+    /**
+     * @brief Stores and indexes a patient that is not registered yet, without logging it.
+     * @param name The name of the patient.
+     * @param dateOfBirth The date of birth of the patient.
+     * @return A reference to the stored patient.
+     * @throws std::invalid_argument If the name or date of birth is too long to be logged.
+     */
+    Patient &storePatient(string_view name, string_view dateOfBirth)
+    {
+        checkLoggable(name, "patient name");
+        checkLoggable(dateOfBirth, "date of birth");
+
+        PersonId id = _patients.size();
+
+        Patient &patient = _patients.emplace_back(name, _strings.intern(dateOfBirth));
+        patient.setId(id);
+        _patientIndex.emplace(patient.getName(), id);
+        _patientSearch.add(id, patient.getName());
+        _patientsByBirthDate[patient.getDateOfBirth()].push_back(id);
+        _patientPages.touch(id);
+
+        return patient;
+    }
+
+    /**
+     * @brief Adds a patient that is not registered yet.
+     * @param name The name of the patient.
+     * @param dateOfBirth The date of birth of the patient.
+     * @return A reference to the stored patient.
+     */
+    Patient &registerPatient(string_view name, string_view dateOfBirth)
+    {
+        Patient &patient = storePatient(name, dateOfBirth);
+
+        LogRecord entry;
+        entry.operation = LogOperation::ADD_PATIENT;
+        entry.text = string(name);
+        entry.extra = string(dateOfBirth);
+        record(entry);
+
+        return patient;
+    }
+
+    /**
+     * @brief Adds a visit card to the bucket of its patient.
+     * @param doctorId The ID of the attending doctor.
+     * @param patientId The ID of the patient.
+     * @param dateTime The date and time of the visit.
+     * @param diagnosis The diagnosis; it is interned before it is stored.
+     * @return A reference to the stored visit card.
+     * @throws std::invalid_argument If the diagnosis is too long to be logged.
+     */
+    const HospitalVisitCard &storeVisitCard(PersonId doctorId, PersonId patientId, Timestamp dateTime, string_view diagnosis)
+    {
+        checkLoggable(diagnosis, "diagnosis");
+
+        if (patientId >= _visitCards.size())
+        {
+            _visitCards.resize(_patients.size());
+        }
+        const HospitalVisitCard &visitCard = _visitCards[patientId].emplace_back(doctorId, patientId, dateTime, _strings.intern(diagnosis));
+        _patientPages.touch(patientId);
+
+        LogRecord entry;
+        entry.operation = LogOperation::ADD_VISIT_CARD;
+        entry.doctorId = doctorId;
+        entry.patientId = patientId;
+        entry.dateTime = dateTime;
+        entry.text = string(diagnosis);
+        record(entry);
+
+        return visitCard;
+    }
+
+    /**
+     * @brief Appends the prefix matches of a query and then its fuzzy matches, skipping IDs already present.
+     * @param matches The IDs found so far; receives the new ones.
+     * @param index The index to search.
+     * @param query The query.
+     * @param limit The maximum size of matches.
+     */
+    static void addMatches(vector<PersonId> &matches, const NameSearchIndex &index, string_view query, size_t limit)
+    {
+        auto add = [&matches, limit](PersonId id)
+        {
+            if (matches.size() < limit && std::find(matches.begin(), matches.end(), id) == matches.end())
+                matches.push_back(id);
+        };
+
+        if (matches.size() < limit)
+        {
+            for (PersonId id : index.prefix(query, limit))
+                add(id);
+        }
+        if (matches.size() < limit)
+        {
+            for (const auto &match : index.fuzzy(query, limit))
+                add(match.first);
+        }
+    }
+
+    /**
+     * @brief Collects per-doctor results over the whole roster, in parallel for large rosters.
+     * @tparam T The type of the collected items.
+     * @tparam Fill A callable taking a Doctor reference and the vector<T> to append to.
+     * @param fill Appends the items of one doctor; it only reads the doctor.
+     * @return The items of every doctor in roster order, as the serial loop would produce them.
+     */
+    template <typename T, typename Fill>
+    vector<T> collectPerDoctor(Fill fill)
+    {
+        vector<T> items;
+
+        if (_doctors.size() < PARALLEL_THRESHOLD)
+        {
+            for (Doctor &doctor : _doctors)
+                fill(doctor, items);
+            return items;
+        }
+
+        size_t chunkCount = (_doctors.size() + ITEMS_PER_CHUNK - 1) / ITEMS_PER_CHUNK;
+        vector<vector<T>> parts(chunkCount);
+
+        WorkerPool::shared().run(chunkCount, [&](size_t chunk)
+                                 {
+                                     size_t end = std::min(_doctors.size(), (chunk + 1) * ITEMS_PER_CHUNK);
+                                     for (size_t id = chunk * ITEMS_PER_CHUNK; id < end; ++id)
+                                         fill(_doctors[id], parts[chunk]); });
+
+        size_t total = 0;
+        for (const vector<T> &part : parts)
+            total += part.size();
+
+        items.reserve(total);
+        for (vector<T> &part : parts)
+            std::move(part.begin(), part.end(), std::back_inserter(items));
+
+        return items;
+    }
+
+    /**
+     * @brief Appends the free slots of a doctor on a date, reading only that doctor's mask of the day.
+     * @param doctor The doctor whose free slots are appended.
+     * @param day The free slots of every doctor on the date.
+     * @param date The date of the slots.
+     * @param availableTimes Receives the free times paired with the doctor's ID.
+     */
+    static void appendAvailableTimes(const Doctor &doctor, const FreeSlotBoard::Day &day, Timestamp date, vector<pair<Timestamp, PersonId>> &availableTimes)
+    {
+        SlotCalendar::SlotMask freeSlots = day.freeMask(doctor.getId());
+
+        while (freeSlots != 0)
+        {
+            int slot = __builtin_ctzll(freeSlots);
+            freeSlots &= freeSlots - 1;
+
+            availableTimes.push_back(make_pair(doctor.getCalendar().slotStart(date.day(), slot), doctor.getId()));
+        }
+    }
+
+    /**
+     * @brief Checks that a doctor ID of stored or replicated data means the same doctor here.
+     * @param id The ID of the doctor in the data.
+     * @param name The name of the doctor in the data.
+     * @throws std::runtime_error If the registry has no doctor or another doctor at that ID.
+     *
+     * Doctors come from the roster and are not logged, so appointments and visit cards
+     * only name them by ID; a reordered or edited roster would otherwise move them to
+     * whichever doctor now has the ID. Doctors added at the end of the roster are fine.
+     */
+    void checkRosterDoctor(PersonId id, string_view name) const
+    {
+        if (id >= _doctors.size())
+            throw runtime_error("The roster does not match the stored data: doctor " + string(name) + " (ID " + std::to_string(id) + ") is missing.");
+        if (_doctors[id].getName() != name)
+            throw runtime_error("The roster does not match the stored data: doctor ID " + std::to_string(id) + " was " + string(name) +
+                                " but is now " + _doctors[id].getName() + ".");
+    }
+
+    /**
+     * @brief Appends the roster entries of every doctor to the log.
+     */
+    void logRoster()
+    {
+        LogRecord entry;
+        entry.operation = LogOperation::DOCTOR;
+        for (const Doctor &doctor : _doctors)
+        {
+            entry.doctorId = doctor.getId();
+            entry.text = doctor.getName();
+            _log.append(entry);
+        }
+    }
+
+    /**
+     * @brief Applies a replayed log entry without printing anything.
+     * @param entry The entry to apply.
+     *
+     * Entries that refer to unknown people or to slots that are already taken are
+     * skipped, so a damaged log cannot corrupt the in-memory tables.
+     * @throws std::runtime_error If a roster entry names another doctor than the registry has at that ID.
+     */
+    void applyLogRecord(const LogRecord &entry)
+    {
+        bool knownPeople = entry.doctorId < _doctors.size() && entry.patientId < _patients.size();
+
+        switch (entry.operation)
+        {
+        case LogOperation::CHECKPOINT:
+            break;
+        case LogOperation::DOCTOR:
+            checkRosterDoctor(entry.doctorId, entry.text);
+            break;
+        case LogOperation::ADD_PATIENT:
+            if (_patientIndex.find(entry.text) == _patientIndex.end())
+                registerPatient(entry.text, entry.extra);
+            break;
+        case LogOperation::SCHEDULE:
+            if (knownPeople && !isArchived(entry.dateTime.day()) && _doctors[entry.doctorId].isAvailable(entry.dateTime))
+                bookAppointment(entry.dateTime, _doctors[entry.doctorId], _patients[entry.patientId]);
+            break;
+        case LogOperation::CANCEL:
+        {
+            AppointmentHandle handle;
+            if (knownPeople && findAppointment(_doctors[entry.doctorId], entry.patientId, entry.dateTime, handle))
+                removeAppointment(handle);
+            break;
+        }
+        case LogOperation::ADD_VISIT_CARD:
+            if (knownPeople)
+            {
+                storeVisitCard(entry.doctorId, entry.patientId, entry.dateTime, entry.text);
+            }
+            break;
+        case LogOperation::ADD_SERIES:
+            if (knownPeople && entry.interval >= 1 && entry.count >= 1 && entry.count <= AppointmentSeries::MAX_OCCURRENCES)
+                storeSeries(entry.doctorId, entry.patientId, entry.dateTime, entry.interval, entry.count);
+            break;
+        case LogOperation::SKIP_OCCURRENCE:
+            if (AppointmentSeries *series = findSeries(entry.doctorId, entry.patientId, entry.dateTime))
+                series->skip(entry.dateTime.day());
+            break;
+        }
+    }
+
+    /**
+     * @brief Loads the tables of a mapped snapshot without logging them.
+     * @param snapshot The mapped snapshot.
+     *
+     * Records are read in place from the mapping and added to the live tables, which
+     * own the rows and their indices. The diagnoses and dates of birth are adopted by
+     * the string pool straight from the mapping, so the live tables serve them from the
+     * file's pages; only names of patients, which the people own, are copied.
+     * @throws std::runtime_error If the doctors of the snapshot are not the first doctors of the roster.
+     */
+    void loadSnapshot(const MappedSnapshot &snapshot)
+    {
+        for (PersonId id = 0; id < snapshot.doctorCount(); ++id)
+            checkRosterDoctor(id, snapshot.doctorName(id));
+
+        for (size_t i = 0; i < snapshot.patientCount(); ++i)
+        {
+            string_view name = snapshot.patientName(i);
+            if (_patientIndex.find(name) == _patientIndex.end())
+                registerPatient(name, _strings.adopt(snapshot.patientDateOfBirth(i)));
+        }
+
+        _appointments.reserve(snapshot.appointmentCount());
+        for (size_t i = 0; i < snapshot.appointmentCount(); ++i)
+        {
+            const SnapshotAppointment &record = snapshot.appointment(i);
+            Timestamp dateTime = Timestamp::fromMinutes(record.minutes);
+
+            if (record.doctorId < _doctors.size() && record.patientId < _patients.size() && !isArchived(dateTime.day()) &&
+                _doctors[record.doctorId].isAvailable(dateTime))
+                bookAppointment(dateTime, _doctors[record.doctorId], _patients[record.patientId]);
+        }
+
+        for (size_t i = 0; i < snapshot.visitCardCount(); ++i)
+        {
+            const SnapshotVisitCard &record = snapshot.visitCard(i);
+
+            if (record.doctorId < _doctors.size() && record.patientId < _patients.size())
+                storeVisitCard(record.doctorId, record.patientId, Timestamp::fromMinutes(record.minutes), _strings.adopt(snapshot.visitCardDiagnosis(i)));
+        }
+
+        for (size_t i = 0; i < snapshot.seriesCount(); ++i)
+        {
+            const SnapshotSeries &record = snapshot.series(i);
+            if (record.doctorId >= _doctors.size() || record.patientId >= _patients.size() || record.intervalDays < 1 || record.count < 1)
+                continue;
+
+            AppointmentSeries &series = storeSeries(record.doctorId, record.patientId, Timestamp::fromMinutes(record.minutes), record.intervalDays, record.count);
+            for (int32_t day : snapshot.seriesSkipped(i))
+                series.skip(day);
+        }
+    }
+
+    /**
+     * @brief Starts a new log epoch with a checkpoint entry followed by the roster.
+     * @param epoch The epoch of the snapshot the log follows.
+     */
+    void startLogEpoch(uint32_t epoch)
+    {
+        LogRecord checkpoint;
+        checkpoint.operation = LogOperation::CHECKPOINT;
+        checkpoint.epoch = epoch;
+
+        _log.reset();
+        _log.append(checkpoint);
+        logRoster();
+        _log.commit();
+    }
+
+public:
+    /**
+     * @brief Constructs the registry and indexes the seeded doctors and patients by name.
+     */
+    Registry()
+    {
+        _doctorIndex.reserve(_doctors.size());
+        for (size_t i = 0; i < _doctors.size(); ++i)
+        {
+            _doctors[i].setId(i);
+            _doctorIndex.emplace(_doctors[i].getName(), i);
+            _doctorSearch.add(i, _doctors[i].getName());
+            _freeSlots.addDoctor(DefaultShift::FULL_DAY);
+        }
+
+        _patientIndex.reserve(_patients.size());
+        for (size_t i = 0; i < _patients.size(); ++i)
+        {
+            _patients[i].setId(i);
+            _patientIndex.emplace(_patients[i].getName(), i);
+            _patientSearch.add(i, _patients[i].getName());
+            _patientsByBirthDate[_patients[i].getDateOfBirth()].push_back(i);
+        }
+    }
+
+    /**
+     * @brief Adds a doctor to the roster.
+     * @param name The name of the doctor.
+     * @return A reference to the stored doctor, or to the existing doctor with the same name.
+     *
+     * Doctors are not recorded in the write-ahead log, so the roster has to be complete
+     * before the registry is opened on storage or shared between threads.
+     */
+    Doctor &addDoctor(string_view name)
+    {
+        auto existing = _doctorIndex.find(name);
+        if (existing != _doctorIndex.end())
+        {
+            return _doctors[existing->second];
+        }
+
+        PersonId id = _doctors.size();
+
+        Doctor &doctor = _doctors.emplace_back(name);
+        doctor.setId(id);
+        _doctorIndex.emplace(doctor.getName(), id);
+        _doctorSearch.add(id, doctor.getName());
+
+        _freeSlots.addDoctor(DefaultShift::FULL_DAY);
+
+        return doctor;
+    }
+
+    /**
+     * @brief Sets the working hours and slot length of a doctor.
+     * @param doctor The doctor.
+     * @param shift The shift of the doctor.
+     * @throws std::logic_error If the doctor has booked slots already.
+     *
+     * Like the roster itself, shifts are not logged: set them before the registry is
+     * opened on storage, so restored appointments are checked against the right grid.
+     */
+    void setDoctorShift(Doctor &doctor, const ShiftPattern &shift)
+    {
+        doctor.setShift(shift);
+        _freeSlots.setShift(doctor.getId(), shift.fullDay());
+    }
+
+    /**
+     * @brief Adds many patients in one pass, skipping names that are already registered.
+     * @param patients The name and date of birth of each patient; the views only need to stay valid during the call.
+     * @return The number of patients added.
+     *
+     * Index capacity is reserved once for the whole batch and no message is printed per
+     * patient. When storage is open and the batch would push the log past
+     * COMPACTION_THRESHOLD, the patients are written with a single snapshot instead of
+     * one log entry each.
+     */
+    size_t addPatients(const vector<pair<string_view, string_view>> &patients)
+    {
+        REGISTRY_MEASURE(ADD_PATIENT);
+
+        _patientIndex.reserve(_patients.size() + patients.size());
+
+        bool snapshot = _log.isOpen() && _log.size() + patients.size() >= COMPACTION_THRESHOLD;
+        size_t added = 0;
+
+        for (const auto &entry : patients)
+        {
+            if (_patientIndex.find(entry.first) != _patientIndex.end())
+                continue;
+
+            if (snapshot)
+                storePatient(entry.first, entry.second);
+            else
+                registerPatient(entry.first, entry.second);
+            added++;
+        }
+
+        if (snapshot && added > 0)
+            compactStorage();
+
+        return added;
+    }
+
+    /**
+     * @brief Restores the registry from a storage directory and starts logging to it.
+     * @param directory The directory holding the snapshot and the write-ahead log.
+     * @return True if any state was restored, false if the directory was empty.
+     * @throws std::runtime_error If the log cannot be opened.
+     * @throws std::logic_error If storage is open already.
+     *
+     * The memory-mapped snapshot is loaded first, followed by the log entries written
+     * since that snapshot. A log left over from an older epoch is already folded into
+     * the snapshot and is discarded. The snapshot stays mapped for the life of the
+     * registry, since restored strings point into it; compaction renames a new file
+     * over it, which leaves the mapped pages intact. Archived days are kept in the
+     * archive subdirectory and are only read when they are queried.
+     */
+    bool openStorage(const string &directory)
+    {
+        if (isLogging() || _snapshot.isOpen())
+            throw std::logic_error("Storage is open already.");
+
+        ::mkdir(directory.c_str(), 0755);
+        _archive.open(directory + "/archive");
+
+        _snapshotPath = directory + "/registry.snapshot";
+        string logPath = directory + "/registry.wal";
+
+        size_t restored = 0;
+        uint32_t snapshotEpoch = 0;
+
+        if (_snapshot.open(_snapshotPath))
+        {
+            loadSnapshot(_snapshot);
+            snapshotEpoch = _snapshot.epoch();
+            restored += _snapshot.patientCount() + _snapshot.appointmentCount() + _snapshot.visitCardCount();
+        }
+
+        bool current = true;
+        size_t entries = 0;
+
+        auto restoreLog = [&](const LogRecord &entry)
+        {
+            entries++;
+            if (entry.operation == LogOperation::CHECKPOINT)
+            {
+                current = entry.epoch >= snapshotEpoch;
+                return;
+            }
+            if (current)
+            {
+                applyLogRecord(entry);
+                restored++;
+            }
+        };
+
+        size_t validSize = WriteAheadLog::replay(logPath, restoreLog);
+
+        _epoch = snapshotEpoch;
+        _log.open(logPath, validSize, entries);
+
+        if (entries == 0 || !current)
+            startLogEpoch(_epoch);
+
+        return restored > 0;
+    }
+
+    /**
+     * @struct Checkpoint
+     * @brief A snapshot of the tables taken by captureSnapshot(), waiting to be written.
+     */
+    struct Checkpoint
+    {
+        SnapshotWriter snapshot; ///< The copied tables.
+        uint32_t epoch = 0;      ///< Epoch of the snapshot.
+        off_t logStart = 0;      ///< Position in the log of the checkpoint entry that starts the epoch.
+    };
+
+    /**
+     * @brief Checks whether the log has grown long enough to be compacted.
+     * @return True if storage is open and the log holds COMPACTION_THRESHOLD entries or more.
+     */
+    bool compactionDue() const
+    {
+        return _log.isOpen() && _log.size() >= COMPACTION_THRESHOLD;
+    }
+
+    /**
+     * @brief Copies the tables into a snapshot of the next epoch and starts that epoch in the log.
+     * @param checkpoint Receives the snapshot and where its epoch starts in the log.
+     *
+     * Only memory is touched, so the caller can hold its locks for the copy alone and
+     * write the snapshot with writeSnapshot() after releasing them. The entries of the
+     * new epoch follow the old ones in the same log until then.
+     */
+    void captureSnapshot(Checkpoint &checkpoint)
+    {
+        SnapshotWriter &snapshot = checkpoint.snapshot;
+        snapshot.reserve(_doctors.size(), _patients.size(), _appointments.size(), 0);
+
+        for (auto &doctor : _doctors)
+            snapshot.addDoctor(doctor.getName());
+        for (auto &patient : _patients)
+            snapshot.addPatient(patient.getName(), patient.getDateOfBirth());
+        for (auto &appointment : _appointments)
+            snapshot.addAppointment(appointment);
+        for (auto &bucket : _visitCards)
+            for (auto &visitCard : bucket)
+                snapshot.addVisitCard(visitCard);
+        for (auto &series : _series)
+            snapshot.addSeries(series);
+
+        checkpoint.epoch = ++_epoch;
+        checkpoint.logStart = _log.endPosition();
+
+        LogRecord entry;
+        entry.operation = LogOperation::CHECKPOINT;
+        entry.epoch = checkpoint.epoch;
+        _log.append(entry);
+        logRoster();
+    }
+
+    /**
+     * @brief Writes a captured snapshot and drops the log entries it holds.
+     * @param checkpoint The snapshot from captureSnapshot().
+     * @throws std::runtime_error If the snapshot or the log cannot be written.
+     *
+     * The log is committed first, then the snapshot is written to a temporary file and
+     * renamed into place, and only then the log is cut at the checkpoint entry, so a
+     * crash at any point leaves a snapshot and a log that restore the same state. Needs
+     * no lock of the tables: changes made meanwhile are appended to the new epoch.
+     */
+    void writeSnapshot(const Checkpoint &checkpoint)
+    {
+        _log.commit();
+
+        string temporaryPath = _snapshotPath + ".tmp";
+        checkpoint.snapshot.write(temporaryPath, checkpoint.epoch);
+
+        if (std::rename(temporaryPath.c_str(), _snapshotPath.c_str()) != 0)
+            throw runtime_error("Cannot write snapshot " + _snapshotPath);
+
+        _log.dropBefore(checkpoint.logStart);
+    }
+
+    /**
+     * @brief Writes a compacted snapshot and truncates the write-ahead log.
+     */
+    void compactStorage()
+    {
+        if (!_log.isOpen())
+            return;
+
+        Checkpoint checkpoint;
+        captureSnapshot(checkpoint);
+        writeSnapshot(checkpoint);
+    }
+
+    /**
+     * @brief Leaves due commits and compactions to the caller instead of running them in the change.
+     * @param defer True to defer them, false to run them while the change is recorded again.
+     *
+     * ConcurrentRegistry defers them, so no fsync or snapshot write happens while it
+     * holds its locks; it asks commitDue() and compactionDue() after every change.
+     */
+    void deferStorageWork(bool defer)
+    {
+        _deferStorage = defer;
+    }
+
+    /**
+     * @brief Stops or resumes printing the messages about changes to cout.
+     * @param quiet True to stop printing them.
+     *
+     * ConcurrentRegistry silences them, since changes made from several threads would
+     * interleave their messages with each other and with the output of the server.
+     */
+    void setQuiet(bool quiet)
+    {
+        _quiet = quiet;
+    }
+
+    /**
+     * @brief Checks whether the pending log entries should be committed.
+     * @return True if the batch is full or old enough, false otherwise.
+     */
+    bool commitDue() const
+    {
+        return _log.commitDue();
+    }
+
+    /**
+     * @brief Moves the appointments of past days from the hot window to the archive.
+     * @param today The first day that stays in the hot window.
+     * @return The number of appointments archived.
+     * @throws std::runtime_error If a partition cannot be written.
+     *
+     * Archived days are closed: their appointments can no longer be canceled and no
+     * appointment can be booked on them. When storage is open, the partitions are written
+     * before a snapshot without the archived appointments replaces the log; if a crash
+     * comes in between, the appointments restored for closed days are skipped.
+     */
+    size_t archivePastDays(Timestamp today)
+    {
+        unordered_map<int32_t, vector<Appointment>> past;
+        vector<AppointmentHandle> handles;
+
+        for (size_t position = 0; position < _appointments.size(); ++position)
+        {
+            const Appointment &appointment = _appointments.begin()[position];
+            if (appointment.getDateTime().day() < today.day())
+            {
+                past[appointment.getDateTime().day()].push_back(appointment);
+                handles.push_back(_appointments.handleAt(position));
+            }
+        }
+
+        if (handles.empty())
+            return 0;
+
+        for (auto &day : past)
+            _archive.store(day.first, std::move(day.second));
+
+        for (AppointmentHandle handle : handles)
+            _appointments.erase(handle);
+
+        for (Doctor &doctor : _doctors)
+            doctor.dropAppointmentsBefore(Timestamp(today.day(), 0));
+
+        for (Patient &patient : _patients)
+        {
+            vector<AppointmentHandle> &appointments = patient.getAppointments();
+            appointments.erase(std::remove_if(appointments.begin(), appointments.end(), [this](AppointmentHandle handle)
+                                              { return !_appointments.contains(handle); }),
+                               appointments.end());
+
+            for (uint32_t position = 0; position < appointments.size(); ++position)
+                _appointments.setIndexPosition(appointments[position], position);
+        }
+
+        compactStorage();
+
+        return handles.size();
+    }
+
+    /**
+     * @brief Retrieves the appointments of a doctor in a time range, archived or not.
+     * @param doctor The doctor.
+     * @param from The earliest start of an appointment in the range.
+     * @param to The start after the range.
+     * @return The time and patient name of each appointment, in chronological order.
+     * @throws std::runtime_error If an archive partition of the range cannot be read.
+     *
+     * Archived days of the range are read from their own partitions, which are already
+     * sorted by doctor and time; the rest is a binary search in the doctor's index, so
+     * the cost does not depend on the length of the doctor's history.
+     */
+    vector<pair<Timestamp, string>> getDoctorSchedule(Doctor &doctor, Timestamp from, Timestamp to)
+    {
+        vector<pair<Timestamp, string>> schedule;
+
+        int32_t lastArchived = std::min(to.day(), _archive.lastDay());
+        for (int32_t day = from.day(); day <= lastArchived; ++day)
+        {
+            if (!_archive.contains(day))
+                continue;
+
+            for (const Appointment &appointment : _archive.load(day))
+            {
+                if (appointment.getDoctorId() == doctor.getId() && from <= appointment.getDateTime() && appointment.getDateTime() < to &&
+                    appointment.getPatientId() < _patients.size())
+                    schedule.push_back(make_pair(appointment.getDateTime(), _patients[appointment.getPatientId()].getName()));
+            }
+        }
+
+        std::shared_lock<std::shared_mutex> store(_storeMutex);
+        for (AppointmentHandle handle : doctor.getSchedule(from, to))
+        {
+            const Appointment &appointment = _appointments.get(handle);
+            schedule.push_back(make_pair(appointment.getDateTime(), _patients[appointment.getPatientId()].getName()));
+        }
+
+        return schedule;
+    }
+
+    /**
+     * @brief Retrieves the appointments of a doctor on a date, archived or not.
+     * @param doctor The doctor.
+     * @param date The date.
+     * @return The time and patient name of each appointment, in chronological order.
+     * @throws std::runtime_error If the archive partition of the date cannot be read.
+     */
+    vector<pair<Timestamp, string>> getDoctorSchedule(Doctor &doctor, Timestamp date)
+    {
+        return getDoctorSchedule(doctor, Timestamp(date.day(), 0), Timestamp(date.day() + 1, 0));
+    }
+
+    /**
+     * @brief Adds a recurring series and books its occurrences inside the active window.
+     * @param doctor The doctor of every occurrence.
+     * @param patient The patient of every occurrence.
+     * @param first The date and time of the first occurrence.
+     * @param intervalDays The days between occurrences, for example 7 for a weekly series.
+     * @param count The number of occurrences.
+     * @return The ID of the series.
+     * @throws std::invalid_argument If the time is not a slot start or the interval or count is out of range.
+     *
+     * Occurrences within SERIES_WINDOW_DAYS of today are booked now; the later ones are
+     * checked against the doctor's calendar and booked by advanceSeriesWindow as the
+     * window moves. Occurrences whose slot is taken are skipped. Bookings made before a
+     * later occurrence enters the window take its slot, and the occurrence is skipped then.
+     */
+    uint32_t addSeries(Doctor &doctor, Patient &patient, Timestamp first, int intervalDays, int count)
+    {
+        if (doctor.getCalendar().slotIndex(first.minuteOfDay()) < 0 || intervalDays < 1 || intervalDays > 0xFFFF || count < 1 || count > AppointmentSeries::MAX_OCCURRENCES)
+            throw std::invalid_argument("Invalid appointment series.");
+
+        uint32_t id = _series.size();
+        AppointmentSeries &series = storeSeries(doctor.getId(), patient.getId(), first, intervalDays, count);
+
+        LogRecord entry;
+        entry.operation = LogOperation::ADD_SERIES;
+        entry.doctorId = doctor.getId();
+        entry.patientId = patient.getId();
+        entry.dateTime = first;
+        entry.interval = intervalDays;
+        entry.count = count;
+        record(entry);
+
+        size_t conflicts = 0;
+        size_t booked = materializeSeries(series, Timestamp::parse(getTodayDate()).day() + SERIES_WINDOW_DAYS, conflicts);
+
+        for (size_t index = series.materialized(); index < series.size(); ++index)
+        {
+            Timestamp dateTime = series.occurrence(index);
+            if (!doctor.isAvailable(dateTime))
+            {
+                skipOccurrence(series, dateTime.day());
+                conflicts++;
+            }
+        }
+
+        if (!_quiet)
+            interface.printMsg("Series of " + std::to_string(count) + " appointments every " + std::to_string(intervalDays) + " days from " + first.toString() +
+                               " with Dr. " + doctor.getName() + " for patient " + patient.getName() + ": " + std::to_string(booked) + " booked now, " +
+                               std::to_string(conflicts) + " skipped because the slot is taken.");
+        return id;
+    }
+
+    /**
+     * @brief Skips one occurrence of a recurring series and cancels it if it is booked.
+     * @param doctor The doctor of the series.
+     * @param patient The patient of the series.
+     * @param dateTime The date and time of the occurrence.
+     * @throws std::runtime_error If no series of the doctor and patient occurs then.
+     */
+    void skipSeriesOccurrence(Doctor &doctor, Patient &patient, Timestamp dateTime)
+    {
+        AppointmentSeries *series = findSeries(doctor.getId(), patient.getId(), dateTime);
+        if (series == nullptr)
+            throw runtime_error("Series occurrence not found.");
+
+        skipOccurrence(*series, dateTime.day());
+
+        AppointmentHandle handle;
+        if (findAppointment(doctor, patient.getId(), dateTime, handle))
+            removeAppointment(handle);
+
+        if (!_quiet)
+            interface.printMsg("Occurrence on " + dateTime.toString() + " skipped for patient " + patient.getName());
+    }
+
+    /**
+     * @brief Books the occurrences of every series that entered the active window.
+     * @param today The first day of the window.
+     * @return The number of appointments booked.
+     *
+     * Call it when the registry starts and when the date changes; series whose next
+     * occurrence is still beyond the window are passed over without being read further.
+     */
+    size_t advanceSeriesWindow(Timestamp today)
+    {
+        int32_t endDay = today.day() + SERIES_WINDOW_DAYS;
+
+        size_t booked = 0;
+        size_t conflicts = 0;
+        for (AppointmentSeries &series : _series)
+        {
+            if (series.materialized() < series.size() && series.occurrence(series.materialized()).day() < endDay)
+                booked += materializeSeries(series, endDay, conflicts);
+        }
+        return booked;
+    }
+
+    /**
+     * @brief Retrieves the recurring series.
+     * @return The series by series ID.
+     */
+    const vector<AppointmentSeries> &getSeries() const
+    {
+        return _series;
+    }
 
-    vector<Appointment> _appointments;
+    /**
+     * @brief Makes every logged mutation durable.
+     */
+    void syncStorage()
+    {
+        REGISTRY_MEASURE(SYNC);
 
-    InputOutput interface;
+        _log.commit();
+    }
 
-    const int WORK_START_HOUR = 8;
-    const int WORK_END_HOUR = 18;
-    const int APPOINTMENT_DURATION = 30;
+    /**
+     * @brief Checks whether mutations are logged to storage.
+     * @return True once openStorage() has opened the write-ahead log, false otherwise.
+     */
+    bool isLogging() const
+    {
+        return _log.isOpen();
+    }
 
-public:
     /**
-     * Checks if a patient with the given name exists in the registry.
-     * @param name The name of the patient to check for existence.
-     * @return True if a patient with the given name exists; otherwise, false.
+     * @brief Sets the function that receives the log entries of every commit once they are durable.
+     * @param listener Called with the committed entries, or empty to stop.
      */
-    bool patientExists(string &name) override
+    void setCommitListener(std::function<void(string_view)> listener)
     {
-        for (auto &patient : _patients)
+        _log.setCommitListener(std::move(listener));
+    }
+
+    /**
+     * @brief Encodes the registry as log entries that rebuild it when applied in order.
+     * @param out Receives the entries: the roster, patients, appointments, visit cards and series.
+     *
+     * Doctors are encoded as roster entries only, which the replica checks against its
+     * own roster instead of adding them; archived days are not encoded. A replica that
+     * applies the entries to a registry with the same roster gets the same IDs, so the
+     * entries committed afterwards apply to it as well.
+     */
+    void encodeState(string &out) const
+    {
+        LogRecord entry;
+
+        entry.operation = LogOperation::DOCTOR;
+        for (const Doctor &doctor : _doctors)
+        {
+            entry.doctorId = doctor.getId();
+            entry.text = doctor.getName();
+            WriteAheadLog::frame(entry, out);
+        }
+
+        entry.operation = LogOperation::ADD_PATIENT;
+        for (const Patient &patient : _patients)
+        {
+            entry.text = patient.getName();
+            entry.extra = string(patient.getDateOfBirth());
+            WriteAheadLog::frame(entry, out);
+        }
+
+        entry.operation = LogOperation::SCHEDULE;
+        for (const Appointment &appointment : _appointments)
         {
-            if (patient.getName() == name)
+            entry.doctorId = appointment.getDoctorId();
+            entry.patientId = appointment.getPatientId();
+            entry.dateTime = appointment.getDateTime();
+            WriteAheadLog::frame(entry, out);
+        }
+
+        entry.operation = LogOperation::ADD_VISIT_CARD;
+        for (const vector<HospitalVisitCard> &bucket : _visitCards)
+        {
+            for (const HospitalVisitCard &visitCard : bucket)
             {
-                return true;
+                entry.doctorId = visitCard.getDoctorId();
+                entry.patientId = visitCard.getPatientId();
+                entry.dateTime = visitCard.getDateTime();
+                entry.text = string(visitCard.getDiagnosis());
+                WriteAheadLog::frame(entry, out);
             }
         }
-        return false;
+
+        for (const AppointmentSeries &series : _series)
+        {
+            entry.operation = LogOperation::ADD_SERIES;
+            entry.doctorId = series.getDoctorId();
+            entry.patientId = series.getPatientId();
+            entry.dateTime = series.getFirst();
+            entry.interval = series.getIntervalDays();
+            entry.count = series.size();
+            WriteAheadLog::frame(entry, out);
+
+            entry.operation = LogOperation::SKIP_OCCURRENCE;
+            for (int32_t day : series.getSkipped())
+            {
+                entry.dateTime = Timestamp(day, series.getFirst().minuteOfDay());
+                WriteAheadLog::frame(entry, out);
+            }
+        }
+    }
+
+    /**
+     * @brief Applies a log entry shipped from a primary registry.
+     * @param entry The entry to apply; entries that do not fit the tables are skipped.
+     */
+    void applyReplicated(const LogRecord &entry)
+    {
+        applyLogRecord(entry);
+    }
+
+    /**
+     * Checks if a patient with the given name exists in the registry.
+     * @param name The name of the patient to check for existence.
+     * @return True if a patient with the given name exists; otherwise, false.
+     */
+    bool patientExists(string_view name) override
+    {
+        return _patientIndex.find(name) != _patientIndex.end();
+    }
+
+    /**
+     * Checks if a doctor with the given name is on the roster.
+     * @param name The name of the doctor to check for existence.
+     * @return True if a doctor with the given name exists; otherwise, false.
+     */
+    bool doctorExists(string_view name) const
+    {
+        return _doctorIndex.find(name) != _doctorIndex.end();
     }
 
     /**
@@ -65,16 +1251,14 @@ public:
      * @return Reference to the doctor object with the specified name.
      * @throws std::runtime_error If the doctor with the given name is not found.
      */
-    Doctor &findDoctorByName(string &name) override
+    Doctor &findDoctorByName(string_view name) override
     {
-        for (Doctor &doctor : _doctors)
+        auto it = _doctorIndex.find(name);
+        if (it == _doctorIndex.end())
         {
-            if (doctor.getName() == name)
-            {
-                return doctor;
-            }
+            throw runtime_error("Doctor not found.");
         }
-        throw runtime_error("Doctor not found.");
+        return _doctors[it->second];
     }
 
     /**
@@ -83,35 +1267,136 @@ public:
      * @return Reference to the patient object with the specified name.
      * @throws std::runtime_error If the patient with the given name is not found.
      */
-    Patient &findPatientByName(string &name) override
+    Patient &findPatientByName(string_view name) override
     {
-        for (Patient &patient : _patients)
+        REGISTRY_MEASURE(FIND_PATIENT);
+
+        auto it = _patientIndex.find(name);
+        if (it == _patientIndex.end())
         {
-            if (patient.getName() == name)
-            {
-                return patient;
-            }
+            throw runtime_error("Patient not found.");
         }
-        throw runtime_error("Patient not found.");
+        return _patients[it->second];
+    }
+
+    /**
+     * @brief Searches patients by date of birth, name prefix and similar spelling.
+     * @param query A date of birth, the beginning of a name or of a word of it, or a misspelled name.
+     * @param limit The maximum number of patients returned.
+     * @return The IDs of the matches: exact dates of birth first, then prefix matches, then similar names.
+     */
+    vector<PersonId> searchPatients(string_view query, size_t limit) override
+    {
+        vector<PersonId> matches;
+
+        auto born = _patientsByBirthDate.find(query);
+        if (born != _patientsByBirthDate.end())
+            matches.assign(born->second.begin(), born->second.begin() + std::min(limit, born->second.size()));
+
+        addMatches(matches, _patientSearch, query, limit);
+        return matches;
+    }
+
+    /**
+     * @brief Searches doctors by name prefix and similar spelling.
+     * @param query The beginning of a name or of a word of it, or a misspelled name.
+     * @param limit The maximum number of doctors returned.
+     * @return The IDs of the matches: prefix matches first, then similar names.
+     */
+    vector<PersonId> searchDoctors(string_view query, size_t limit) override
+    {
+        vector<PersonId> matches;
+        addMatches(matches, _doctorSearch, query, limit);
+        return matches;
     }
 
+    /**
+     * @brief Retrieves a doctor by registry ID.
+     * @param id The ID of the doctor.
+     * @return A reference to the doctor with the given ID.
+     */
+    Doctor &getDoctor(PersonId id) override { return _doctors[id]; }
+
+    /**
+     * @brief Retrieves a patient by registry ID.
+     * @param id The ID of the patient.
+     * @return A reference to the patient with the given ID.
+     */
+    Patient &getPatient(PersonId id) override { return _patients[id]; }
+
+    /**
+     * @brief Retrieves the name of a doctor by registry ID.
+     * @param id The ID of the doctor.
+     * @return A reference to the doctor's name.
+     */
+    const string &getDoctorName(PersonId id) override { return _doctors[id].getName(); }
+
+    /**
+     * @brief Retrieves the name of a patient by registry ID.
+     * @param id The ID of the patient.
+     * @return A reference to the patient's name.
+     */
+    const string &getPatientName(PersonId id) override { return _patients[id].getName(); }
+
     /**
      * @brief Retrieves the list of doctors.
-     * @return A reference to the vector containing all doctors.
+     * @return A reference to the deque containing all doctors.
      */
-    vector<Doctor> &getDoctors() override { return _doctors; }
+    deque<Doctor> &getDoctors() override { return _doctors; }
 
     /**
      * @brief Retrieves the list of patients.
-     * @return A reference to the vector containing all patients.
+     * @return A reference to the deque containing all patients.
+     */
+    deque<Patient> &getPatients() override { return _patients; }
+
+    /**
+     * @brief Retrieves the table of appointments.
+     * @return A reference to the store containing all appointments.
+     */
+    AppointmentStore &getAppointments() override { return _appointments; }
+
+    /**
+     * @brief Retrieves an appointment by handle.
+     * @param handle The handle of the appointment.
+     * @return A reference to the appointment.
+     * @throws std::out_of_range If the appointment no longer exists.
+     */
+    const Appointment &getAppointment(AppointmentHandle handle) override { return _appointments.get(handle); }
+
+    /**
+     * @brief Gets the changes of the patients and their visit cards.
+     * @return The page stamps by patient ID; a page changes when a patient or a visit card is added to it.
+     */
+    const PageStamps &patientPages() const
+    {
+        return _patientPages;
+    }
+
+    /**
+     * @brief Copies an appointment while no booking changes the store.
+     * @param handle The handle of the appointment.
+     * @return The appointment.
+     * @throws std::out_of_range If the appointment no longer exists.
      */
-    vector<Patient> &getPatients() override { return _patients; }
+    Appointment copyAppointment(AppointmentHandle handle) const
+    {
+        std::shared_lock<std::shared_mutex> store(_storeMutex);
+        return _appointments.get(handle);
+    }
 
     /**
-     * @brief Retrieves the list of appointments.
-     * @return A reference to the vector containing all appointments.
+     * @brief Locks the appointment store against bookings while another thread reads it.
+     * @return The held shared lock.
+     *
+     * Bookings of doctors in different ConcurrentRegistry shards change the store at the
+     * same time, each under the exclusive store lock; readers of the store that do not
+     * exclude every booking by other means hold this lock while they read.
      */
-    vector<Appointment> &getAppointments() override { return _appointments; }
+    std::shared_lock<std::shared_mutex> readStore() const
+    {
+        return std::shared_lock<std::shared_mutex>(_storeMutex);
+    }
 
     /**
      * @brief Schedules default appointments for a given date.
@@ -121,25 +1406,25 @@ public:
      * @param patientCount The number of patients to schedule appointments for.
      * @param startIndex The starting index for doctors and patients.
      */
-    void scheduleDefaulteAppointmentsForDate(string &date, int defaultTimeIndex, int doctorCount, int patientCount, int startIndex) override
+    void scheduleDefaulteAppointmentsForDate(Timestamp date, int defaultTimeIndex, int doctorCount, int patientCount, int startIndex) override
     {
-        vector<std::string> defaultTime = {" 17:00", " 12:30", " 08:30", " 14:00", " 13:30", " 09:00", " 15:00", " 10:00"};
+        static const int defaultTime[] = {17 * 60, 12 * 60 + 30, 8 * 60 + 30, 14 * 60, 13 * 60 + 30, 9 * 60, 15 * 60, 10 * 60};
+        const int defaultTimeCount = sizeof(defaultTime) / sizeof(defaultTime[0]);
+
+        vector<ScheduleRequest> requests;
+        requests.reserve(max(0, doctorCount - startIndex) * max(0, patientCount - startIndex));
 
         for (int i = startIndex; i < doctorCount; ++i)
         {
             for (int j = startIndex; j < patientCount; ++j)
             {
-                std::string dateTime = date + defaultTime[defaultTimeIndex];
-                _doctors[i].addAppointment(dateTime, _patients[j].getName(), _doctors[i].getName());
-
-                _patients[j]
-                    .addAppointment(dateTime, _patients[j].getName(), _doctors[i].getName());
+                requests.push_back(ScheduleRequest{Timestamp(date.day(), defaultTime[defaultTimeIndex]), _doctors[i].getId(), _patients[j].getId()});
 
-                _appointments.push_back(Appointment(dateTime, _doctors[i], _patients[j]));
-
-                defaultTimeIndex = (defaultTimeIndex - 1 + defaultTime.size()) % defaultTime.size();
+                defaultTimeIndex = (defaultTimeIndex - 1 + defaultTimeCount) % defaultTimeCount;
             }
         }
+
+        scheduleAppointments(requests);
     }
 
     /**
@@ -152,8 +1437,8 @@ public:
     void generateDefaultAppointments() override
     {
         int defaultTimeIndex = 0;
-        string today_date = getTodayDate();
-        string tomorrow_date = getTomorrowDate();
+        Timestamp today_date = Timestamp::parse(getTodayDate());
+        Timestamp tomorrow_date = Timestamp::parse(getTomorrowDate());
         int startIndex = 0;
 
         scheduleDefaulteAppointmentsForDate(today_date, defaultTimeIndex, _doctors.size() / 2, _patients.size() / 2, startIndex);
@@ -166,52 +1451,75 @@ public:
 
     /**
      * Cancels an appointment for a given date and time, patient name, and doctor name.
-     * Removes the appointment from the registry and updates the doctor's and patient's records.
+     * Looks the appointment up in the doctor's index and cancels it by handle.
      * @param dateTime The date and time of the appointment to cancel.
      * @param patientName The name of the patient associated with the appointment.
      * @param doctorName The name of the doctor associated with the appointment.
+     * @return True if the appointment existed and was canceled, false otherwise.
      */
-    void cancelAppointment(string &dateTime, string &patientName, string &doctorName) override
+    bool cancelAppointment(Timestamp dateTime, string_view patientName, string_view doctorName) override
     {
-        _appointments.erase(std::remove_if(_appointments.begin(), _appointments.end(),
-                                           [&dateTime, &patientName, &doctorName](Appointment &app)
-                                           {
-                                               return (app.getDateTime() == dateTime && app.getPatient().getName() == patientName && app.getDoctor().getName() == doctorName);
-                                           }),
-                            _appointments.end());
-
         Doctor &doctor = findDoctorByName(doctorName);
 
-        doctor.deleteAppointment(dateTime, patientName, doctorName);
-
         Patient &patient = findPatientByName(patientName);
 
-        patient.deleteAppointment(dateTime, patientName, doctorName);
+        AppointmentHandle handle;
+        if (!findAppointment(doctor, patient.getId(), dateTime, handle))
+        {
+            if (!_quiet)
+                interface.printMsg("No appointment on " + dateTime.toString() + " found for patient " + patient.getName() + " with Dr. " + doctor.getName());
+            return false;
+        }
+
+        cancelAppointment(handle);
+        return true;
+    }
+
+    /**
+     * Cancels an appointment by handle.
+     * Removes the appointment from the store and from the doctor's and patient's indices.
+     * An occurrence of a recurring series is also skipped, so it is not booked again.
+     * @param handle The handle of the appointment to cancel.
+     * @throws std::out_of_range If the appointment no longer exists.
+     */
+    void cancelAppointment(AppointmentHandle handle) override
+    {
+        REGISTRY_MEASURE(CANCEL);
+
+        Appointment appointment = copyAppointment(handle);
+
+        Timestamp dateTime = appointment.getDateTime();
+        Patient &patient = _patients[appointment.getPatientId()];
+
+        if (AppointmentSeries *series = findSeries(appointment.getDoctorId(), patient.getId(), dateTime))
+            skipOccurrence(*series, dateTime.day());
+
+        removeAppointment(handle);
 
-        interface.printMsg("Appointment on " + dateTime + " canceled for patient " + patientName);
+        if (!_quiet)
+            interface.printMsg("Appointment on " + dateTime.toString() + " canceled for patient " + patient.getName());
     }
 
     /**
      * @brief Retrieves all visit cards for a given patient.
      * @param patient The patient whose visit cards are to be retrieved.
-     * @return A vector of HospitalVisitCard objects associated with the patient.
+     * @return A constant reference to the visit cards associated with the patient.
      *
-     * This method searches through all visit cards and returns those that belong
-     * to the specified patient.
+     * This method returns the patient's bucket of visit cards directly, without
+     * scanning or copying the cards of other patients.
      */
-    vector<HospitalVisitCard> getVisitCardsForPatient(Patient &patient) override
+    const vector<HospitalVisitCard> &getVisitCardsForPatient(const Patient &patient) override
     {
-        vector<HospitalVisitCard> patientVisitCards;
+        REGISTRY_MEASURE(VISIT_CARDS);
 
-        for (auto &visitCard : _visitCards)
+        static const vector<HospitalVisitCard> noVisitCards;
+
+        if (patient.getId() >= _visitCards.size())
         {
-            if (visitCard.getPatientName() == patient.getName())
-            {
-                patientVisitCards.push_back(visitCard);
-            }
+            return noVisitCards;
         }
 
-        return patientVisitCards;
+        return _visitCards[patient.getId()];
     }
 
     /**
@@ -220,40 +1528,41 @@ public:
      * @param patient The patient who is receiving the visit card.
      * @param dateTime The date and time of the visit.
      * @param diagnosis The diagnosis given to the patient.
-     * @return The newly created HospitalVisitCard object.
+     * @return A reference to the stored visit card, valid until the patient's next visit card is added.
      *
-     * This method creates a new visit card with the provided details and adds it
-     * to the list of visit cards.
+     * This method constructs the visit card in place in the patient's bucket of visit cards.
      */
-    HospitalVisitCard addHospitalVisitCard(Doctor &doctor, Patient &patient, string &dateTime, string &diagnosis) override
+    const HospitalVisitCard &addHospitalVisitCard(const Doctor &doctor, const Patient &patient, Timestamp dateTime, string_view diagnosis) override
     {
-        HospitalVisitCard visitCard(doctor, patient, dateTime, diagnosis);
-        _visitCards.push_back(visitCard);
+        REGISTRY_MEASURE(ADD_VISIT_CARD);
 
-        return visitCard;
+        return storeVisitCard(doctor.getId(), patient.getId(), dateTime, diagnosis);
     }
 
     /**
-     * Adds a new patient to the registry with the specified name and age.
+     * Adds a new patient to the registry with the specified name and date of birth.
      * If a patient with the same name already exists, returns the existing patient.
      * @param name The name of the new patient.
-     * @param age The age of the new patient.
-     * @return The newly added patient or the existing patient if one with the same name already exists.
+     * @param dateOfBirth The date of birth of the new patient.
+     * @return A reference to the newly added patient or to the existing patient with the same name.
      */
-    Patient addPatient(string &name, string &age) override
+    Patient &addPatient(string_view name, string_view dateOfBirth) override
     {
-        if (patientExists(name))
+        REGISTRY_MEASURE(ADD_PATIENT);
+
+        auto existing = _patientIndex.find(name);
+        if (existing != _patientIndex.end())
         {
-            interface.printMsg("Patient " + name + " already exists.");
+            if (!_quiet)
+                interface.printMsg("Patient " + string(name) + " already exists.");
 
-            return findPatientByName(name);
+            return _patients[existing->second];
         }
 
-        Patient patient = Patient(name, age);
-
-        _patients.push_back(patient);
+        Patient &patient = registerPatient(name, dateOfBirth);
 
-        interface.printMsg("Patient " + name + " added to the registry.");
+        if (!_quiet)
+            interface.printMsg("Patient " + patient.getName() + " added to the registry.");
 
         return patient;
     }
@@ -262,149 +1571,380 @@ public:
      * @brief Retrieves available appointment times for a specific doctor on a given date.
      * @param date The date for which to retrieve available appointment times.
      * @param doctorName The name of the doctor.
-     * @return A vector of pairs representing available appointment times and the corresponding doctor's name.
+     * @return The start of each free slot of the doctor paired with the doctor's ID, in time order.
+     * @throws std::runtime_error If the doctor with the given name is not found.
      *
-     * This method retrieves all available appointment times for the specified doctor
-     * on the provided date and returns them as a vector of pairs, where each pair consists
-     * of the appointment time and the doctor's name.
+     * The slots are read from the doctor's mask of the day on the free slot board, the
+     * same way getAvailableTimes reads them for every doctor.
      */
-    vector<pair<string, string>> getAvailableTimesForDoctor(string &date, string &doctorName) override
+    vector<pair<Timestamp, PersonId>> getAvailableTimesForDoctor(Timestamp date, string_view doctorName) override
     {
-        vector<pair<string, string>> availableTimes;
+        REGISTRY_MEASURE(AVAILABLE_TIMES);
 
-        vector<pair<string, string>> allAvailableTimes = getAvailableTimes(date);
+        vector<pair<Timestamp, PersonId>> availableTimes;
 
-        for (const auto &timeDoctorPair : allAvailableTimes)
-        {
-            if (timeDoctorPair.second == doctorName)
-            {
-                availableTimes.push_back(timeDoctorPair);
-            }
-        }
+        appendAvailableTimes(findDoctorByName(doctorName), _freeSlots.day(date.day()), date, availableTimes);
 
         return availableTimes;
     }
 
     /**
      * Schedules an appointment for the specified date and time with the given doctor and patient.
-     * If the doctor is available at the specified date and time, adds the appointment to the registry
-     * and updates the doctor's and patient's records.
+     * If the doctor is available at the specified date and time, adds the appointment to the store
+     * and records its handle in the doctor's and patient's indices.
      * @param dateTime The date and time of the appointment.
      * @param doctor Reference to the doctor who will conduct the appointment.
      * @param patient Reference to the patient who scheduled the appointment.
      */
-    void scheduleAppointment(string &dateTime, Doctor &doctor, Patient &patient) override
+    void scheduleAppointment(Timestamp dateTime, Doctor &doctor, Patient &patient) override
     {
-        if (doctor.isAvailable(dateTime))
+        REGISTRY_MEASURE(SCHEDULE);
+
+        if (!isArchived(dateTime.day()) && doctor.isAvailable(dateTime))
         {
+            bookAppointment(dateTime, doctor, patient);
 
-            doctor.addAppointment(dateTime, patient.getName(), doctor.getName());
+            if (!_quiet)
+                interface.printMsg("Appointment scheduled for " + dateTime.toString() + " with Dr. " + doctor.getName() + " for patient " + patient.getName());
+        }
+        else
+        {
+            if (!_quiet)
+                interface.printMsg("Sorry, Dr. " + doctor.getName() + " is not available at " + dateTime.toString() + ". Please choose another time.");
+        }
+    }
 
-            Patient &registeredPatient = findPatientByName(patient.getName());
+    /**
+     * Schedules many appointments in one pass.
+     * Requests are grouped by doctor and day so every group is checked against a single
+     * read of the doctor's slot mask, conflicts inside the batch are detected while
+     * walking the group, and store capacity is reserved once for all accepted bookings.
+     * @param requests The bookings to make; when two requests ask for the same slot the earlier one wins.
+     * @return One result per request, in the order of the requests.
+     */
+    vector<ScheduleResult> scheduleAppointments(const vector<ScheduleRequest> &requests) override
+    {
+        REGISTRY_MEASURE(SCHEDULE_BATCH);
 
-            registeredPatient.addAppointment(dateTime, patient.getName(), doctor.getName());
+        vector<ScheduleResult> results(requests.size());
+        vector<uint32_t> order;
+        order.reserve(requests.size());
 
-            Appointment newAppointment(dateTime, doctor, registeredPatient);
+        for (uint32_t i = 0; i < requests.size(); ++i)
+        {
+            const ScheduleRequest &request = requests[i];
+
+            if (request.doctorId >= _doctors.size() || request.patientId >= _patients.size())
+                results[i].status = ScheduleStatus::UNKNOWN_PERSON;
+            else if (_doctors[request.doctorId].getCalendar().slotIndex(request.dateTime.minuteOfDay()) < 0)
+                results[i].status = ScheduleStatus::OFF_GRID;
+            else
+                order.push_back(i);
+        }
 
-            _appointments.push_back(newAppointment);
+        stable_sort(order.begin(), order.end(), [&requests](uint32_t left, uint32_t right)
+                    {
+                        const ScheduleRequest &a = requests[left];
+                        const ScheduleRequest &b = requests[right];
+                        if (a.doctorId != b.doctorId)
+                            return a.doctorId < b.doctorId;
+                        return a.dateTime.day() < b.dateTime.day(); });
+
+        size_t accepted = 0;
+        for (size_t begin = 0; begin < order.size();)
+        {
+            const ScheduleRequest &first = requests[order[begin]];
+            int32_t day = first.dateTime.day();
+            const SlotCalendar &calendar = _doctors[first.doctorId].getCalendar();
+            SlotCalendar::SlotMask freeSlots = isArchived(day) ? 0 : calendar.freeMask(day);
+            SlotCalendar::SlotMask claimed = 0;
+
+            size_t end = begin;
+            for (; end < order.size() && requests[order[end]].doctorId == first.doctorId && requests[order[end]].dateTime.day() == day; ++end)
+            {
+                SlotCalendar::SlotMask bit = SlotCalendar::SlotMask(1) << calendar.slotIndex(requests[order[end]].dateTime.minuteOfDay());
+                ScheduleResult &result = results[order[end]];
+
+                if ((freeSlots & bit) == 0)
+                    result.status = ScheduleStatus::SLOT_TAKEN;
+                else if (claimed & bit)
+                    result.status = ScheduleStatus::CONFLICT;
+                else
+                {
+                    result.status = ScheduleStatus::SCHEDULED;
+                    claimed |= bit;
+                    accepted++;
+                }
+            }
+            begin = end;
+        }
 
-            interface.printMsg("Appointment scheduled for " + dateTime + " with Dr. " + doctor.getName() + " for patient " + registeredPatient.getName());
+        {
+            std::lock_guard<std::shared_mutex> store(_storeMutex);
+            _appointments.reserve(_appointments.size() + accepted);
         }
-        else
+
+        for (uint32_t index : order)
         {
-            interface.printMsg("Sorry, Dr. " + doctor.getName() + " is not available at " + dateTime + ". Please choose another time.");
+            if (results[index].status != ScheduleStatus::SCHEDULED)
+                continue;
+
+            const ScheduleRequest &request = requests[index];
+            results[index].handle = bookAppointment(request.dateTime, _doctors[request.doctorId], _patients[request.patientId]);
         }
+
+        return results;
     }
 
     /**
      * Retrieves the names of doctors available on the specified date.
      * @param date The date for which available doctors are to be retrieved.
      * @return A vector containing the names of doctors available on the specified date.
+     *
+     * Availability is read from the free slot board, so the query is one lookup of the
+     * day and a scan of one mask per doctor, and it runs while bookings change the masks.
      */
-    vector<string> getAvailableDoctors(string &date) override
+    vector<string> getAvailableDoctors(Timestamp date) override
     {
-        vector<string> availableDoctors;
+        REGISTRY_MEASURE(AVAILABLE_DOCTORS);
 
-        vector<pair<string, string>> availableTimes = getAvailableTimes(date);
+        FreeSlotBoard::Day day = _freeSlots.day(date.day());
 
-        set<string> uniqueDoctors;
-
-        for (auto &timeDoctorPair : availableTimes)
+        vector<string> availableDoctors;
+        for (PersonId id = 0; id < _doctors.size(); ++id)
         {
-            uniqueDoctors.insert(timeDoctorPair.second);
+            if (day.freeMask(id) != 0)
+                availableDoctors.push_back(_doctors[id].getName());
         }
+        return availableDoctors;
+    }
 
-        for (auto &doctor : _doctors)
+    /**
+     * @brief Retrieves the doctors with free slots on a date, most free slots first.
+     * @param date The date to check.
+     * @return The ID and number of free slots of each doctor with at least one free slot; ties keep roster order.
+     */
+    vector<pair<PersonId, int>> getDoctorsByCapacity(Timestamp date) override
+    {
+        REGISTRY_MEASURE(AVAILABLE_DOCTORS);
+
+        FreeSlotBoard::Day day = _freeSlots.day(date.day());
+
+        vector<pair<PersonId, int>> doctors;
+        doctors.reserve(_doctors.size());
+        for (PersonId id = 0; id < _doctors.size(); ++id)
         {
-            if (uniqueDoctors.find(doctor.getName()) != uniqueDoctors.end())
-            {
-                availableDoctors.push_back(doctor.getName());
-            }
+            int freeSlots = day.freeCount(id);
+            if (freeSlots > 0)
+                doctors.emplace_back(id, freeSlots);
         }
 
-        return availableDoctors;
+        stable_sort(doctors.begin(), doctors.end(), [](const pair<PersonId, int> &a, const pair<PersonId, int> &b)
+                    { return a.second > b.second; });
+        return doctors;
     }
 
     /**
-     * @brief Retrieves the names of doctors available for appointments on a given date.
-     * @param date The date for which to retrieve available doctors.
-     * @return A vector containing the names of doctors available for appointments.
+     * @brief Retrieves the free slots of every doctor on a given date.
+     * @param date The date for which to retrieve available times.
+     * @return The start of each free slot paired with the ID of its doctor, grouped by doctor in roster order.
      *
-     * This method retrieves the names of doctors who have available appointment times
-     * on the specified date. It first retrieves all available appointment times for the
-     * given date and then extracts the names of doctors from these appointment times.
+     * Each doctor's free slots are read from its mask of the day on the free slot board,
+     * so no appointment is visited, no name is copied and no lock is waited for while
+     * bookings run; callers resolve the IDs with getDoctorName when they print.
      */
-    vector<pair<string, string>> getAvailableTimes(string &date) override
+    vector<pair<Timestamp, PersonId>> getAvailableTimes(Timestamp date) override
     {
-        vector<pair<string, string>> availableTimes;
+        REGISTRY_MEASURE(AVAILABLE_TIMES);
 
-        for (Doctor &doctor : _doctors)
+        FreeSlotBoard::Day day = _freeSlots.day(date.day());
+        return collectPerDoctor<pair<Timestamp, PersonId>>([&day, date](Doctor &doctor, vector<pair<Timestamp, PersonId>> &availableTimes)
+                                                           { appendAvailableTimes(doctor, day, date, availableTimes); });
+    }
+
+    /**
+     * @brief Lists the free slots of every doctor over a range of days, lazily.
+     * @param from The earliest start of a listed slot.
+     * @param days The number of days in the range, starting with the day of from.
+     * @return The range of free slots in chronological order.
+     */
+    FreeSlotRange getFreeSlots(Timestamp from, int days)
+    {
+        return FreeSlotRange(_doctors, _freeSlots, 0, _doctors.size(), from, days);
+    }
+
+    /**
+     * @brief Lists the free slots of one doctor over a range of days, lazily.
+     * @param from The earliest start of a listed slot.
+     * @param days The number of days in the range, starting with the day of from.
+     * @param doctorName The name of the doctor.
+     * @return The range of free slots in chronological order.
+     * @throws std::runtime_error If the doctor with the given name is not found.
+     */
+    FreeSlotRange getFreeSlots(Timestamp from, int days, string_view doctorName)
+    {
+        PersonId id = findDoctorByName(doctorName).getId();
+        return FreeSlotRange(_doctors, _freeSlots, id, id + 1, from, days);
+    }
+
+    /**
+     * @brief Finds the earliest free slot of any doctor in a range of days.
+     * @param from The earliest acceptable start of the slot.
+     * @param days The number of days to search, starting with the day of from.
+     * @param slot Receives the earliest free slot; ties go to the lowest doctor ID.
+     * @return True if a free slot was found, false otherwise.
+     */
+    bool findEarliestFreeSlot(Timestamp from, int days, FreeSlot &slot) override
+    {
+        REGISTRY_MEASURE(FREE_SLOT_SEARCH);
+
+        FreeSlotRange range = getFreeSlots(from, days);
+        FreeSlotRange::iterator first = range.begin();
+        if (first == range.end())
+            return false;
+
+        slot = *first;
+        return true;
+    }
+
+    /**
+     * @brief Finds the earliest free slot of one doctor in a range of days.
+     * @param from The earliest acceptable start of the slot.
+     * @param days The number of days to search, starting with the day of from.
+     * @param doctorName The name of the doctor.
+     * @param slot Receives the earliest free slot.
+     * @return True if a free slot was found, false otherwise.
+     * @throws std::runtime_error If the doctor with the given name is not found.
+     */
+    bool findEarliestFreeSlot(Timestamp from, int days, string_view doctorName, FreeSlot &slot) override
+    {
+        REGISTRY_MEASURE(FREE_SLOT_SEARCH);
+
+        FreeSlotRange range = getFreeSlots(from, days, doctorName);
+        FreeSlotRange::iterator first = range.begin();
+        if (first == range.end())
+            return false;
+
+        slot = *first;
+        return true;
+    }
+
+    /**
+     * @brief Retrieves the doctors with at least a given number of free slots in a range of days.
+     * @param date The first day of the range.
+     * @param days The number of days in the range.
+     * @param minimum The number of free slots a doctor needs.
+     * @return The IDs of the matching doctors, in roster order.
+     *
+     * The free slots are counted from the masks of the free slot board, with one lookup
+     * per day instead of one per doctor and day.
+     */
+    vector<PersonId> getDoctorsWithFreeSlots(Timestamp date, int days, int minimum) override
+    {
+        REGISTRY_MEASURE(FREE_SLOT_SEARCH);
+
+        vector<int> freeSlots(_doctors.size(), 0);
+        for (int32_t day = date.day(); day < date.day() + days; ++day)
         {
-            for (int hour = WORK_START_HOUR; hour < WORK_END_HOUR; ++hour)
-            {
-                for (int minute = 0; minute < 60; minute += APPOINTMENT_DURATION)
-                {
-                    char buffer[10];
+            FreeSlotBoard::Day masks = _freeSlots.day(day);
+            for (PersonId id = 0; id < _doctors.size(); ++id)
+                freeSlots[id] += masks.freeCount(id);
+        }
 
-                    snprintf(buffer, sizeof(buffer), "%02d:%02d", hour, minute);
+        vector<PersonId> doctors;
+        for (PersonId id = 0; id < _doctors.size(); ++id)
+        {
+            if (freeSlots[id] >= minimum)
+                doctors.push_back(id);
+        }
+        return doctors;
+    }
 
-                    string time = buffer;
+#ifdef REGISTRY_METRICS
+    /**
+     * @brief Describes the operation histograms, index sizes and table memory as lines of "name{labels} value".
+     * @return The report, one metric per line.
+     *
+     * Table memory is estimated from container capacities and includes the names and
+     * appointment handles of people and the calendars of doctors; interned strings are
+     * reported separately.
+     */
+    vector<string> metricsReport() const
+    {
+        vector<string> lines;
+        RegistryMetrics::global().report(lines);
 
-                    string dateTime = date + " " + time;
+        auto gauge = [&lines](const string &name, const string &label, size_t value)
+        { lines.push_back(name + '{' + label + "} " + std::to_string(value)); };
 
-                    if (doctor.isAvailable(dateTime))
-                    {
-                        availableTimes.push_back(make_pair(dateTime, doctor.getName()));
-                    }
-                }
-            }
+        size_t doctorBytes = _doctors.size() * sizeof(Doctor);
+        for (const Doctor &doctor : _doctors)
+            doctorBytes += doctor.getName().capacity() + doctor.getAppointments().capacity() * (sizeof(AppointmentHandle) + sizeof(Timestamp)) + doctor.getCalendar().memoryUsage();
+
+        size_t patientBytes = _patients.size() * sizeof(Patient);
+        for (const Patient &patient : _patients)
+            patientBytes += patient.getName().capacity() + patient.getAppointments().capacity() * sizeof(AppointmentHandle);
+
+        size_t visitCards = 0;
+        size_t visitCardBytes = _visitCards.capacity() * sizeof(vector<HospitalVisitCard>);
+        for (const vector<HospitalVisitCard> &bucket : _visitCards)
+        {
+            visitCards += bucket.size();
+            visitCardBytes += bucket.capacity() * sizeof(HospitalVisitCard);
         }
 
-        return availableTimes;
+        auto indexBytes = [](const unordered_map<string_view, size_t> &index)
+        { return index.bucket_count() * sizeof(void *) + index.size() * (sizeof(pair<const string_view, size_t>) + 2 * sizeof(void *)); };
+
+        gauge("registry_index_entries", "index=\"doctor_name\"", _doctorIndex.size());
+        gauge("registry_index_entries", "index=\"patient_name\"", _patientIndex.size());
+        gauge("registry_index_entries", "index=\"interned_strings\"", _strings.size());
+        gauge("registry_index_entries", "index=\"birth_dates\"", _patientsByBirthDate.size());
+
+        gauge("registry_table_rows", "table=\"doctors\"", _doctors.size());
+        gauge("registry_table_rows", "table=\"patients\"", _patients.size());
+        gauge("registry_table_rows", "table=\"appointments\"", _appointments.size());
+        gauge("registry_table_rows", "table=\"visit_cards\"", visitCards);
+        gauge("registry_table_rows", "table=\"series\"", _series.size());
+
+        gauge("registry_table_bytes", "table=\"doctors\"", doctorBytes);
+        gauge("registry_table_bytes", "table=\"patients\"", patientBytes);
+        gauge("registry_table_bytes", "table=\"appointments\"", _appointments.memoryUsage());
+        gauge("registry_table_bytes", "table=\"visit_cards\"", visitCardBytes);
+        gauge("registry_table_bytes", "table=\"free_slots\"", _freeSlots.memoryUsage());
+        gauge("registry_table_bytes", "table=\"name_indices\"", indexBytes(_doctorIndex) + indexBytes(_patientIndex));
+        gauge("registry_table_bytes", "table=\"interned_strings\"", _strings.bytes());
+        gauge("registry_table_bytes", "table=\"archive_memory\"", _archive.memoryUsage());
+
+        gauge("registry_archive_days", "storage=\"cold\"", _archive.size());
+        gauge("registry_archive_bytes", "storage=\"cold\"", _archive.bytes());
+
+        return lines;
     }
+#endif
 
     /**
-     * @brief Retrieves an item from a vector by index.
-     * @tparam T The type of item in the vector.
+     * @brief Retrieves an item from a container by index.
+     * @tparam Container The random-access container type (vector or deque).
      * @param index The index of the item to retrieve.
-     * @param items The vector containing the items.
+     * @param items The container holding the items.
      * @return A reference to the item at the specified index.
      * @throws std::out_of_range If the index is out of bounds.
      *
-     * This template method retrieves an item from the specified vector by its index.
-     * It checks if the index is within the bounds of the vector and returns a reference
+     * This template method retrieves an item from the specified container by its index.
+     * It checks if the index is within the bounds of the container and returns a reference
      * to the item at that index. If the index is out of bounds, it throws an std::out_of_range
      * exception with an appropriate error message.
      */
-    template <typename T>
-    T &getByIndex(int index, vector<T> &items)
+    template <typename Container>
+    typename Container::value_type &getByIndex(int index, Container &items)
     {
-        if (index >= 0 && index < items.size())
+        if (index >= 0 && static_cast<size_t>(index) < items.size())
         {
             return items[index];
         }
         throw std::out_of_range("Invalid index.");
-    };
+    }
 
     /**
      * @brief Displays all scheduled appointments.
@@ -412,17 +1952,65 @@ public:
      * This method displays all scheduled appointments by iterating through the list
      * of appointments and passing relevant information to the interface for display.
      */
-
     void showAppointments() override
+    {
+        showAppointments(0, _appointments.size());
+    }
+
+    /**
+     * @brief Displays a page of the scheduled appointments.
+     * @param first The position of the first appointment to display.
+     * @param count The maximum number of appointments to display.
+     *
+     * Appointments keep the numbers of their position in the whole table, so a number
+     * seen on any page selects the same appointment. The page is formatted into text and
+     * written in chunks of about InputOutput::WRITE_CHUNK bytes; pages of at least
+     * PARALLEL_THRESHOLD appointments are formatted on the worker pool.
+     */
+    void showAppointments(size_t first, size_t count) override
     {
         interface.headerMsg("Appointments");
 
-        int index = 1;
-        for (auto &appointment : _appointments)
+        first = std::min(first, _appointments.size());
+        size_t last = first + std::min(count, _appointments.size() - first);
+
+        if (last - first < PARALLEL_THRESHOLD)
         {
-            interface.showAppointment(index, appointment.getDateTime(), appointment.getDoctor().getName(), appointment.getPatient().getName());
+            string text;
+            for (size_t position = first; position < last; ++position)
+            {
+                const Appointment &appointment = _appointments.begin()[position];
+                InputOutput::formatAppointment(text, position + 1, appointment.getDateTime(),
+                                               _doctors[appointment.getDoctorId()].getName(),
+                                               _patients[appointment.getPatientId()].getName());
+
+                if (text.size() >= InputOutput::WRITE_CHUNK)
+                {
+                    interface.printText(text);
+                    text.clear();
+                }
+            }
+            interface.printText(text);
+            return;
+        }
 
-            index++;
+        size_t chunkCount = (last - first + ITEMS_PER_CHUNK - 1) / ITEMS_PER_CHUNK;
+        vector<string> parts(chunkCount);
+
+        WorkerPool::shared().run(chunkCount, [&](size_t chunk)
+                                 {
+                                     size_t end = std::min(last, first + (chunk + 1) * ITEMS_PER_CHUNK);
+                                     for (size_t position = first + chunk * ITEMS_PER_CHUNK; position < end; ++position)
+                                     {
+                                         const Appointment &appointment = _appointments.begin()[position];
+                                         InputOutput::formatAppointment(parts[chunk], position + 1, appointment.getDateTime(),
+                                                                        _doctors[appointment.getDoctorId()].getName(),
+                                                                        _patients[appointment.getPatientId()].getName());
+                                     } });
+
+        for (const string &part : parts)
+        {
+            interface.printText(part);
         }
     }
 };
\ No newline at end of file
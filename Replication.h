@@ -0,0 +1,409 @@
+/**
+ * @class LogShipper
+ * @brief Streams the write-ahead log of a primary registry to read replicas over TCP.
+ *
+ * A replica that connects first receives the current state of the registry encoded as
+ * log entries and a checkpoint entry marking its end, and from then on every commit of
+ * the primary's log as it was written to disk. Entries are shipped only once they are
+ * durable, so a replica never shows a change the primary could lose in a crash.
+ *
+ * One thread accepts replicas and sends their backlog with non-blocking writes, so a
+ * slow replica never holds up a commit. A replica whose backlog grows beyond
+ * MAX_BACKLOG is disconnected and has to be restarted to follow again.
+ */
+class LogShipper
+{
+public:
+    static constexpr size_t MAX_BACKLOG = 64 * 1024 * 1024; ///< Unsent bytes after which a replica is dropped.
+
+private:
+    /**
+     * @struct Follower
+     * @brief A connected replica.
+     */
+    struct Follower
+    {
+        int fd;        ///< The replica socket.
+        string output; ///< Entries not yet sent.
+        bool lagging;  ///< The backlog overflowed; the replica is dropped.
+    };
+
+    ConcurrentRegistry &registry;
+
+    int _listenFd = -1;                 ///< The listening socket.
+    int _wakeFds[2] = {-1, -1};         ///< Pipe a commit uses to wake the shipping thread.
+    vector<Follower> _followers;        ///< Connected replicas; only the shipping thread adds or removes them.
+    std::mutex _followerMutex;          ///< Guards the backlogs of _followers.
+    std::thread _thread;                ///< The shipping thread.
+    std::atomic<bool> _stopping{false}; ///< Tells the shipping thread to exit.
+
+    /**
+     * @brief Adds committed entries to the backlog of every replica.
+     * @param entries The committed entries.
+     */
+    void publish(string_view entries)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_followerMutex);
+            for (Follower &follower : _followers)
+            {
+                if (follower.output.size() + entries.size() > MAX_BACKLOG)
+                    follower.lagging = true;
+                else if (!follower.lagging)
+                    follower.output.append(entries.data(), entries.size());
+            }
+        }
+
+        char wake = 1;
+        while (::write(_wakeFds[1], &wake, 1) < 0 && errno == EINTR)
+            ;
+    }
+
+    /**
+     * @brief Accepts every pending replica and queues the state of the registry for it.
+     */
+    void acceptFollowers()
+    {
+        while (true)
+        {
+            int fd = ::accept(_listenFd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    std::cerr << "Cannot accept replica: " << strerror(errno) << endl;
+                return;
+            }
+
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+            registry.exportState([&](const string &state)
+                                 {
+                                     LogRecord checkpoint;
+                                     checkpoint.operation = LogOperation::CHECKPOINT;
+
+                                     std::lock_guard<std::mutex> lock(_followerMutex);
+                                     Follower &follower = _followers.emplace_back(Follower{fd, state, false});
+                                     WriteAheadLog::frame(checkpoint, follower.output); });
+        }
+    }
+
+    /**
+     * @brief Sends as much of a backlog as the socket accepts.
+     * @param follower The replica.
+     * @return False if the replica disconnected or failed, true otherwise.
+     */
+    static bool transmit(Follower &follower)
+    {
+        size_t sent = 0;
+        while (sent < follower.output.size())
+        {
+            ssize_t written = ::send(follower.fd, follower.output.data() + sent, follower.output.size() - sent, MSG_NOSIGNAL);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    return false;
+                break;
+            }
+            sent += written;
+        }
+        follower.output.erase(0, sent);
+        return true;
+    }
+
+    /**
+     * @brief Runs the shipping thread until the shipper is destroyed.
+     */
+    void ship()
+    {
+        vector<pollfd> descriptors;
+
+        while (!_stopping)
+        {
+            descriptors.clear();
+            descriptors.push_back(pollfd{_wakeFds[0], POLLIN, 0});
+            descriptors.push_back(pollfd{_listenFd, POLLIN, 0});
+            {
+                std::lock_guard<std::mutex> lock(_followerMutex);
+                for (const Follower &follower : _followers)
+                    descriptors.push_back(pollfd{follower.fd, short(follower.output.empty() ? POLLIN : POLLIN | POLLOUT), 0});
+            }
+
+            if (::poll(descriptors.data(), descriptors.size(), -1) < 0 && errno != EINTR)
+            {
+                std::cerr << "Cannot poll replicas: " << strerror(errno) << endl;
+                return;
+            }
+
+            char drain[256];
+            while (::read(_wakeFds[0], drain, sizeof(drain)) > 0)
+                ;
+
+            {
+                std::lock_guard<std::mutex> lock(_followerMutex);
+                for (size_t i = 0, polled = descriptors.size() - 2; i < _followers.size();)
+                {
+                    Follower &follower = _followers[i];
+                    short revents = i < polled ? descriptors[i + 2].revents : 0;
+
+                    char ignored[256];
+                    bool healthy = !follower.lagging && !(revents & (POLLERR | POLLNVAL));
+                    if (healthy && (revents & (POLLIN | POLLHUP)))
+                        healthy = ::recv(follower.fd, ignored, sizeof(ignored), 0) != 0;
+                    if (healthy && !follower.output.empty())
+                        healthy = transmit(follower);
+
+                    if (healthy)
+                    {
+                        ++i;
+                        continue;
+                    }
+
+                    if (follower.lagging)
+                        std::cerr << "Replica dropped: its backlog exceeded " << MAX_BACKLOG << " bytes" << endl;
+                    ::close(follower.fd);
+                    _followers.erase(_followers.begin() + i);
+                    descriptors.erase(descriptors.begin() + 2 + i);
+                    polled--;
+                }
+            }
+
+            if (descriptors[1].revents & POLLIN)
+                acceptFollowers();
+        }
+    }
+
+public:
+    /**
+     * @brief Constructs a shipper for the given registry, which must log to storage.
+     * @param reg Reference to the thread-safe registry.
+     */
+    LogShipper(ConcurrentRegistry &reg) : registry(reg) {}
+
+    LogShipper(const LogShipper &) = delete;
+    LogShipper &operator=(const LogShipper &) = delete;
+
+    ~LogShipper()
+    {
+        if (_thread.joinable())
+        {
+            registry.setCommitListener(nullptr);
+
+            _stopping = true;
+            char wake = 1;
+            while (::write(_wakeFds[1], &wake, 1) < 0 && errno == EINTR)
+                ;
+            _thread.join();
+        }
+
+        for (const Follower &follower : _followers)
+            ::close(follower.fd);
+        for (int fd : {_listenFd, _wakeFds[0], _wakeFds[1]})
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+
+    /**
+     * @brief Starts accepting replicas and shipping commits to them.
+     * @param port The TCP port replicas connect to.
+     * @throws std::runtime_error If the port cannot be opened.
+     */
+    void start(uint16_t port)
+    {
+        _listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+
+        if (_listenFd < 0 || setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            ::bind(_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(_listenFd, RegistryServer::LISTEN_BACKLOG) != 0 || ::pipe(_wakeFds) != 0)
+        {
+            throw runtime_error("Cannot ship the log on port " + std::to_string(port) + ": " + strerror(errno));
+        }
+        for (int fd : {_listenFd, _wakeFds[0], _wakeFds[1]})
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+        registry.setCommitListener([this](string_view entries)
+                                   { publish(entries); });
+        _thread = std::thread(&LogShipper::ship, this);
+
+        cout << "Shipping the log to replicas on port " << port << endl;
+    }
+};
+
+/**
+ * @class LogFollower
+ * @brief Keeps a read-only replica in step with the log shipped by a primary's LogShipper.
+ *
+ * The follower thread reads the stream, decodes every complete entry and applies each
+ * received chunk under one lock of the replica. The replica needs the same doctor roster
+ * as the primary, like a restart does, and starts without patients or appointments of
+ * its own; the roster entries the primary sends first are checked against it, and a
+ * replica with another roster refuses the stream. If the primary goes away, the replica
+ * keeps serving the state it reached.
+ */
+class LogFollower
+{
+private:
+    ConcurrentRegistry &registry;
+
+    int _fd = -1;                      ///< The socket connected to the primary.
+    std::thread _thread;               ///< The follower thread.
+    std::atomic<size_t> _applied{0};   ///< Entries applied so far.
+    bool _synced = false;              ///< The state sent on connecting has been applied.
+    string _error;                     ///< Why the stream was refused before the replica synced, or empty.
+    std::mutex _syncMutex;             ///< Guards _synced.
+    std::condition_variable _syncDone; ///< Signals that the replica caught up.
+
+    /**
+     * @brief Marks the replica as caught up with the primary.
+     */
+    void markSynced()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_syncMutex);
+            _synced = true;
+        }
+        _syncDone.notify_all();
+    }
+
+    /**
+     * @brief Runs the follower thread until the stream ends.
+     */
+    void follow()
+    {
+        string buffer;
+        vector<LogRecord> entries;
+        char chunk[64 * 1024];
+        bool synced = false;
+
+        while (true)
+        {
+            ssize_t received = ::recv(_fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+
+            buffer.append(chunk, received);
+
+            entries.clear();
+            size_t used = WriteAheadLog::parse(buffer, [&](const LogRecord &entry)
+                                               { entries.push_back(entry); });
+
+            uint32_t length = 0;
+            if (buffer.size() - used >= WriteAheadLog::HEADER_SIZE)
+                memcpy(&length, buffer.data() + used, sizeof(length));
+            if (buffer.size() - used >= WriteAheadLog::HEADER_SIZE + size_t(length) && length > 0)
+            {
+                std::cerr << "Damaged log stream from the primary" << endl;
+                break;
+            }
+
+            try
+            {
+                registry.applyReplicated(entries);
+            }
+            catch (const std::runtime_error &error)
+            {
+                std::cerr << "No longer following the primary: " << error.what() << endl;
+                if (!synced)
+                {
+                    std::lock_guard<std::mutex> lock(_syncMutex);
+                    _error = error.what();
+                }
+                markSynced();
+                return;
+            }
+            buffer.erase(0, used);
+            _applied += entries.size();
+
+            if (!synced && std::any_of(entries.begin(), entries.end(), [](const LogRecord &entry)
+                                       { return entry.operation == LogOperation::CHECKPOINT; }))
+            {
+                synced = true;
+                markSynced();
+            }
+        }
+
+        std::cerr << "Lost the primary after " << _applied << " entries; serving the last state" << endl;
+        markSynced();
+    }
+
+public:
+    /**
+     * @brief Constructs a follower applying to the given registry.
+     * @param reg Reference to the thread-safe registry of the replica.
+     */
+    LogFollower(ConcurrentRegistry &reg) : registry(reg) {}
+
+    LogFollower(const LogFollower &) = delete;
+    LogFollower &operator=(const LogFollower &) = delete;
+
+    ~LogFollower()
+    {
+        if (_fd >= 0)
+            ::shutdown(_fd, SHUT_RDWR);
+        if (_thread.joinable())
+            _thread.join();
+        if (_fd >= 0)
+            ::close(_fd);
+    }
+
+    /**
+     * @brief Connects to a primary and starts following its log.
+     * @param primary The address of the primary's log shipper as host:port.
+     * @throws std::runtime_error If the primary cannot be reached.
+     */
+    void start(const string &primary)
+    {
+        size_t colon = primary.rfind(':');
+        if (colon == string::npos)
+            throw runtime_error("Invalid primary address " + primary + "; expected host:port.");
+
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *addresses = nullptr;
+        if (::getaddrinfo(primary.substr(0, colon).c_str(), primary.substr(colon + 1).c_str(), &hints, &addresses) != 0)
+            throw runtime_error("Cannot resolve primary " + primary);
+
+        for (addrinfo *address = addresses; address != nullptr && _fd < 0; address = address->ai_next)
+        {
+            _fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (_fd >= 0 && ::connect(_fd, address->ai_addr, address->ai_addrlen) != 0)
+            {
+                ::close(_fd);
+                _fd = -1;
+            }
+        }
+        ::freeaddrinfo(addresses);
+
+        if (_fd < 0)
+            throw runtime_error("Cannot connect to primary " + primary + ": " + strerror(errno));
+
+        _thread = std::thread(&LogFollower::follow, this);
+    }
+
+    /**
+     * @brief Waits until the state the primary sent on connecting has been applied.
+     * @return The number of entries applied so far.
+     * @throws std::runtime_error If the replica refused the state, for example because its roster differs.
+     */
+    size_t waitUntilSynced()
+    {
+        std::unique_lock<std::mutex> lock(_syncMutex);
+        _syncDone.wait(lock, [this]
+                       { return _synced; });
+        if (!_error.empty())
+            throw runtime_error(_error);
+        return _applied;
+    }
+};
@@ -0,0 +1,287 @@
+/**
+ * @struct VisitCardRange
+ * @brief The visit cards of one patient in a report view.
+ */
+struct VisitCardRange
+{
+    const HospitalVisitCard *first; ///< The first visit card of the patient.
+    const HospitalVisitCard *last;  ///< Past the last visit card of the patient.
+
+    const HospitalVisitCard *begin() const { return first; }
+    const HospitalVisitCard *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+/**
+ * @class ReportView
+ * @brief An immutable copy of the appointments and visit cards of a registry at one version.
+ *
+ * Reports such as day lists, visit card exports and doctor load scan a view instead of
+ * the live tables, so they need no lock while they run and bookings go on meanwhile.
+ * A view holds the appointment table and the patients with their visit cards in pages
+ * of PageStamps::ROWS_PER_PAGE rows, and points at the names of the people and the
+ * interned diagnoses; both are never changed or moved once added, so the view stays
+ * valid however the registry changes after it was taken.
+ *
+ * A view is built from the previous one: pages whose stamp did not change since are
+ * shared with it, and only the others are copied. A booking changes one appointment
+ * page and a cancellation at most two, and a new patient or visit card one patient
+ * page, so the first report after a few changes copies a few pages instead of the
+ * tables, plus one pointer per page. The first view of a registry copies everything.
+ *
+ * Views are built by ConcurrentRegistry::reportView() and shared by every report of the
+ * same version. Pages and views are reference counted: a view is freed when the last
+ * report holding it finishes, and a page when the last view holding it is freed.
+ */
+class ReportView
+{
+public:
+    static constexpr size_t ITEMS_PER_PART = 4096; ///< Appointments formatted by a pool thread at a time.
+
+private:
+    /**
+     * @struct AppointmentPage
+     * @brief A copied page of the appointment table.
+     */
+    struct AppointmentPage
+    {
+        uint64_t stamp;                   ///< Stamp of the page when it was copied.
+        vector<Appointment> appointments; ///< The appointments of the page, in table order.
+    };
+
+    /**
+     * @struct PatientPage
+     * @brief A copied page of the patients and their visit cards.
+     */
+    struct PatientPage
+    {
+        uint64_t stamp;                       ///< Stamp of the page when it was copied.
+        vector<const string *> names;         ///< Name of each patient of the page.
+        vector<HospitalVisitCard> visitCards; ///< Visit cards grouped by patient, in patient ID order.
+        vector<uint32_t> cardOffsets;         ///< Position in visitCards of the first card of each patient, and the end.
+    };
+
+    uint64_t _version;                                            ///< Version of the registry the view was taken at.
+    size_t _appointmentCount = 0;                                 ///< Number of appointments.
+    vector<std::shared_ptr<const AppointmentPage>> _appointments; ///< The appointment table by page.
+    size_t _patientCount = 0;                                     ///< Number of patients.
+    vector<std::shared_ptr<const PatientPage>> _patients;         ///< The patients by page.
+    std::shared_ptr<const vector<const string *>> _doctorNames;   ///< Name of each doctor by ID.
+
+    /**
+     * @brief Copies a page of the appointment table.
+     * @param appointments The appointment table.
+     * @param page The index of the page.
+     * @return The copy.
+     */
+    static std::shared_ptr<const AppointmentPage> copyAppointments(const AppointmentStore &appointments, size_t page)
+    {
+        auto copy = std::make_shared<AppointmentPage>();
+        copy->stamp = appointments.pages().stamp(page);
+
+        size_t first = page * PageStamps::ROWS_PER_PAGE;
+        size_t last = std::min(appointments.size(), first + PageStamps::ROWS_PER_PAGE);
+        copy->appointments.assign(appointments.begin() + first, appointments.begin() + last);
+        return copy;
+    }
+
+    /**
+     * @brief Copies a page of the patients and their visit cards.
+     * @param registry The registry.
+     * @param page The index of the page.
+     * @return The copy.
+     */
+    static std::shared_ptr<const PatientPage> copyPatients(Registry &registry, size_t page)
+    {
+        auto copy = std::make_shared<PatientPage>();
+        copy->stamp = registry.patientPages().stamp(page);
+
+        deque<Patient> &patients = registry.getPatients();
+        size_t first = page * PageStamps::ROWS_PER_PAGE;
+        size_t last = std::min(patients.size(), first + PageStamps::ROWS_PER_PAGE);
+
+        copy->names.reserve(last - first);
+        copy->cardOffsets.reserve(last - first + 1);
+        for (size_t id = first; id < last; ++id)
+        {
+            const vector<HospitalVisitCard> &visitCards = registry.getVisitCardsForPatient(patients[id]);
+
+            copy->names.push_back(&patients[id].getName());
+            copy->cardOffsets.push_back(copy->visitCards.size());
+            copy->visitCards.insert(copy->visitCards.end(), visitCards.begin(), visitCards.end());
+        }
+        copy->cardOffsets.push_back(copy->visitCards.size());
+        return copy;
+    }
+
+public:
+    /**
+     * @brief Copies the tables of a registry, sharing the unchanged pages of a previous view.
+     * @param registry The registry; its tables must not change while the view is taken.
+     * @param version The version of the registry.
+     * @param previous An older view of the same registry, or nullptr to copy every page.
+     */
+    ReportView(Registry &registry, uint64_t version, const ReportView *previous = nullptr) : _version(version)
+    {
+        const AppointmentStore &appointments = registry.getAppointments();
+        _appointmentCount = appointments.size();
+        _appointments.reserve(PageStamps::pageCount(_appointmentCount));
+        for (size_t page = 0; page < PageStamps::pageCount(_appointmentCount); ++page)
+        {
+            if (previous != nullptr && page < previous->_appointments.size() &&
+                previous->_appointments[page]->stamp == appointments.pages().stamp(page))
+                _appointments.push_back(previous->_appointments[page]);
+            else
+                _appointments.push_back(copyAppointments(appointments, page));
+        }
+
+        _patientCount = registry.getPatients().size();
+        _patients.reserve(PageStamps::pageCount(_patientCount));
+        for (size_t page = 0; page < PageStamps::pageCount(_patientCount); ++page)
+        {
+            if (previous != nullptr && page < previous->_patients.size() &&
+                previous->_patients[page]->stamp == registry.patientPages().stamp(page))
+                _patients.push_back(previous->_patients[page]);
+            else
+                _patients.push_back(copyPatients(registry, page));
+        }
+
+        if (previous != nullptr && previous->_doctorNames->size() == registry.getDoctors().size())
+        {
+            _doctorNames = previous->_doctorNames;
+            return;
+        }
+
+        auto doctorNames = std::make_shared<vector<const string *>>();
+        doctorNames->reserve(registry.getDoctors().size());
+        for (const Doctor &doctor : registry.getDoctors())
+            doctorNames->push_back(&doctor.getName());
+        _doctorNames = doctorNames;
+    }
+
+    /**
+     * @brief Gets the version of the registry the view was taken at.
+     * @return The version.
+     */
+    uint64_t version() const
+    {
+        return _version;
+    }
+
+    /**
+     * @brief Gets the number of appointments of the view.
+     * @return The number of appointments.
+     */
+    size_t appointmentCount() const
+    {
+        return _appointmentCount;
+    }
+
+    /**
+     * @brief Gets an appointment of the view.
+     * @param position The position of the appointment, as Registry::showAppointments() numbers them from 0.
+     * @return The appointment.
+     */
+    const Appointment &appointment(size_t position) const
+    {
+        return _appointments[position / PageStamps::ROWS_PER_PAGE]->appointments[position % PageStamps::ROWS_PER_PAGE];
+    }
+
+    const string &getDoctorName(PersonId id) const { return *(*_doctorNames)[id]; }
+
+    const string &getPatientName(PersonId id) const
+    {
+        return *_patients[id / PageStamps::ROWS_PER_PAGE]->names[id % PageStamps::ROWS_PER_PAGE];
+    }
+
+    /**
+     * @brief Gets the visit cards of a patient.
+     * @param patientId The ID of the patient.
+     * @return The visit cards in the order they were added; none if the patient is newer than the view.
+     */
+    VisitCardRange getVisitCards(PersonId patientId) const
+    {
+        if (patientId >= _patientCount)
+            return VisitCardRange{nullptr, nullptr};
+
+        const PatientPage &page = *_patients[patientId / PageStamps::ROWS_PER_PAGE];
+        size_t index = patientId % PageStamps::ROWS_PER_PAGE;
+        return VisitCardRange{page.visitCards.data() + page.cardOffsets[index], page.visitCards.data() + page.cardOffsets[index + 1]};
+    }
+
+    /**
+     * @brief Lists the appointments in a time range.
+     * @param from The earliest start of a listed appointment.
+     * @param to The start after the range.
+     * @return The appointments in time order, and appointments at the same time in doctor order.
+     */
+    vector<Appointment> getAppointmentsBetween(Timestamp from, Timestamp to) const
+    {
+        vector<Appointment> found;
+        for (const auto &page : _appointments)
+        {
+            for (const Appointment &appointment : page->appointments)
+            {
+                if (appointment.getDateTime() >= from && appointment.getDateTime() < to)
+                    found.push_back(appointment);
+            }
+        }
+
+        sort(found.begin(), found.end(), [](const Appointment &a, const Appointment &b)
+             { return a.getDateTime() != b.getDateTime() ? a.getDateTime() < b.getDateTime() : a.getDoctorId() < b.getDoctorId(); });
+        return found;
+    }
+
+    /**
+     * @brief Counts the appointments of every doctor in a time range.
+     * @param from The earliest start of a counted appointment.
+     * @param to The start after the range.
+     * @return The number of appointments by doctor ID.
+     */
+    vector<size_t> getDoctorLoad(Timestamp from, Timestamp to) const
+    {
+        vector<size_t> load(_doctorNames->size());
+        for (const auto &page : _appointments)
+        {
+            for (const Appointment &appointment : page->appointments)
+            {
+                if (appointment.getDateTime() >= from && appointment.getDateTime() < to)
+                    load[appointment.getDoctorId()]++;
+            }
+        }
+        return load;
+    }
+
+    /**
+     * @brief Formats a page of the appointments as Registry::showAppointments() prints it.
+     * @param first The position of the first appointment to format.
+     * @param count The maximum number of appointments to format.
+     * @return The formatted text in parts of ITEMS_PER_PART appointments; several parts are formatted on the worker pool.
+     */
+    vector<string> formatAppointments(size_t first, size_t count) const
+    {
+        first = std::min(first, _appointmentCount);
+        size_t last = first + std::min(count, _appointmentCount - first);
+
+        vector<string> parts((last - first + ITEMS_PER_PART - 1) / ITEMS_PER_PART);
+
+        auto format = [&](size_t part)
+        {
+            size_t end = std::min(last, first + (part + 1) * ITEMS_PER_PART);
+            for (size_t position = first + part * ITEMS_PER_PART; position < end; ++position)
+            {
+                const Appointment &appointment = this->appointment(position);
+                InputOutput::formatAppointment(parts[part], position + 1, appointment.getDateTime(),
+                                               getDoctorName(appointment.getDoctorId()), getPatientName(appointment.getPatientId()));
+            }
+        };
+
+        if (parts.size() == 1)
+            format(0);
+        else if (parts.size() > 1)
+            WorkerPool::shared().run(parts.size(), format);
+
+        return parts;
+    }
+};
@@ -0,0 +1,488 @@
+/**
+ * @class RosterImporter
+ * @brief Loads doctors and patients in bulk from a CSV or JSON-lines roster file.
+ *
+ * A CSV roster has one person per line with the columns role, name, date of birth and
+ * shift; a header line starting with "role" is skipped, and fields may be double-quoted
+ * with "" standing for a quote. A JSON-lines roster (.jsonl or .json) has one flat object
+ * per line with the string members "role", "name", "dateOfBirth" and "shift". The role is
+ * either "doctor" or "patient"; doctors need no date of birth, and patients no shift. A
+ * shift such as "07:00-15:00/20" sets the working hours and slot length of a doctor, who
+ * otherwise works the default grid.
+ *
+ * The file is memory-mapped and parsed in place: names and dates are views into the
+ * mapping, and only fields containing quotes or escapes are copied. Patients are then
+ * handed to Registry::addPatients in a single batch, which de-duplicates them against
+ * the name index and reserves room for all of them at once.
+ *
+ * A doctor row whose name is already on the roster, built-in doctors included, is
+ * rejected rather than overriding the shift of that doctor. An import of the patients
+ * only reports the doctor rows an earlier import of the doctors rejected again, so they
+ * are not lost when the doctors were imported with their report discarded.
+ */
+class RosterImporter
+{
+public:
+    /**
+     * @enum Roles
+     * @brief Selects which people of a roster are imported.
+     */
+    enum Roles : uint8_t
+    {
+        DOCTORS = 1,  ///< Import the doctors.
+        PATIENTS = 2, ///< Import the patients.
+        EVERYONE = 3  ///< Import doctors and patients.
+    };
+
+private:
+    /**
+     * @class RosterMapping
+     * @brief A read-only mapping of a roster file, unmapped when it goes out of scope.
+     */
+    class RosterMapping
+    {
+    private:
+        const char *_data = nullptr; ///< Start of the mapping, null for an empty file.
+        size_t _size = 0;            ///< Size of the mapping in bytes.
+
+    public:
+        /**
+         * @brief Maps a roster file.
+         * @param path The path of the roster.
+         * @throws std::runtime_error If the file cannot be opened, read or mapped.
+         */
+        RosterMapping(const string &path)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw runtime_error("Cannot open roster " + path + ": " + strerror(errno));
+
+            struct stat info;
+            if (::fstat(fd, &info) != 0)
+            {
+                ::close(fd);
+                throw runtime_error("Cannot read roster " + path + ": " + strerror(errno));
+            }
+
+            if (info.st_size > 0)
+            {
+                void *mapping = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    ::close(fd);
+                    throw runtime_error("Cannot map roster " + path + ": " + strerror(errno));
+                }
+                ::madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+                _data = static_cast<const char *>(mapping);
+                _size = info.st_size;
+            }
+            ::close(fd);
+        }
+
+        RosterMapping(const RosterMapping &) = delete;
+        RosterMapping &operator=(const RosterMapping &) = delete;
+
+        ~RosterMapping()
+        {
+            if (_data != nullptr)
+                ::munmap(const_cast<char *>(_data), _size);
+        }
+
+        /**
+         * @brief Gets the contents of the file.
+         * @return A view of the mapping.
+         */
+        string_view text() const
+        {
+            return string_view(_data, _size);
+        }
+    };
+
+    Registry &registry;
+
+    deque<string> _unescaped;                             ///< Fields that had to be copied to remove quotes or escapes.
+    size_t _rejected = 0;                                 ///< Lines that could not be parsed.
+    std::unordered_map<size_t, string> _doctorRejections; ///< Reason for each doctor row the last import of doctors rejected, by line.
+
+    /**
+     * @brief Reports a line that cannot be imported.
+     * @param log The stream receiving the report.
+     * @param line The line number.
+     * @param reason Why the line was rejected.
+     */
+    void reject(std::ostream &log, size_t line, const string &reason)
+    {
+        log << "Line " << line << ": " << reason << '\n';
+        _rejected++;
+    }
+
+    /**
+     * @brief Adds a doctor row to the roster.
+     * @param name The name of the doctor.
+     * @param shift The working hours of the doctor.
+     * @return Why the row was rejected, or an empty string if the doctor was added.
+     */
+    string addDoctor(string_view name, const ShiftPattern &shift)
+    {
+        if (registry.doctorExists(name))
+            return "Doctor " + string(name) + " is already registered.";
+
+        try
+        {
+            registry.setDoctorShift(registry.addDoctor(name), shift);
+        }
+        catch (const std::exception &e)
+        {
+            return e.what();
+        }
+        return string();
+    }
+
+    /**
+     * @brief Splits a CSV line into its first four fields.
+     * @param text The line without its terminator.
+     * @param fields Receives the role, the name, the date of birth and the shift.
+     * @return True if the line is well-formed, false otherwise.
+     */
+    bool parseCsv(string_view text, string_view (&fields)[4])
+    {
+        size_t count = 0;
+        size_t position = 0;
+
+        while (position <= text.size() && count < 4)
+        {
+            string_view field;
+
+            if (position < text.size() && text[position] == '"')
+            {
+                size_t start = ++position;
+                bool escaped = false;
+
+                while (true)
+                {
+                    size_t quote = text.find('"', position);
+                    if (quote == string_view::npos)
+                        return false;
+                    if (quote + 1 < text.size() && text[quote + 1] == '"')
+                    {
+                        escaped = true;
+                        position = quote + 2;
+                        continue;
+                    }
+                    field = text.substr(start, quote - start);
+                    position = quote + 1;
+                    break;
+                }
+
+                if (escaped)
+                {
+                    string &copy = _unescaped.emplace_back();
+                    for (size_t i = 0; i < field.size(); ++i)
+                    {
+                        copy += field[i];
+                        if (field[i] == '"')
+                            ++i;
+                    }
+                    field = copy;
+                }
+
+                if (position < text.size() && text[position] != ',')
+                    return false;
+            }
+            else
+            {
+                size_t comma = text.find(',', position);
+                field = text.substr(position, comma == string_view::npos ? string_view::npos : comma - position);
+                position = comma == string_view::npos ? text.size() : comma;
+            }
+
+            fields[count++] = field;
+            position++;
+        }
+
+        return count >= 2;
+    }
+
+    /**
+     * @brief Reads a JSON string starting at an opening quote.
+     * @param text The line.
+     * @param position The position of the opening quote; receives the position after the closing quote.
+     * @param value Receives the string, a view into the line unless it contains escapes.
+     * @return True if the string is well-formed, false otherwise.
+     */
+    bool parseJsonString(string_view text, size_t &position, string_view &value)
+    {
+        size_t start = ++position;
+        size_t end = start;
+        while (end < text.size() && text[end] != '"' && text[end] != '\\')
+            ++end;
+
+        if (end < text.size() && text[end] == '"')
+        {
+            value = text.substr(start, end - start);
+            position = end + 1;
+            return true;
+        }
+
+        string &copy = _unescaped.emplace_back(text.substr(start, end - start));
+        for (position = end; position < text.size(); ++position)
+        {
+            char c = text[position];
+            if (c == '"')
+            {
+                value = copy;
+                position++;
+                return true;
+            }
+            if (c != '\\')
+            {
+                copy += c;
+                continue;
+            }
+            if (++position >= text.size())
+                return false;
+
+            switch (text[position])
+            {
+            case 'n':
+                copy += '\n';
+                break;
+            case 't':
+                copy += '\t';
+                break;
+            case 'r':
+                copy += '\r';
+                break;
+            case 'b':
+                copy += '\b';
+                break;
+            case 'f':
+                copy += '\f';
+                break;
+            case 'u':
+            {
+                unsigned code = 0;
+                for (int digit = 0; digit < 4; ++digit)
+                {
+                    if (++position >= text.size())
+                        return false;
+
+                    char c = text[position] | 0x20;
+                    if (c >= '0' && c <= '9')
+                        code = code * 16 + (c - '0');
+                    else if (c >= 'a' && c <= 'f')
+                        code = code * 16 + (c - 'a' + 10);
+                    else
+                        return false;
+                }
+                if (code < 0x80)
+                    copy += static_cast<char>(code);
+                else if (code < 0x800)
+                {
+                    copy += static_cast<char>(0xC0 | (code >> 6));
+                    copy += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    copy += static_cast<char>(0xE0 | (code >> 12));
+                    copy += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    copy += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                copy += text[position];
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Reads the role, name, date of birth and shift of a flat JSON object.
+     * @param text The line without its terminator.
+     * @param fields Receives the role, the name, the date of birth and the shift.
+     * @return True if the line is an object with string members, false otherwise.
+     *
+     * Members other than role, name, dateOfBirth and shift are skipped if they are
+     * strings, numbers, booleans or null.
+     */
+    bool parseJson(string_view text, string_view (&fields)[4])
+    {
+        auto skipSpace = [&text](size_t &position)
+        {
+            while (position < text.size() && (text[position] == ' ' || text[position] == '\t'))
+                ++position;
+        };
+
+        size_t position = 0;
+        skipSpace(position);
+        if (position >= text.size() || text[position++] != '{')
+            return false;
+
+        while (true)
+        {
+            skipSpace(position);
+            if (position < text.size() && text[position] == '}')
+                return true;
+            if (position >= text.size() || text[position] != '"')
+                return false;
+
+            string_view key;
+            if (!parseJsonString(text, position, key))
+                return false;
+
+            skipSpace(position);
+            if (position >= text.size() || text[position++] != ':')
+                return false;
+            skipSpace(position);
+
+            string_view value;
+            if (position < text.size() && text[position] == '"')
+            {
+                if (!parseJsonString(text, position, value))
+                    return false;
+            }
+            else
+            {
+                while (position < text.size() && text[position] != ',' && text[position] != '}')
+                    ++position;
+            }
+
+            if (key == "role")
+                fields[0] = value;
+            else if (key == "name")
+                fields[1] = value;
+            else if (key == "dateOfBirth" || key == "date_of_birth")
+                fields[2] = value;
+            else if (key == "shift")
+                fields[3] = value;
+
+            skipSpace(position);
+            if (position < text.size() && text[position] == ',')
+                position++;
+        }
+    }
+
+public:
+    /**
+     * @brief Constructs an importer for the given registry.
+     * @param reg Reference to the Registry object.
+     */
+    RosterImporter(Registry &reg) : registry(reg) {}
+
+    /**
+     * @brief Imports the selected people of a roster file.
+     * @param path The path of the roster; files ending in .jsonl or .json are read as JSON lines, others as CSV.
+     * @param roles The people to import.
+     * @param log The stream receiving rejected lines and the summary.
+     * @throws std::runtime_error If the file cannot be read.
+     *
+     * Doctors are not logged, so import them before the registry is opened on storage;
+     * patients are logged and should be imported after it, where already restored
+     * patients are skipped.
+     */
+    void import(const string &path, Roles roles, std::ostream &log)
+    {
+        RosterMapping mapping(path);
+
+        auto started = chrono::steady_clock::now();
+
+        string_view text = mapping.text();
+        bool json = path.size() >= 5 && (path.compare(path.size() - 5, 5, ".json") == 0 ||
+                                         (path.size() >= 6 && path.compare(path.size() - 6, 6, ".jsonl") == 0));
+
+        vector<pair<string_view, string_view>> patients;
+        if (roles & PATIENTS)
+            patients.reserve(std::count(text.begin(), text.end(), '\n') + 1);
+
+        size_t doctors = 0;
+        size_t lines = 0;
+        _rejected = 0;
+        _unescaped.clear();
+        if (roles & DOCTORS)
+            _doctorRejections.clear();
+
+        for (size_t start = 0; start < text.size();)
+        {
+            size_t end = text.find('\n', start);
+            if (end == string_view::npos)
+                end = text.size();
+
+            string_view line = text.substr(start, end - start);
+            start = end + 1;
+            lines++;
+
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty())
+                continue;
+
+            string_view fields[4];
+            if (!(json ? parseJson(line, fields) : parseCsv(line, fields)))
+            {
+                reject(log, lines, "Malformed roster line.");
+                continue;
+            }
+
+            if (!json && lines == 1 && fields[0] == "role")
+                continue;
+
+            if (fields[1].empty())
+                reject(log, lines, "Missing name.");
+            else if (fields[1].size() > WriteAheadLog::MAX_TEXT_SIZE || fields[2].size() > WriteAheadLog::MAX_TEXT_SIZE)
+                reject(log, lines, "Name or date of birth too long.");
+            else if (fields[0] == "doctor")
+            {
+                ShiftPattern shift = DefaultShift::PATTERN;
+                try
+                {
+                    if (!fields[3].empty())
+                        shift = ShiftPattern::parse(string(fields[3]));
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    reject(log, lines, e.what());
+                    continue;
+                }
+
+                string reason;
+                if (roles & DOCTORS)
+                {
+                    reason = addDoctor(fields[1], shift);
+                    if (!reason.empty())
+                        _doctorRejections.emplace(lines, reason);
+                }
+                else
+                {
+                    auto rejection = _doctorRejections.find(lines);
+                    if (rejection != _doctorRejections.end())
+                        reason = rejection->second;
+                }
+
+                if (!reason.empty())
+                {
+                    reject(log, lines, reason);
+                    continue;
+                }
+                doctors++;
+            }
+            else if (fields[0] == "patient")
+            {
+                if (roles & PATIENTS)
+                    patients.emplace_back(fields[1], fields[2]);
+            }
+            else
+                reject(log, lines, "Unknown role " + string(fields[0]) + ".");
+        }
+
+        size_t patientsAdded = registry.addPatients(patients);
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        _unescaped.clear();
+
+        log << "Roster " << path << ": " << doctors << " doctors, " << patientsAdded << " patients added, "
+            << patients.size() - patientsAdded << " patients already registered, "
+            << _rejected << " lines rejected in " << seconds << " s" << '\n';
+    }
+};
@@ -0,0 +1,266 @@
+/**
+ * @class NameSearchIndex
+ * @brief Prefix and trigram fuzzy search over the names of people.
+ *
+ * Every word of a name, and the whole name, is a key of the prefix index, so "smi"
+ * finds "Alice Smith" as well as "Smithers". Keys are lower-cased copies kept in a
+ * StringArena. The index is a few sorted runs of keys that are merged like a binary
+ * counter as names are added: adding a name costs amortized O(log n) and a prefix query
+ * is one binary search per run, so loading a large roster and querying both stay fast.
+ *
+ * Fuzzy matching compares trigram sets, as PostgreSQL's pg_trgm does: candidates are
+ * drawn from the posting lists of the rarest trigrams of the query, up to a fixed
+ * budget, and then ranked by the exact similarity of their trigram sets. The trigrams
+ * whose lists were not read are checked directly in the candidates' names, so very
+ * common trigrams never make a query scan a large part of the roster.
+ *
+ * Queries are const and may run in parallel with each other; adding names must be
+ * serialized with queries by the caller.
+ */
+class NameSearchIndex
+{
+public:
+    static constexpr size_t CANDIDATE_BUDGET = 4096;  ///< Posting entries read for one fuzzy query.
+    static constexpr double MIN_SIMILARITY = 0.3;     ///< Lowest trigram similarity of a fuzzy match.
+
+private:
+    /**
+     * @struct Key
+     * @brief A key of the prefix index.
+     */
+    struct Key
+    {
+        string_view text; ///< Lower-cased word or name.
+        PersonId id;      ///< The person the key belongs to.
+
+        bool operator<(const Key &other) const
+        {
+            return text != other.text ? text < other.text : id < other.id;
+        }
+    };
+
+    using Trigram = uint32_t; ///< Three bytes packed into an integer.
+
+    StringArena _arena;                                 ///< Padded lower-cased names.
+    vector<string_view> _names;                         ///< Padded lower-cased name by person ID.
+    vector<uint8_t> _trigramCounts;                     ///< Number of distinct trigrams of each name, capped at 255.
+    vector<vector<Key>> _runs;                          ///< Sorted runs of keys, largest first.
+    unordered_map<Trigram, vector<PersonId>> _postings; ///< People whose name contains a trigram.
+
+    /**
+     * @brief Lower-cases ASCII letters.
+     * @param text The text to convert.
+     * @return The converted text.
+     */
+    static string lowerCase(string_view text)
+    {
+        string lower(text);
+        for (char &c : lower)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c = c - 'A' + 'a';
+        }
+        return lower;
+    }
+
+    /**
+     * @brief Lower-cases a name and pads it with two spaces in front and one behind.
+     * @param name The name.
+     * @return The padded name; the padding gives short names and first letters trigrams of their own.
+     */
+    static string padded(string_view name)
+    {
+        return "  " + lowerCase(name) + " ";
+    }
+
+    /**
+     * @brief Collects the distinct trigrams of a padded name.
+     * @param padded The padded name.
+     * @return The trigrams, sorted.
+     */
+    static vector<Trigram> trigrams(string_view padded)
+    {
+        vector<Trigram> result;
+        result.reserve(padded.size());
+        for (size_t i = 0; i + 3 <= padded.size(); ++i)
+        {
+            result.push_back(Trigram(uint8_t(padded[i])) << 16 | Trigram(uint8_t(padded[i + 1])) << 8 | uint8_t(padded[i + 2]));
+        }
+
+        sort(result.begin(), result.end());
+        result.erase(unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    /**
+     * @brief Adds a key as a new run and merges runs until their sizes strictly decrease.
+     * @param key The key to add.
+     */
+    void addKey(Key key)
+    {
+        _runs.push_back(vector<Key>{key});
+
+        while (_runs.size() >= 2 && _runs[_runs.size() - 2].size() <= _runs.back().size())
+        {
+            vector<Key> &target = _runs[_runs.size() - 2];
+            vector<Key> &source = _runs.back();
+
+            size_t middle = target.size();
+            target.insert(target.end(), source.begin(), source.end());
+            std::inplace_merge(target.begin(), target.begin() + middle, target.end());
+            _runs.pop_back();
+        }
+    }
+
+public:
+    /**
+     * @brief Adds a person; people must be added in ID order.
+     * @param id The ID of the person.
+     * @param name The name of the person.
+     */
+    void add(PersonId id, string_view name)
+    {
+        string_view stored = _arena.store(padded(name));
+        string_view lower = stored.substr(2, stored.size() - 3);
+        vector<Trigram> found = trigrams(stored);
+
+        if (_names.size() <= id)
+        {
+            _names.resize(id + 1);
+            _trigramCounts.resize(id + 1);
+        }
+        _names[id] = stored;
+        _trigramCounts[id] = std::min<size_t>(found.size(), 255);
+
+        addKey(Key{lower, id});
+        for (size_t start = lower.find(' '); start != string_view::npos; start = lower.find(' ', start))
+        {
+            ++start;
+            if (start < lower.size() && lower[start] != ' ')
+                addKey(Key{lower.substr(start), id});
+        }
+
+        for (Trigram trigram : found)
+            _postings[trigram].push_back(id);
+    }
+
+    /**
+     * @brief Finds the people whose name, or a word of it, starts with a prefix.
+     * @param prefix The prefix; letters match regardless of case.
+     * @param limit The maximum number of people returned.
+     * @return The matching IDs, ordered by the matching key.
+     */
+    vector<PersonId> prefix(string_view prefix, size_t limit) const
+    {
+        string lower = lowerCase(prefix);
+
+        vector<Key> matches;
+        for (const vector<Key> &run : _runs)
+        {
+            auto it = std::lower_bound(run.begin(), run.end(), Key{lower, 0});
+            for (size_t taken = 0; it != run.end() && taken < limit && it->text.substr(0, lower.size()) == lower; ++it, ++taken)
+                matches.push_back(*it);
+        }
+        sort(matches.begin(), matches.end());
+
+        vector<PersonId> result;
+        for (const Key &match : matches)
+        {
+            if (result.size() == limit)
+                break;
+            if (std::find(result.begin(), result.end(), match.id) == result.end())
+                result.push_back(match.id);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Finds the people whose name is most similar to a query.
+     * @param query The query, possibly misspelled.
+     * @param limit The maximum number of people returned.
+     * @return The ID and trigram similarity of each match at or above MIN_SIMILARITY, most similar first.
+     *
+     * Posting lists are read from the shortest while they fit the budget; each read list
+     * adds one shared trigram to every person on it. If even the shortest list is too
+     * long, its first CANDIDATE_BUDGET people are used as candidates. Trigrams of lists
+     * that were not read are looked up in the candidates' names instead.
+     */
+    vector<pair<PersonId, double>> fuzzy(string_view query, size_t limit) const
+    {
+        vector<Trigram> wanted = trigrams(padded(query));
+
+        vector<pair<Trigram, const vector<PersonId> *>> lists;
+        for (Trigram trigram : wanted)
+        {
+            auto it = _postings.find(trigram);
+            if (it != _postings.end())
+                lists.emplace_back(trigram, &it->second);
+        }
+        sort(lists.begin(), lists.end(), [](const auto &a, const auto &b)
+             { return a.second->size() < b.second->size(); });
+
+        vector<PersonId> hits;
+        vector<PersonId> seeds;
+        size_t read = 0;
+        for (; read < lists.size() && hits.size() + lists[read].second->size() <= CANDIDATE_BUDGET; ++read)
+            hits.insert(hits.end(), lists[read].second->begin(), lists[read].second->end());
+
+        if (read == 0 && !lists.empty())
+            seeds.assign(lists[0].second->begin(), lists[0].second->begin() + CANDIDATE_BUDGET);
+
+        sort(hits.begin(), hits.end());
+
+        vector<pair<PersonId, size_t>> candidates;
+        for (size_t i = 0; i < hits.size();)
+        {
+            size_t j = i;
+            while (j < hits.size() && hits[j] == hits[i])
+                ++j;
+            candidates.emplace_back(hits[i], j - i);
+            i = j;
+        }
+        for (PersonId id : seeds)
+            candidates.emplace_back(id, 0);
+
+        vector<Trigram> unread;
+        for (size_t i = read; i < lists.size(); ++i)
+            unread.push_back(lists[i].first);
+        sort(unread.begin(), unread.end());
+
+        vector<pair<PersonId, double>> matches;
+        vector<bool> seen(unread.size());
+        for (const auto &candidate : candidates)
+        {
+            string_view name = _names[candidate.first];
+
+            size_t shared = candidate.second;
+            if (!unread.empty())
+            {
+                std::fill(seen.begin(), seen.end(), false);
+
+                Trigram trigram = Trigram(uint8_t(name[0])) << 8 | uint8_t(name[1]);
+                for (size_t i = 2; i < name.size(); ++i)
+                {
+                    trigram = (trigram << 8 | uint8_t(name[i])) & 0xFFFFFF;
+
+                    auto it = std::lower_bound(unread.begin(), unread.end(), trigram);
+                    if (it != unread.end() && *it == trigram && !seen[it - unread.begin()])
+                    {
+                        seen[it - unread.begin()] = true;
+                        shared++;
+                    }
+                }
+            }
+
+            double similarity = double(shared) / (wanted.size() + _trigramCounts[candidate.first] - shared);
+            if (similarity >= MIN_SIMILARITY)
+                matches.emplace_back(candidate.first, similarity);
+        }
+
+        size_t kept = std::min(limit, matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + kept, matches.end(), [](const pair<PersonId, double> &a, const pair<PersonId, double> &b)
+                          { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+        matches.resize(kept);
+        return matches;
+    }
+};
@@ -0,0 +1,771 @@
+/**
+ * @class RegistryServer
+ * @brief Serves the registry over TCP with a non-blocking event loop and a worker pool.
+ *
+ * Clients send one request per line, using the '|'-separated syntax of BatchRunner:
+ *
+ *     availability|<YYYY-MM-DD>[|<doctor name>]
+ *     doctors|<YYYY-MM-DD>[|by-capacity]
+ *     agenda|<doctor name>|<YYYY-MM-DD>[|<last YYYY-MM-DD>]
+ *     earliest|<YYYY-MM-DD HH:MM>|<days>[|<doctor name>]
+ *     capacity|<YYYY-MM-DD>|<days>|<minimum free slots>
+ *     schedule|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>
+ *     cancel|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>
+ *     register|<patient name>|<date of birth>
+ *     visit|<doctor name>|<patient name>|<YYYY-MM-DD HH:MM>|<diagnosis>
+ *     visits|<patient name>
+ *     appointments|<YYYY-MM-DD>[|<last YYYY-MM-DD>]
+ *     load|<YYYY-MM-DD>[|<last YYYY-MM-DD>]
+ *     search|patients|<query>[|<limit>]
+ *     search|doctors|<query>[|<limit>]
+ *     metrics                    (only when built with REGISTRY_METRICS)
+ *     quit
+ *
+ * Every request is answered with "OK <n>" followed by n lines of '|'-separated data,
+ * or with a single "ERR <message>" line. Requests of one connection are answered in
+ * order; requests of different connections run in parallel on the worker pool.
+ * Reports (visits, appointments and load) scan a ReportView, so they hold no lock
+ * while they run. A read replica serves every request except schedule, cancel,
+ * register and visit, which it rejects so that writes stay on the primary.
+ *
+ * A single thread owns every socket and only moves bytes, so a slow client never
+ * holds up a worker. Replies of mutations are held by a committer thread, which makes
+ * every mutation held since its last commit durable with one log commit and then posts
+ * the replies to the event loop, so sockets are served while the log is fsynced. If a
+ * commit fails, the held replies are never sent and run() throws.
+ *
+ * Requests over a range of days accept at most MAX_REQUEST_DAYS days.
+ */
+class RegistryServer
+{
+public:
+    static constexpr size_t MAX_REQUEST_SIZE = 64 * 1024; ///< Longest accepted request line.
+    static constexpr int LISTEN_BACKLOG = 128;            ///< Pending connections queued by the kernel.
+    static constexpr size_t DEFAULT_SEARCH_LIMIT = 10;    ///< Matches returned by a search without a limit.
+    static constexpr int MAX_REQUEST_DAYS = 366;          ///< Longest range of days a request may cover.
+
+private:
+    /**
+     * @struct Connection
+     * @brief State of one client connection, owned by the event loop.
+     */
+    struct Connection
+    {
+        int fd = -1;          ///< The client socket.
+        string input;         ///< Received bytes not yet dispatched.
+        string output;        ///< Reply bytes not yet sent.
+        bool busy = false;    ///< A request of this connection is with the workers.
+        bool closing = false; ///< Close once the pending reply is sent.
+        bool drained = false; ///< The peer has finished sending.
+    };
+
+    /**
+     * @struct Job
+     * @brief A request handed from the event loop to the workers.
+     */
+    struct Job
+    {
+        uint64_t connection;  ///< ID of the requesting connection.
+        BatchCommand command; ///< The parsed request.
+    };
+
+    /**
+     * @struct Completion
+     * @brief A reply handed from a worker back to the event loop.
+     */
+    struct Completion
+    {
+        uint64_t connection; ///< ID of the requesting connection.
+        string reply;        ///< The encoded reply.
+        bool mutated;        ///< The request changed the registry and must be committed first.
+    };
+
+    ConcurrentRegistry &registry;
+
+    unordered_map<uint64_t, Connection> _connections; ///< Open connections by ID.
+    uint64_t _nextConnection = 1;                      ///< ID of the next accepted connection.
+    int _listenFd = -1;                                ///< The listening socket.
+    int _wakeFds[2] = {-1, -1};                        ///< Pipe the workers use to wake the event loop.
+
+    vector<std::thread> _workers;      ///< The worker pool.
+    deque<Job> _jobs;                  ///< Requests waiting for a worker.
+    std::mutex _jobMutex;              ///< Guards _jobs and _stopping.
+    std::condition_variable _jobReady; ///< Signals a new job or shutdown.
+    bool _stopping = false;            ///< Tells the workers to exit.
+    vector<Completion> _completions;   ///< Replies waiting for the event loop.
+    std::mutex _completionMutex;       ///< Guards _completions and _commitError.
+    string _commitError;               ///< Why the committer failed, or empty.
+
+    std::thread _committer;               ///< Commits the log for the held replies.
+    vector<Completion> _held;             ///< Replies of mutations waiting for a commit.
+    std::mutex _heldMutex;                ///< Guards _held and _committing.
+    std::condition_variable _heldReady;   ///< Signals a held reply or shutdown.
+    bool _committing = true;              ///< Tells the committer to keep running.
+    bool _readOnly = false;            ///< The registry is a replica; requests that change it are rejected.
+
+    /**
+     * @brief Switches a descriptor to non-blocking mode.
+     * @param fd The descriptor.
+     * @throws std::runtime_error If the mode cannot be changed.
+     */
+    static void setNonBlocking(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+            throw runtime_error(string("Cannot make socket non-blocking: ") + strerror(errno));
+    }
+
+    /**
+     * @brief Checks the number of days a request covers.
+     * @param days The number of days.
+     * @return The number of days.
+     * @throws std::invalid_argument If the number is not from 1 to MAX_REQUEST_DAYS.
+     */
+    static int checkDays(int days)
+    {
+        if (days < 1 || days > MAX_REQUEST_DAYS)
+            throw std::invalid_argument("The number of days must be from 1 to " + std::to_string(MAX_REQUEST_DAYS) + ".");
+        return days;
+    }
+
+    /**
+     * @brief Appends a list of time and name pairs to a reply.
+     * @param reply The reply to append to.
+     * @param entries The entries to append.
+     */
+    static void appendEntries(string &reply, const vector<pair<Timestamp, string>> &entries)
+    {
+        reply += "OK " + std::to_string(entries.size()) + '\n';
+
+        char buffer[24];
+        for (const auto &entry : entries)
+        {
+            reply.append(buffer, entry.first.format(buffer));
+            reply += '|';
+            reply += entry.second;
+            reply += '\n';
+        }
+    }
+
+    /**
+     * @brief Appends a list of times and doctors to a reply, resolving each doctor's name only here.
+     * @param reply The reply to append to.
+     * @param entries The times paired with doctor IDs.
+     */
+    void appendEntries(string &reply, const vector<pair<Timestamp, PersonId>> &entries)
+    {
+        reply += "OK " + std::to_string(entries.size()) + '\n';
+
+        char buffer[24];
+        for (const auto &entry : entries)
+        {
+            reply.append(buffer, entry.first.format(buffer));
+            reply += '|';
+            reply += registry.getDoctorName(entry.second);
+            reply += '\n';
+        }
+    }
+
+    /**
+     * @brief Executes a request against the registry.
+     * @param command The parsed request.
+     * @param mutated Set to true if the registry was changed.
+     * @return The encoded reply.
+     * @throws std::exception If the request is malformed or refers to unknown people.
+     */
+    string execute(BatchCommand &command, bool &mutated)
+    {
+        vector<string> &fields = command.fields;
+        string reply;
+
+        if (_readOnly && (command.verb == "schedule" || command.verb == "cancel" || command.verb == "register" || command.verb == "visit"))
+            throw runtime_error("Read-only replica; send " + command.verb + " to the primary.");
+
+        if (command.verb == "availability" && (fields.size() == 1 || fields.size() == 2))
+        {
+            Timestamp date = Timestamp::parse(fields[0]);
+            appendEntries(reply, fields.size() == 2 ? registry.getAvailableTimesForDoctor(date, fields[1])
+                                                    : registry.getAvailableTimes(date));
+            return reply;
+        }
+
+        if (command.verb == "doctors" && fields.size() == 1)
+        {
+            vector<string> doctors = registry.getAvailableDoctors(Timestamp::parse(fields[0]));
+
+            reply = "OK " + std::to_string(doctors.size()) + '\n';
+            for (const string &doctor : doctors)
+                reply += doctor + '\n';
+            return reply;
+        }
+
+        if (command.verb == "doctors" && fields.size() == 2 && fields[1] == "by-capacity")
+        {
+            vector<pair<PersonId, int>> doctors = registry.getDoctorsByCapacity(Timestamp::parse(fields[0]));
+
+            reply = "OK " + std::to_string(doctors.size()) + '\n';
+            for (const auto &doctor : doctors)
+                reply += registry.getDoctorName(doctor.first) + '|' + std::to_string(doctor.second) + '\n';
+            return reply;
+        }
+
+        if (command.verb == "agenda" && (fields.size() == 2 || fields.size() == 3))
+        {
+            Timestamp first = Timestamp::parse(fields[1]);
+            Timestamp last = fields.size() == 3 ? Timestamp::parse(fields[2]) : first;
+            checkDays(last.day() - first.day() + 1);
+
+            appendEntries(reply, registry.getDoctorSchedule(registry.findDoctorByName(fields[0]), Timestamp(first.day(), 0), Timestamp(last.day() + 1, 0)));
+            return reply;
+        }
+
+        if (command.verb == "earliest" && (fields.size() == 2 || fields.size() == 3))
+        {
+            FreeSlot slot;
+            bool found = fields.size() == 3
+                             ? registry.findEarliestFreeSlot(Timestamp::parse(fields[0]), checkDays(std::stoi(fields[1])), fields[2], slot)
+                             : registry.findEarliestFreeSlot(Timestamp::parse(fields[0]), checkDays(std::stoi(fields[1])), slot);
+
+            vector<pair<Timestamp, string>> entries;
+            if (found)
+                entries.push_back(make_pair(slot.dateTime, registry.getDoctorName(slot.doctorId)));
+
+            appendEntries(reply, entries);
+            return reply;
+        }
+
+        if (command.verb == "capacity" && fields.size() == 3)
+        {
+            vector<PersonId> doctors = registry.getDoctorsWithFreeSlots(Timestamp::parse(fields[0]), checkDays(std::stoi(fields[1])), std::stoi(fields[2]));
+
+            reply = "OK " + std::to_string(doctors.size()) + '\n';
+            for (PersonId id : doctors)
+                reply += registry.getDoctorName(id) + '\n';
+            return reply;
+        }
+
+        if (command.verb == "schedule" && fields.size() == 3)
+        {
+            ScheduleRequest request{Timestamp::parse(fields[2]), registry.findDoctorByName(fields[0]).getId(),
+                                    registry.findPatientByName(fields[1]).getId()};
+
+            switch (registry.scheduleAppointments(vector<ScheduleRequest>{request})[0].status)
+            {
+            case ScheduleStatus::SCHEDULED:
+                mutated = true;
+                return "OK 0\n";
+            case ScheduleStatus::OFF_GRID:
+                return "ERR Invalid appointment time.\n";
+            default:
+                return "ERR Doctor is not available at that time.\n";
+            }
+        }
+
+        if (command.verb == "cancel" && fields.size() == 3)
+        {
+            if (!registry.cancelAppointment(Timestamp::parse(fields[2]), fields[1], fields[0]))
+                return "ERR Appointment not found.\n";
+
+            mutated = true;
+            return "OK 0\n";
+        }
+
+        if (command.verb == "register" && fields.size() == 2)
+        {
+            if (registry.patientExists(fields[0]))
+                return "ERR Patient already exists.\n";
+
+            registry.addPatient(fields[0], fields[1]);
+            mutated = true;
+            return "OK 0\n";
+        }
+
+        if (command.verb == "visit" && fields.size() == 4)
+        {
+            registry.addHospitalVisitCard(registry.findDoctorByName(fields[0]), registry.findPatientByName(fields[1]),
+                                          Timestamp::parse(fields[2]), fields[3]);
+            mutated = true;
+            return "OK 0\n";
+        }
+
+        if (command.verb == "search" && (fields.size() == 2 || fields.size() == 3) && (fields[0] == "patients" || fields[0] == "doctors"))
+        {
+            size_t limit = fields.size() == 3 ? std::stoul(fields[2]) : DEFAULT_SEARCH_LIMIT;
+
+            if (fields[0] == "doctors")
+            {
+                vector<PersonId> doctors = registry.searchDoctors(fields[1], limit);
+
+                reply = "OK " + std::to_string(doctors.size()) + '\n';
+                for (PersonId id : doctors)
+                    reply += registry.getDoctorName(id) + '\n';
+                return reply;
+            }
+
+            vector<PersonId> patients = registry.searchPatients(fields[1], limit);
+
+            reply = "OK " + std::to_string(patients.size()) + '\n';
+            for (PersonId id : patients)
+            {
+                Patient &patient = registry.getPatient(id);
+                reply += patient.getName() + '|';
+                reply.append(patient.getDateOfBirth().data(), patient.getDateOfBirth().size());
+                reply += '\n';
+            }
+            return reply;
+        }
+
+        if (command.verb == "visits" && fields.size() == 1)
+        {
+            PersonId patientId = registry.findPatientByName(fields[0]).getId();
+            std::shared_ptr<const ReportView> view = registry.reportView();
+            VisitCardRange visitCards = view->getVisitCards(patientId);
+
+            reply = "OK " + std::to_string(visitCards.size()) + '\n';
+
+            char buffer[24];
+            for (const HospitalVisitCard &visitCard : visitCards)
+            {
+                reply.append(buffer, visitCard.getDateTime().format(buffer));
+                reply += '|' + view->getDoctorName(visitCard.getDoctorId()) + '|';
+                reply.append(visitCard.getDiagnosis().data(), visitCard.getDiagnosis().size());
+                reply += '\n';
+            }
+            return reply;
+        }
+
+        if (command.verb == "appointments" && (fields.size() == 1 || fields.size() == 2))
+        {
+            Timestamp first = Timestamp::parse(fields[0]);
+            Timestamp last = fields.size() == 2 ? Timestamp::parse(fields[1]) : first;
+            checkDays(last.day() - first.day() + 1);
+
+            std::shared_ptr<const ReportView> view = registry.reportView();
+            vector<Appointment> appointments = view->getAppointmentsBetween(Timestamp(first.day(), 0), Timestamp(last.day() + 1, 0));
+
+            reply = "OK " + std::to_string(appointments.size()) + '\n';
+
+            char buffer[24];
+            for (const Appointment &appointment : appointments)
+            {
+                reply.append(buffer, appointment.getDateTime().format(buffer));
+                reply += '|' + view->getDoctorName(appointment.getDoctorId()) + '|' + view->getPatientName(appointment.getPatientId()) + '\n';
+            }
+            return reply;
+        }
+
+        if (command.verb == "load" && (fields.size() == 1 || fields.size() == 2))
+        {
+            Timestamp first = Timestamp::parse(fields[0]);
+            Timestamp last = fields.size() == 2 ? Timestamp::parse(fields[1]) : first;
+            checkDays(last.day() - first.day() + 1);
+
+            std::shared_ptr<const ReportView> view = registry.reportView();
+            vector<size_t> load = view->getDoctorLoad(Timestamp(first.day(), 0), Timestamp(last.day() + 1, 0));
+
+            reply = "OK " + std::to_string(load.size()) + '\n';
+            for (PersonId id = 0; id < load.size(); ++id)
+                reply += view->getDoctorName(id) + '|' + std::to_string(load[id]) + '\n';
+            return reply;
+        }
+
+#ifdef REGISTRY_METRICS
+        if (command.verb == "metrics" && fields.empty())
+        {
+            vector<string> lines = registry.metricsReport();
+
+            reply = "OK " + std::to_string(lines.size()) + '\n';
+            for (const string &line : lines)
+                reply += line + '\n';
+            return reply;
+        }
+#endif
+
+        throw std::invalid_argument("Unknown request " + command.verb + " with " + std::to_string(fields.size()) + " fields.");
+    }
+
+    /**
+     * @brief Runs a worker: takes jobs, executes them and hands the replies back.
+     */
+    void work()
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(_jobMutex);
+                _jobReady.wait(lock, [this]
+                               { return _stopping || !_jobs.empty(); });
+                if (_stopping)
+                    return;
+
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+
+            Completion completion{job.connection, string(), false};
+            try
+            {
+                completion.reply = execute(job.command, completion.mutated);
+            }
+            catch (const std::exception &error)
+            {
+                completion.reply = string("ERR ") + error.what() + '\n';
+            }
+
+            if (completion.mutated)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_heldMutex);
+                    _held.push_back(std::move(completion));
+                }
+                _heldReady.notify_one();
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_completionMutex);
+                _completions.push_back(std::move(completion));
+            }
+            wake();
+        }
+    }
+
+    /**
+     * @brief Runs the committer: commits the log for the held replies and posts them to the event loop.
+     *
+     * The changes of the held replies were appended to the log before they were held,
+     * so one commit makes all of them durable.
+     */
+    void commit()
+    {
+        vector<Completion> batch;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_heldMutex);
+                _heldReady.wait(lock, [this]
+                                { return !_committing || !_held.empty(); });
+                if (!_committing)
+                    return;
+
+                batch.swap(_held);
+            }
+
+            string error;
+            try
+            {
+                registry.syncStorage();
+            }
+            catch (const std::exception &failure)
+            {
+                error = failure.what();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_completionMutex);
+                if (!error.empty())
+                    _commitError = error;
+                else
+                    for (Completion &completion : batch)
+                        _completions.push_back(std::move(completion));
+            }
+            batch.clear();
+            wake();
+
+            if (!error.empty())
+                return;
+        }
+    }
+
+    /**
+     * @brief Wakes the event loop to collect completions.
+     */
+    void wake()
+    {
+        char wake = 1;
+        while (::write(_wakeFds[1], &wake, 1) < 0 && errno == EINTR)
+            ;
+    }
+
+    /**
+     * @brief Hands the next complete request line of an idle connection to the workers.
+     * @param id The ID of the connection.
+     * @param connection The connection.
+     */
+    void dispatch(uint64_t id, Connection &connection)
+    {
+        while (!connection.busy && !connection.closing)
+        {
+            size_t end = connection.input.find('\n');
+            if (end == string::npos)
+            {
+                if (connection.input.size() > MAX_REQUEST_SIZE)
+                {
+                    connection.output += "ERR Request too long.\n";
+                    connection.closing = true;
+                }
+                return;
+            }
+
+            string line = connection.input.substr(0, end);
+            connection.input.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+
+            if (line == "quit")
+            {
+                connection.output += "OK 0\n";
+                connection.closing = true;
+                return;
+            }
+
+            Job job{id, BatchCommand()};
+            BatchRunner::parse(line, job.command);
+            {
+                std::lock_guard<std::mutex> lock(_jobMutex);
+                _jobs.push_back(std::move(job));
+            }
+            _jobReady.notify_one();
+
+            connection.busy = true;
+        }
+    }
+
+    /**
+     * @brief Delivers the replies of finished requests; replies of mutations arrive once they are committed.
+     * @throws std::runtime_error If the committer could not commit the log.
+     */
+    void collectCompletions()
+    {
+        char drain[256];
+        while (::read(_wakeFds[0], drain, sizeof(drain)) > 0)
+            ;
+
+        vector<Completion> completions;
+        {
+            std::lock_guard<std::mutex> lock(_completionMutex);
+            if (!_commitError.empty())
+                throw runtime_error(_commitError);
+            completions.swap(_completions);
+        }
+
+        for (Completion &completion : completions)
+        {
+            auto it = _connections.find(completion.connection);
+            if (it == _connections.end())
+                continue;
+
+            it->second.output += completion.reply;
+            it->second.busy = false;
+            dispatch(it->first, it->second);
+        }
+    }
+
+    /**
+     * @brief Accepts every pending connection.
+     */
+    void acceptConnections()
+    {
+        while (true)
+        {
+            int fd = ::accept(_listenFd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    std::cerr << "Cannot accept connection: " << strerror(errno) << endl;
+                return;
+            }
+
+            setNonBlocking(fd);
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+            _connections[_nextConnection++].fd = fd;
+        }
+    }
+
+    /**
+     * @brief Reads what a connection has sent.
+     * @param connection The connection.
+     * @return False if the connection failed, true otherwise.
+     */
+    static bool receive(Connection &connection)
+    {
+        char buffer[16 * 1024];
+        while (true)
+        {
+            ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received > 0)
+            {
+                connection.input.append(buffer, received);
+                continue;
+            }
+            if (received == 0)
+            {
+                connection.drained = true;
+                return true;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+    }
+
+    /**
+     * @brief Sends as much of the pending reply as the socket accepts.
+     * @param connection The connection.
+     * @return False if the connection failed, true otherwise.
+     */
+    static bool transmit(Connection &connection)
+    {
+        size_t sent = 0;
+        while (sent < connection.output.size())
+        {
+            ssize_t written = ::send(connection.fd, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    return false;
+                break;
+            }
+            sent += written;
+        }
+        connection.output.erase(0, sent);
+        return true;
+    }
+
+public:
+    /**
+     * @brief Constructs a server for the given registry.
+     * @param reg Reference to the thread-safe registry.
+     */
+    RegistryServer(ConcurrentRegistry &reg) : registry(reg) {}
+
+    RegistryServer(const RegistryServer &) = delete;
+    RegistryServer &operator=(const RegistryServer &) = delete;
+
+    /**
+     * @brief Makes the server reject the requests that change the registry.
+     * @param readOnly True to serve a read replica.
+     */
+    void setReadOnly(bool readOnly)
+    {
+        _readOnly = readOnly;
+    }
+
+    ~RegistryServer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_jobMutex);
+            _stopping = true;
+        }
+        _jobReady.notify_all();
+        for (std::thread &worker : _workers)
+            worker.join();
+
+        {
+            std::lock_guard<std::mutex> lock(_heldMutex);
+            _committing = false;
+        }
+        _heldReady.notify_all();
+        if (_committer.joinable())
+            _committer.join();
+
+        for (auto &entry : _connections)
+            ::close(entry.second.fd);
+        for (int fd : {_listenFd, _wakeFds[0], _wakeFds[1]})
+            if (fd >= 0)
+                ::close(fd);
+    }
+
+    /**
+     * @brief Listens on a port and serves requests until the process is stopped.
+     * @param port The TCP port to listen on.
+     * @param workerCount The number of worker threads.
+     * @throws std::runtime_error If the port cannot be opened.
+     */
+    void run(uint16_t port, unsigned workerCount)
+    {
+        _listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+
+        if (_listenFd < 0 || setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            ::bind(_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(_listenFd, LISTEN_BACKLOG) != 0 || ::pipe(_wakeFds) != 0)
+        {
+            throw runtime_error("Cannot listen on port " + std::to_string(port) + ": " + strerror(errno));
+        }
+        setNonBlocking(_listenFd);
+        setNonBlocking(_wakeFds[0]);
+
+        for (unsigned i = 0; i < std::max(1u, workerCount); ++i)
+            _workers.emplace_back(&RegistryServer::work, this);
+        _committer = std::thread(&RegistryServer::commit, this);
+
+        cout << "Serving on port " << port << " with " << _workers.size() << " workers" << endl;
+
+        vector<pollfd> descriptors;
+        vector<uint64_t> owners;
+
+        while (true)
+        {
+            descriptors.clear();
+            owners.clear();
+            descriptors.push_back(pollfd{_wakeFds[0], POLLIN, 0});
+            descriptors.push_back(pollfd{_listenFd, POLLIN, 0});
+
+            for (auto &entry : _connections)
+            {
+                short events = entry.second.closing || entry.second.drained ? 0 : POLLIN;
+                if (!entry.second.output.empty())
+                    events |= POLLOUT;
+
+                descriptors.push_back(pollfd{entry.second.fd, events, 0});
+                owners.push_back(entry.first);
+            }
+
+            if (::poll(descriptors.data(), descriptors.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw runtime_error(string("Cannot poll sockets: ") + strerror(errno));
+            }
+
+            if (descriptors[0].revents & POLLIN)
+                collectCompletions();
+
+            for (size_t i = 0; i < owners.size(); ++i)
+            {
+                auto it = _connections.find(owners[i]);
+                Connection &connection = it->second;
+                short revents = descriptors[i + 2].revents;
+
+                bool healthy = !(revents & (POLLERR | POLLNVAL));
+                if (healthy && !connection.drained && (revents & (POLLIN | POLLHUP)))
+                {
+                    healthy = receive(connection);
+                    dispatch(it->first, connection);
+                }
+                if (healthy && !connection.output.empty())
+                    healthy = transmit(connection);
+
+                bool finished = connection.closing || connection.drained;
+                if (!healthy || (finished && connection.output.empty() && !connection.busy))
+                {
+                    ::close(connection.fd);
+                    _connections.erase(it);
+                }
+            }
+
+            if (descriptors[1].revents & POLLIN)
+                acceptConnections();
+        }
+    }
+};
@@ -0,0 +1,316 @@
+/**
+ * @struct ShiftPattern
+ * @brief The working hours of a doctor as a grid of equally long appointment slots.
+ *
+ * Every function is constexpr, so a pattern that is known at compile time, such as
+ * FixedShift::PATTERN, folds its slot arithmetic into constants.
+ */
+struct ShiftPattern
+{
+    using SlotMask = uint64_t; ///< One bit per slot of a day, bit 0 is the first slot.
+
+    static constexpr int MAX_SLOTS = 64; ///< Slots that fit into a SlotMask.
+
+    int startMinute; ///< Minute of the day at which the first slot starts.
+    int slotMinutes; ///< Length of a slot in minutes.
+    int slotCount;   ///< Number of slots in one working day.
+
+    /**
+     * @brief Converts a minute of the day to its slot index.
+     * @param minuteOfDay The number of minutes since midnight.
+     * @return The slot index, or -1 if the time is not on the grid.
+     */
+    constexpr int slotIndex(int minuteOfDay) const
+    {
+        int offset = minuteOfDay - startMinute;
+        if (offset < 0 || offset % slotMinutes != 0 || offset / slotMinutes >= slotCount)
+            return -1;
+
+        return offset / slotMinutes;
+    }
+
+    /**
+     * @brief Gets the minute of the day at which a slot starts.
+     * @param slot The slot index.
+     * @return The number of minutes since midnight.
+     */
+    constexpr int slotMinute(int slot) const
+    {
+        return startMinute + slot * slotMinutes;
+    }
+
+    /**
+     * @brief Gets the index of the first slot starting at or after a minute of the day.
+     * @param minuteOfDay The number of minutes since midnight.
+     * @return The slot index, or slotCount if no slot of the day starts that late.
+     */
+    constexpr int firstSlotFrom(int minuteOfDay) const
+    {
+        int offset = minuteOfDay - startMinute;
+        if (offset <= 0)
+            return 0;
+
+        return std::min(slotCount, (offset + slotMinutes - 1) / slotMinutes);
+    }
+
+    /**
+     * @brief Gets the mask with a bit set for every slot of a working day.
+     * @return The full mask.
+     */
+    constexpr SlotMask fullDay() const
+    {
+        return slotCount == MAX_SLOTS ? ~SlotMask(0) : (SlotMask(1) << slotCount) - 1;
+    }
+
+    /**
+     * @brief Gets the mask of the slots from a given slot to the end of the day.
+     * @param slot The first slot of the mask.
+     * @return A mask with a bit set for every slot at or after the given one.
+     */
+    constexpr SlotMask slotsFrom(int slot) const
+    {
+        return slot >= slotCount ? 0 : fullDay() & ~((SlotMask(1) << slot) - 1);
+    }
+
+    constexpr bool operator==(const ShiftPattern &other) const
+    {
+        return startMinute == other.startMinute && slotMinutes == other.slotMinutes && slotCount == other.slotCount;
+    }
+
+    constexpr bool operator!=(const ShiftPattern &other) const { return !(*this == other); }
+
+    /**
+     * @brief Parses a shift such as "07:00-15:00/20".
+     * @param text The start and end of the working hours and the slot length in minutes.
+     * @return The pattern; a last slot that would end after the end of the hours is dropped.
+     * @throws std::invalid_argument If the text is malformed or the day has no slot or more than MAX_SLOTS.
+     */
+    static ShiftPattern parse(const string &text)
+    {
+        int startHour, startMinute, endHour, endMinute, length;
+        char tail;
+        if (sscanf(text.c_str(), "%d:%d-%d:%d/%d%c", &startHour, &startMinute, &endHour, &endMinute, &length, &tail) != 5 ||
+            startHour < 0 || startMinute < 0 || startMinute > 59 || endMinute < 0 || endMinute > 59 || length < 1)
+            throw std::invalid_argument("Invalid shift: " + text);
+
+        int start = startHour * 60 + startMinute;
+        int end = endHour * 60 + endMinute;
+        int count = end > start ? (end - start) / length : 0;
+        if (end > Timestamp::MINUTES_PER_DAY || count < 1 || count > MAX_SLOTS)
+            throw std::invalid_argument("Invalid shift: " + text);
+
+        return ShiftPattern{start, length, count};
+    }
+
+    /**
+     * @brief Formats the pattern as parse reads it.
+     * @return The text, for example "08:00-18:00/30".
+     */
+    string toString() const
+    {
+        int end = slotMinute(slotCount);
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), "%02d:%02d-%02d:%02d/%d", startMinute / 60, startMinute % 60, end / 60, end % 60, slotMinutes);
+        return buffer;
+    }
+};
+
+/**
+ * @struct FixedShift
+ * @brief A shift pattern fixed at compile time.
+ * @tparam StartMinute Minute of the day at which the first slot starts.
+ * @tparam SlotMinutes Length of a slot in minutes.
+ * @tparam SlotCount Number of slots in one working day.
+ *
+ * The functions forward to a constexpr ShiftPattern, so the divisions and the mask
+ * width are constants the compiler reduces to shifts and multiplications.
+ */
+template <int StartMinute, int SlotMinutes, int SlotCount>
+struct FixedShift
+{
+    static_assert(SlotMinutes > 0 && SlotCount >= 1 && SlotCount <= ShiftPattern::MAX_SLOTS, "A working day must fit into a 64-bit slot mask.");
+    static_assert(StartMinute >= 0 && StartMinute + SlotMinutes * SlotCount <= Timestamp::MINUTES_PER_DAY, "A shift must end within its day.");
+
+    static constexpr ShiftPattern PATTERN{StartMinute, SlotMinutes, SlotCount}; ///< The pattern as a value.
+    static constexpr int SLOTS_PER_DAY = SlotCount;                          ///< Number of slots in one working day.
+    static constexpr ShiftPattern::SlotMask FULL_DAY = PATTERN.fullDay();    ///< Mask with a bit set for every slot of a working day.
+
+    static constexpr int slotIndex(int minuteOfDay) { return PATTERN.slotIndex(minuteOfDay); }
+    static constexpr int firstSlotFrom(int minuteOfDay) { return PATTERN.firstSlotFrom(minuteOfDay); }
+    static constexpr ShiftPattern::SlotMask slotsFrom(int slot) { return PATTERN.slotsFrom(slot); }
+    static Timestamp slotStart(int32_t day, int slot) { return Timestamp(day, PATTERN.slotMinute(slot)); }
+};
+
+/// The shift of every doctor without a configured one: 30-minute slots from 08:00 to 18:00.
+using DefaultShift = FixedShift<8 * 60, 30, 20>;
+
+/**
+ * @class SlotCalendar
+ * @brief Tracks the booked appointment slots of a single doctor.
+ *
+ * Each working day is represented by a bit mask with one bit per appointment slot of
+ * the doctor's shift. Checking availability is a single bit test and enumerating free
+ * slots walks the set bits of the inverted mask. Calendars on the default shift take
+ * the DefaultShift path, whose slot arithmetic is resolved at compile time; others
+ * use their ShiftPattern at run time.
+ */
+class SlotCalendar
+{
+public:
+    using SlotMask = ShiftPattern::SlotMask; ///< One bit per slot of a day, bit 0 is the first slot.
+
+private:
+    unordered_map<int32_t, SlotMask> _booked;    ///< Booked slots keyed by day index.
+    ShiftPattern _shift = DefaultShift::PATTERN; ///< The working hours of the doctor.
+    bool _defaultShift = true;                   ///< The shift is DefaultShift.
+
+public:
+    /**
+     * @brief Gets the shift of the calendar.
+     * @return The working hours and slot length.
+     */
+    const ShiftPattern &getShift() const
+    {
+        return _shift;
+    }
+
+    /**
+     * @brief Changes the shift of the calendar.
+     * @param shift The new working hours and slot length.
+     * @throws std::logic_error If slots are booked already, since their indices would change meaning.
+     */
+    void setShift(const ShiftPattern &shift)
+    {
+        if (!_booked.empty())
+            throw std::logic_error("Cannot change the shift of a calendar with bookings.");
+
+        _shift = shift;
+        _defaultShift = shift == DefaultShift::PATTERN;
+    }
+
+    /**
+     * @brief Converts a minute of the day to its slot index.
+     * @param minuteOfDay The number of minutes since midnight.
+     * @return The slot index, or -1 if the time is not on the doctor's grid.
+     */
+    int slotIndex(int minuteOfDay) const
+    {
+        return _defaultShift ? DefaultShift::slotIndex(minuteOfDay) : _shift.slotIndex(minuteOfDay);
+    }
+
+    /**
+     * @brief Gets the time at which a slot starts.
+     * @param day The day index of the slot.
+     * @param slot The slot index.
+     * @return The start of the slot.
+     */
+    Timestamp slotStart(int32_t day, int slot) const
+    {
+        return _defaultShift ? DefaultShift::slotStart(day, slot) : Timestamp(day, _shift.slotMinute(slot));
+    }
+
+    /**
+     * @brief Gets the index of the first slot starting at or after a minute of the day.
+     * @param minuteOfDay The number of minutes since midnight.
+     * @return The slot index, or slotsPerDay() if no slot of the day starts that late.
+     */
+    int firstSlotFrom(int minuteOfDay) const
+    {
+        return _defaultShift ? DefaultShift::firstSlotFrom(minuteOfDay) : _shift.firstSlotFrom(minuteOfDay);
+    }
+
+    /**
+     * @brief Gets the mask of the slots from a given slot to the end of the day.
+     * @param slot The first slot of the mask.
+     * @return A mask with a bit set for every slot at or after the given one.
+     */
+    SlotMask slotsFrom(int slot) const
+    {
+        return _defaultShift ? DefaultShift::slotsFrom(slot) : _shift.slotsFrom(slot);
+    }
+
+    /**
+     * @brief Gets the mask with a bit set for every slot of a working day.
+     * @return The full mask.
+     */
+    SlotMask fullDay() const
+    {
+        return _defaultShift ? DefaultShift::FULL_DAY : _shift.fullDay();
+    }
+
+    /**
+     * @brief Gets the number of slots in one working day.
+     * @return The slot count of the shift.
+     */
+    int slotsPerDay() const
+    {
+        return _defaultShift ? DefaultShift::SLOTS_PER_DAY : _shift.slotCount;
+    }
+
+    /**
+     * @brief Checks whether a slot is still free.
+     * @param day The day index.
+     * @param slot The slot index.
+     * @return True if the slot is free, false otherwise.
+     */
+    bool isFree(int32_t day, int slot) const
+    {
+        return (freeMask(day) >> slot) & 1;
+    }
+
+    /**
+     * @brief Gets the free slots of a day.
+     * @param day The day index.
+     * @return A mask with a bit set for every free slot.
+     */
+    SlotMask freeMask(int32_t day) const
+    {
+        auto it = _booked.find(day);
+        return it == _booked.end() ? fullDay() : (~it->second & fullDay());
+    }
+
+    /**
+     * @brief Counts the free slots of a day.
+     * @param day The day index.
+     * @return The number of free slots.
+     */
+    int freeCount(int32_t day) const
+    {
+        return __builtin_popcountll(freeMask(day));
+    }
+
+    /**
+     * @brief Estimates the number of bytes allocated for the calendar.
+     * @return The size of the bucket array and of the nodes of every booked day.
+     */
+    size_t memoryUsage() const
+    {
+        return _booked.bucket_count() * sizeof(void *) + _booked.size() * (sizeof(pair<const int32_t, SlotMask>) + sizeof(void *));
+    }
+
+    /**
+     * @brief Marks a slot as booked.
+     * @param day The day index.
+     * @param slot The slot index.
+     */
+    void book(int32_t day, int slot)
+    {
+        _booked[day] |= SlotMask(1) << slot;
+    }
+
+    /**
+     * @brief Marks a slot as free again.
+     * @param day The day index.
+     * @param slot The slot index.
+     */
+    void release(int32_t day, int slot)
+    {
+        auto it = _booked.find(day);
+        if (it == _booked.end())
+            return;
+
+        it->second &= ~(SlotMask(1) << slot);
+        if (it->second == 0)
+            _booked.erase(it);
+    }
+};
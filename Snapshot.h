@@ -0,0 +1,518 @@
+/**
+ * @struct SnapshotString
+ * @brief A string stored in the string pool of a snapshot.
+ */
+struct SnapshotString
+{
+    uint32_t offset; ///< Offset of the first character within the string pool.
+    uint32_t length; ///< Number of characters.
+};
+
+/**
+ * @struct SnapshotPerson
+ * @brief Fixed-width record of a doctor or patient in a snapshot.
+ */
+struct SnapshotPerson
+{
+    SnapshotString name;        ///< The name of the person.
+    SnapshotString dateOfBirth; ///< The date of birth, empty for doctors.
+};
+
+/**
+ * @struct SnapshotAppointment
+ * @brief Fixed-width record of an appointment in a snapshot.
+ */
+struct SnapshotAppointment
+{
+    PersonId doctorId;  ///< The ID of the doctor.
+    PersonId patientId; ///< The ID of the patient.
+    int32_t minutes;    ///< The packed Timestamp of the appointment.
+};
+
+/**
+ * @struct SnapshotVisitCard
+ * @brief Fixed-width record of a hospital visit card in a snapshot.
+ */
+struct SnapshotVisitCard
+{
+    PersonId doctorId;        ///< The ID of the doctor.
+    PersonId patientId;       ///< The ID of the patient.
+    int32_t minutes;          ///< The packed Timestamp of the visit.
+    SnapshotString diagnosis; ///< The diagnosis given to the patient.
+};
+
+/**
+ * @struct SnapshotSeries
+ * @brief Fixed-width record of a recurring appointment series in a snapshot.
+ */
+struct SnapshotSeries
+{
+    PersonId doctorId;      ///< The ID of the doctor.
+    PersonId patientId;     ///< The ID of the patient.
+    int32_t minutes;        ///< The packed Timestamp of the first occurrence.
+    uint16_t intervalDays;  ///< Days between occurrences.
+    uint16_t count;         ///< Number of occurrences.
+    SnapshotString skipped; ///< The skipped day indices as int32_t values in the string pool.
+};
+
+/**
+ * @struct SnapshotHeader
+ * @brief Header at the start of a snapshot file describing where each table lives.
+ *
+ * Every table is an array of fixed-width records aligned to 8 bytes, followed by a
+ * single string pool, so the file can be memory-mapped and read in place.
+ */
+struct SnapshotHeader
+{
+    char magic[8];              ///< Always SNAPSHOT_MAGIC.
+    uint32_t version;           ///< Layout version, SNAPSHOT_VERSION.
+    uint32_t epoch;             ///< Epoch of the write-ahead log that follows this snapshot.
+    uint64_t doctorOffset;      ///< File offset of the doctor table.
+    uint64_t doctorCount;       ///< Number of doctor records.
+    uint64_t patientOffset;     ///< File offset of the patient table.
+    uint64_t patientCount;      ///< Number of patient records.
+    uint64_t appointmentOffset; ///< File offset of the appointment table.
+    uint64_t appointmentCount;  ///< Number of appointment records.
+    uint64_t visitCardOffset;   ///< File offset of the visit card table.
+    uint64_t visitCardCount;    ///< Number of visit card records.
+    uint64_t stringPoolOffset;  ///< File offset of the string pool.
+    uint64_t stringPoolSize;    ///< Size of the string pool in bytes.
+    uint64_t seriesOffset;      ///< File offset of the series table; absent before version 2.
+    uint64_t seriesCount;       ///< Number of series records; absent before version 2.
+};
+
+static const char SNAPSHOT_MAGIC[8] = {'H', 'R', 'S', 'N', 'A', 'P', '\0', '\0'};     ///< Identifies snapshot files.
+static const uint32_t SNAPSHOT_VERSION = 2;                                           ///< Current snapshot layout version.
+static const size_t SNAPSHOT_V1_HEADER_SIZE = offsetof(SnapshotHeader, seriesOffset); ///< Header size of version 1 files, which have no series.
+
+/**
+ * @class SnapshotWriter
+ * @brief Collects registry tables and writes them as a memory-mappable snapshot.
+ */
+class SnapshotWriter
+{
+private:
+    vector<SnapshotPerson> _doctors;                     ///< Doctor records in ID order.
+    vector<SnapshotPerson> _patients;                    ///< Patient records in ID order.
+    vector<SnapshotAppointment> _appointments;           ///< Appointment records.
+    vector<SnapshotVisitCard> _visitCards;               ///< Visit card records.
+    vector<SnapshotSeries> _series;                      ///< Recurring series records.
+    string _strings;                                     ///< The string pool.
+    unordered_map<const char *, SnapshotString> _shared; ///< Interned registry strings already in the pool, by address.
+
+    /**
+     * @brief Copies a string into the pool.
+     * @param value The string to store.
+     * @return The location of the string in the pool.
+     */
+    SnapshotString intern(string_view value)
+    {
+        SnapshotString stored{static_cast<uint32_t>(_strings.size()), static_cast<uint32_t>(value.size())};
+        _strings.append(value.data(), value.size());
+        return stored;
+    }
+
+    /**
+     * @brief Copies a string interned by the registry into the pool once.
+     * @param value The interned string; equal strings share an address.
+     * @return The location of the string in the pool.
+     */
+    SnapshotString internShared(string_view value)
+    {
+        auto it = _shared.find(value.data());
+        if (it != _shared.end() && it->second.length == value.size())
+            return it->second;
+
+        SnapshotString stored = intern(value);
+        _shared[value.data()] = stored;
+        return stored;
+    }
+
+    /**
+     * @brief Writes a byte range to a file descriptor.
+     * @param fd The file descriptor.
+     * @param data The bytes to write.
+     * @param size The number of bytes.
+     * @return True on success, false otherwise.
+     */
+    static bool writeAll(int fd, const void *data, size_t size)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Rounds an offset up to the table alignment.
+     * @param offset The offset to align.
+     * @return The aligned offset.
+     */
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + 7) & ~uint64_t(7);
+    }
+
+public:
+    /**
+     * @brief Reserves room for the given table sizes.
+     * @param doctors The number of doctors.
+     * @param patients The number of patients.
+     * @param appointments The number of appointments.
+     * @param visitCards The number of visit cards.
+     */
+    void reserve(size_t doctors, size_t patients, size_t appointments, size_t visitCards)
+    {
+        _doctors.reserve(doctors);
+        _patients.reserve(patients);
+        _appointments.reserve(appointments);
+        _visitCards.reserve(visitCards);
+    }
+
+    /**
+     * @brief Adds a doctor; doctors must be added in ID order.
+     * @param name The name of the doctor.
+     */
+    void addDoctor(const string &name)
+    {
+        _doctors.push_back(SnapshotPerson{intern(name), SnapshotString{0, 0}});
+    }
+
+    /**
+     * @brief Adds a patient; patients must be added in ID order.
+     * @param name The name of the patient.
+     * @param dateOfBirth The date of birth of the patient.
+     */
+    void addPatient(const string &name, string_view dateOfBirth)
+    {
+        SnapshotString storedName = intern(name);
+        _patients.push_back(SnapshotPerson{storedName, internShared(dateOfBirth)});
+    }
+
+    /**
+     * @brief Adds an appointment.
+     * @param appointment The appointment to add.
+     */
+    void addAppointment(const Appointment &appointment)
+    {
+        _appointments.push_back(SnapshotAppointment{appointment.getDoctorId(), appointment.getPatientId(), appointment.getDateTime().minutes()});
+    }
+
+    /**
+     * @brief Adds a hospital visit card.
+     * @param visitCard The visit card to add.
+     */
+    void addVisitCard(const HospitalVisitCard &visitCard)
+    {
+        _visitCards.push_back(SnapshotVisitCard{visitCard.getDoctorId(), visitCard.getPatientId(), visitCard.getDateTime().minutes(), internShared(visitCard.getDiagnosis())});
+    }
+
+    /**
+     * @brief Adds a recurring appointment series.
+     * @param series The series to add.
+     */
+    void addSeries(const AppointmentSeries &series)
+    {
+        const vector<int32_t> &skipped = series.getSkipped();
+        SnapshotString stored = intern(string_view(reinterpret_cast<const char *>(skipped.data()), skipped.size() * sizeof(int32_t)));
+
+        _series.push_back(SnapshotSeries{series.getDoctorId(), series.getPatientId(), series.getFirst().minutes(),
+                                         static_cast<uint16_t>(series.getIntervalDays()), static_cast<uint16_t>(series.size()), stored});
+    }
+
+    /**
+     * @brief Writes the snapshot to a file and fsyncs it.
+     * @param path The path of the file to create or replace.
+     * @param epoch The log epoch the snapshot starts.
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void write(const string &path, uint32_t epoch) const
+    {
+        SnapshotHeader header = {};
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.epoch = epoch;
+
+        uint64_t offset = align(sizeof(header));
+        header.doctorOffset = offset;
+        header.doctorCount = _doctors.size();
+        offset = align(offset + _doctors.size() * sizeof(SnapshotPerson));
+        header.patientOffset = offset;
+        header.patientCount = _patients.size();
+        offset = align(offset + _patients.size() * sizeof(SnapshotPerson));
+        header.appointmentOffset = offset;
+        header.appointmentCount = _appointments.size();
+        offset = align(offset + _appointments.size() * sizeof(SnapshotAppointment));
+        header.visitCardOffset = offset;
+        header.visitCardCount = _visitCards.size();
+        offset = align(offset + _visitCards.size() * sizeof(SnapshotVisitCard));
+        header.seriesOffset = offset;
+        header.seriesCount = _series.size();
+        offset = align(offset + _series.size() * sizeof(SnapshotSeries));
+        header.stringPoolOffset = offset;
+        header.stringPoolSize = _strings.size();
+
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw runtime_error("Cannot write snapshot " + path + ": " + strerror(errno));
+
+        static const char padding[8] = {};
+        uint64_t position = 0;
+        auto writeTable = [&](uint64_t tableOffset, const void *data, size_t size)
+        {
+            bool ok = writeAll(fd, padding, tableOffset - position) && writeAll(fd, data, size);
+            position = tableOffset + size;
+            return ok;
+        };
+
+        bool ok = writeTable(0, &header, sizeof(header)) &&
+                  writeTable(header.doctorOffset, _doctors.data(), _doctors.size() * sizeof(SnapshotPerson)) &&
+                  writeTable(header.patientOffset, _patients.data(), _patients.size() * sizeof(SnapshotPerson)) &&
+                  writeTable(header.appointmentOffset, _appointments.data(), _appointments.size() * sizeof(SnapshotAppointment)) &&
+                  writeTable(header.visitCardOffset, _visitCards.data(), _visitCards.size() * sizeof(SnapshotVisitCard)) &&
+                  writeTable(header.seriesOffset, _series.data(), _series.size() * sizeof(SnapshotSeries)) &&
+                  writeTable(header.stringPoolOffset, _strings.data(), _strings.size()) &&
+                  ::fsync(fd) == 0;
+
+        ::close(fd);
+
+        if (!ok)
+            throw runtime_error("Cannot write snapshot " + path + ": " + strerror(errno));
+    }
+};
+
+/**
+ * @class MappedSnapshot
+ * @brief A read-only, memory-mapped view of a snapshot file.
+ *
+ * Opening a snapshot validates the header and table bounds; the accessors then return
+ * records and strings straight from the mapping, without parsing or copying them.
+ * Registry adds the records to its live tables, which own the rows and indices, but
+ * keeps the snapshot mapped and serves the pooled diagnoses and dates of birth from
+ * it. Because the file is mapped shared, several processes reading the same snapshot
+ * share the pages through the OS page cache.
+ */
+class MappedSnapshot
+{
+private:
+    const char *_data = nullptr; ///< Start of the mapping.
+    size_t _size = 0;            ///< Size of the mapping in bytes.
+
+    /**
+     * @brief Gets the header of the mapped file.
+     * @return A reference to the header.
+     */
+    const SnapshotHeader &header() const
+    {
+        return *reinterpret_cast<const SnapshotHeader *>(_data);
+    }
+
+    /**
+     * @brief Checks that a table lies inside the mapping.
+     * @param offset The offset of the table.
+     * @param count The number of records.
+     * @param recordSize The size of one record.
+     * @return True if the table is in bounds and aligned, false otherwise.
+     */
+    bool fits(uint64_t offset, uint64_t count, uint64_t recordSize) const
+    {
+        return offset % 8 == 0 && offset <= _size && count <= (_size - offset) / (recordSize ? recordSize : 1);
+    }
+
+    /**
+     * @brief Resolves a pooled string.
+     * @param value The location of the string.
+     * @return A view of the string, empty if it lies outside the pool.
+     */
+    string_view resolve(const SnapshotString &value) const
+    {
+        if (value.offset > header().stringPoolSize || value.length > header().stringPoolSize - value.offset)
+            return string_view();
+        return string_view(_data + header().stringPoolOffset + value.offset, value.length);
+    }
+
+public:
+    MappedSnapshot() = default;
+    MappedSnapshot(const MappedSnapshot &) = delete;
+    MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+
+    ~MappedSnapshot()
+    {
+        close();
+    }
+
+    /**
+     * @brief Maps a snapshot file.
+     * @param path The path of the snapshot.
+     * @return True if the file exists and is a valid snapshot, false otherwise.
+     */
+    bool open(const string &path)
+    {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < SNAPSHOT_V1_HEADER_SIZE)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void *mapping = ::mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+
+        _data = static_cast<const char *>(mapping);
+        _size = info.st_size;
+
+        const SnapshotHeader &h = header();
+        bool current = h.version == SNAPSHOT_VERSION && _size >= sizeof(SnapshotHeader);
+        bool valid = memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) == 0 && (current || h.version == 1) &&
+                     (!current || fits(h.seriesOffset, h.seriesCount, sizeof(SnapshotSeries))) &&
+                     fits(h.doctorOffset, h.doctorCount, sizeof(SnapshotPerson)) &&
+                     fits(h.patientOffset, h.patientCount, sizeof(SnapshotPerson)) &&
+                     fits(h.appointmentOffset, h.appointmentCount, sizeof(SnapshotAppointment)) &&
+                     fits(h.visitCardOffset, h.visitCardCount, sizeof(SnapshotVisitCard)) &&
+                     fits(h.stringPoolOffset, h.stringPoolSize, 1);
+        if (!valid)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Unmaps the snapshot.
+     */
+    void close()
+    {
+        if (_data != nullptr)
+            ::munmap(const_cast<char *>(_data), _size);
+        _data = nullptr;
+        _size = 0;
+    }
+
+    /**
+     * @brief Checks whether a snapshot is mapped.
+     * @return True if a valid snapshot is open, false otherwise.
+     */
+    bool isOpen() const
+    {
+        return _data != nullptr;
+    }
+
+    /**
+     * @brief Gets the log epoch the snapshot starts.
+     * @return The epoch stored in the header.
+     */
+    uint32_t epoch() const { return header().epoch; }
+
+    /// @name Table sizes
+    /// @{
+    size_t doctorCount() const { return header().doctorCount; }
+    size_t patientCount() const { return header().patientCount; }
+    size_t appointmentCount() const { return header().appointmentCount; }
+    size_t visitCardCount() const { return header().visitCardCount; }
+    size_t seriesCount() const { return header().version >= 2 ? header().seriesCount : 0; }
+    /// @}
+
+    /**
+     * @brief Gets the name of a doctor.
+     * @param id The ID of the doctor.
+     * @return A view of the name inside the mapping.
+     */
+    string_view doctorName(PersonId id) const
+    {
+        return resolve(reinterpret_cast<const SnapshotPerson *>(_data + header().doctorOffset)[id].name);
+    }
+
+    /**
+     * @brief Gets the name of a patient.
+     * @param id The ID of the patient.
+     * @return A view of the name inside the mapping.
+     */
+    string_view patientName(PersonId id) const
+    {
+        return resolve(reinterpret_cast<const SnapshotPerson *>(_data + header().patientOffset)[id].name);
+    }
+
+    /**
+     * @brief Gets the date of birth of a patient.
+     * @param id The ID of the patient.
+     * @return A view of the date of birth inside the mapping.
+     */
+    string_view patientDateOfBirth(PersonId id) const
+    {
+        return resolve(reinterpret_cast<const SnapshotPerson *>(_data + header().patientOffset)[id].dateOfBirth);
+    }
+
+    /**
+     * @brief Gets an appointment record.
+     * @param index The position of the appointment.
+     * @return A reference to the record inside the mapping.
+     */
+    const SnapshotAppointment &appointment(size_t index) const
+    {
+        return reinterpret_cast<const SnapshotAppointment *>(_data + header().appointmentOffset)[index];
+    }
+
+    /**
+     * @brief Gets a visit card record.
+     * @param index The position of the visit card.
+     * @return A reference to the record inside the mapping.
+     */
+    const SnapshotVisitCard &visitCard(size_t index) const
+    {
+        return reinterpret_cast<const SnapshotVisitCard *>(_data + header().visitCardOffset)[index];
+    }
+
+    /**
+     * @brief Gets the diagnosis of a visit card.
+     * @param index The position of the visit card.
+     * @return A view of the diagnosis inside the mapping.
+     */
+    string_view visitCardDiagnosis(size_t index) const
+    {
+        return resolve(visitCard(index).diagnosis);
+    }
+
+    /**
+     * @brief Gets a recurring series record.
+     * @param index The position of the series.
+     * @return A reference to the record inside the mapping.
+     */
+    const SnapshotSeries &series(size_t index) const
+    {
+        return reinterpret_cast<const SnapshotSeries *>(_data + header().seriesOffset)[index];
+    }
+
+    /**
+     * @brief Gets the skipped days of a recurring series.
+     * @param index The position of the series.
+     * @return The skipped day indices.
+     */
+    vector<int32_t> seriesSkipped(size_t index) const
+    {
+        string_view bytes = resolve(series(index).skipped);
+
+        vector<int32_t> skipped(bytes.size() / sizeof(int32_t));
+        memcpy(skipped.data(), bytes.data(), skipped.size() * sizeof(int32_t));
+        return skipped;
+    }
+};
@@ -0,0 +1,156 @@
+/**
+ * @class StringArena
+ * @brief Bump allocator that stores strings in large blocks and frees them all at once.
+ *
+ * Strings are copied back to back into blocks of BLOCK_SIZE bytes, so storing many
+ * short strings costs one heap allocation per block instead of one per string, and
+ * stored strings never move.
+ */
+class StringArena
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024; ///< Size of a regular block.
+
+private:
+    vector<std::unique_ptr<char[]>> _blocks; ///< Every block allocated so far.
+    char *_cursor = nullptr;                 ///< Next free byte of the current block.
+    size_t _remaining = 0;                   ///< Free bytes left in the current block.
+    size_t _reserved = 0;                    ///< Total bytes allocated for blocks.
+
+public:
+    /**
+     * @brief Copies a string into the arena.
+     * @param text The string to copy.
+     * @return A view of the copy; it stays valid as long as the arena.
+     */
+    string_view store(string_view text)
+    {
+        if (text.empty())
+            return string_view();
+
+        if (text.size() > _remaining)
+        {
+            size_t size = std::max(BLOCK_SIZE, text.size());
+            _blocks.emplace_back(new char[size]);
+            _reserved += size;
+
+            if (size > BLOCK_SIZE)
+            {
+                memcpy(_blocks.back().get(), text.data(), text.size());
+                return string_view(_blocks.back().get(), text.size());
+            }
+
+            _cursor = _blocks.back().get();
+            _remaining = size;
+        }
+
+        memcpy(_cursor, text.data(), text.size());
+        string_view stored(_cursor, text.size());
+        _cursor += text.size();
+        _remaining -= text.size();
+        return stored;
+    }
+
+    /**
+     * @brief Gets the number of bytes allocated for blocks.
+     * @return The size of all blocks.
+     */
+    size_t reserved() const
+    {
+        return _reserved;
+    }
+};
+
+/**
+ * @class StringPool
+ * @brief Stores every distinct string once and hands out stable views and IDs for it.
+ *
+ * Repeated values such as diagnosis codes and dates of birth are kept as a single
+ * copy in a StringArena, or not copied at all when they are adopted from storage that
+ * outlives the pool, such as a mapped snapshot. Two interned views with equal contents always point to the
+ * same bytes, so interned strings can be compared and deduplicated by address.
+ */
+class StringPool
+{
+public:
+    using StringId = uint32_t; ///< Index of an interned string.
+
+private:
+    StringArena _arena;                          ///< Storage of the interned strings.
+    unordered_map<string_view, StringId> _index; ///< Interned string to its ID.
+    vector<string_view> _strings;                ///< Interned strings by ID.
+
+public:
+    /**
+     * @brief Interns a string and gets its ID.
+     * @param text The string to intern.
+     * @return The ID of the interned copy.
+     */
+    StringId id(string_view text)
+    {
+        auto it = _index.find(text);
+        if (it != _index.end())
+            return it->second;
+
+        string_view stored = _arena.store(text);
+        StringId id = _strings.size();
+        _strings.push_back(stored);
+        _index.emplace(stored, id);
+        return id;
+    }
+
+    /**
+     * @brief Interns a string that outlives the pool without copying it.
+     * @param text The string, for example a view into a mapped file that stays mapped.
+     * @return The interned view: an equal string interned earlier, or text itself.
+     */
+    string_view adopt(string_view text)
+    {
+        auto it = _index.find(text);
+        if (it != _index.end())
+            return _strings[it->second];
+
+        _index.emplace(text, StringId(_strings.size()));
+        _strings.push_back(text);
+        return text;
+    }
+
+    /**
+     * @brief Interns a string.
+     * @param text The string to intern.
+     * @return A view of the interned copy; it stays valid as long as the pool.
+     */
+    string_view intern(string_view text)
+    {
+        return _strings[id(text)];
+    }
+
+    /**
+     * @brief Gets an interned string by ID.
+     * @param id The ID returned by id().
+     * @return A view of the interned string.
+     * @throws std::out_of_range If the ID was not handed out by this pool.
+     */
+    string_view view(StringId id) const
+    {
+        return _strings.at(id);
+    }
+
+    /**
+     * @brief Gets the number of distinct interned strings.
+     * @return The number of strings.
+     */
+    size_t size() const
+    {
+        return _strings.size();
+    }
+
+    /**
+     * @brief Gets the number of bytes allocated for string storage.
+     * @return The size of the arena.
+     */
+    size_t bytes() const
+    {
+        return _arena.reserved();
+    }
+};
@@ -0,0 +1,211 @@
+/**
+ * @class Timestamp
+ * @brief A compact date and time value used for appointments and visit cards.
+ *
+ * A timestamp is stored as the number of minutes since 1970-01-01 00:00 of the civil
+ * calendar, so it fits into 32 bits, compares with a single integer comparison and
+ * splits into a day index and a minute of the day without any string work. Text is
+ * only parsed and formatted at the user interface boundary.
+ */
+class Timestamp
+{
+private:
+    int32_t _minutes; ///< Minutes since 1970-01-01 00:00.
+
+    /**
+     * @brief Converts a civil date to the number of days since 1970-01-01.
+     * @param year The year.
+     * @param month The month (1-12).
+     * @param day The day of the month (1-31).
+     * @return The day index.
+     */
+    static int32_t daysFromCivil(int year, int month, int day)
+    {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const int yoe = year - era * 400;
+        const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    /**
+     * @brief Converts a number of days since 1970-01-01 to a civil date.
+     * @param days The day index.
+     * @param year Receives the year.
+     * @param month Receives the month (1-12).
+     * @param day Receives the day of the month (1-31).
+     */
+    static void civilFromDays(int32_t days, int &year, int &month, int &day)
+    {
+        days += 719468;
+        const int era = (days >= 0 ? days : days - 146096) / 146097;
+        const int doe = days - era * 146097;
+        const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const int mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = yoe + era * 400 + (month <= 2);
+    }
+
+    /**
+     * @brief Gets the length of a month.
+     * @param year The year.
+     * @param month The month (1-12).
+     * @return The number of days in the month, taking leap years into account.
+     */
+    static int daysInMonth(int year, int month)
+    {
+        static const int lengths[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return month == 2 && leap ? 29 : lengths[month - 1];
+    }
+
+public:
+    static constexpr int MINUTES_PER_DAY = 24 * 60; ///< Number of minutes in one day.
+    static constexpr int MIN_YEAR = 1970;           ///< The earliest year parse() accepts.
+    static constexpr int MAX_YEAR = 4000;           ///< The latest year parse() accepts; its last minute still fits in 32 bits.
+
+    /**
+     * @brief Constructs a timestamp at 1970-01-01 00:00.
+     */
+    Timestamp() : _minutes(0) {}
+
+    /**
+     * @brief Constructs a timestamp from a day index and a minute of that day.
+     * @param day The number of days since 1970-01-01.
+     * @param minuteOfDay The minute of the day (0-1439).
+     */
+    Timestamp(int32_t day, int minuteOfDay) : _minutes(day * MINUTES_PER_DAY + minuteOfDay) {}
+
+    /**
+     * @brief Constructs a timestamp from its packed value.
+     * @param minutes The number of minutes since 1970-01-01 00:00.
+     * @return The timestamp.
+     */
+    static Timestamp fromMinutes(int32_t minutes)
+    {
+        return Timestamp(0, minutes);
+    }
+
+    /**
+     * @brief Parses a date or a date and time.
+     * @param text The text in the format YYYY-MM-DD or YYYY-MM-DD HH:MM.
+     * @return The parsed timestamp; a date without time maps to midnight.
+     * @throws std::invalid_argument If the text is not a valid date or date and time, has text after it,
+     *         or its year is outside MIN_YEAR to MAX_YEAR.
+     */
+    static Timestamp parse(const string &text)
+    {
+        int year, month, day, hour = 0, minute = 0, consumed = -1;
+        int fields = sscanf(text.c_str(), "%d-%d-%d%n %d:%d%n", &year, &month, &day, &consumed, &hour, &minute, &consumed);
+
+        if ((fields != 3 && fields != 5) || consumed != int(text.size()) || year < MIN_YEAR || year > MAX_YEAR || month < 1 || month > 12 ||
+            day < 1 || day > daysInMonth(year, month) || hour < 0 || hour > 23 || minute < 0 || minute > 59)
+        {
+            throw std::invalid_argument("Invalid date: " + text);
+        }
+
+        return Timestamp(daysFromCivil(year, month, day), hour * 60 + minute);
+    }
+
+    /**
+     * @brief Gets the number of days since 1970-01-01.
+     * @return The day index of the timestamp.
+     */
+    int32_t day() const
+    {
+        return _minutes >= 0 ? _minutes / MINUTES_PER_DAY : (_minutes - MINUTES_PER_DAY + 1) / MINUTES_PER_DAY;
+    }
+
+    /**
+     * @brief Gets the minute of the day.
+     * @return The number of minutes since midnight.
+     */
+    int minuteOfDay() const
+    {
+        return _minutes - day() * MINUTES_PER_DAY;
+    }
+
+    /**
+     * @brief Gets the timestamp at midnight of the same day.
+     * @return The date part of the timestamp.
+     */
+    Timestamp date() const
+    {
+        return Timestamp(day(), 0);
+    }
+
+    /**
+     * @brief Gets the raw number of minutes since 1970-01-01 00:00.
+     * @return The packed value of the timestamp.
+     */
+    int32_t minutes() const
+    {
+        return _minutes;
+    }
+
+    /**
+     * @brief Writes the date part into a buffer.
+     * @param buffer A buffer of at least 11 characters.
+     * @return The number of characters written, excluding the terminator.
+     */
+    int formatDate(char *buffer) const
+    {
+        int year, month, dayOfMonth;
+        civilFromDays(day(), year, month, dayOfMonth);
+        return snprintf(buffer, 11, "%04d-%02d-%02d", year, month, dayOfMonth);
+    }
+
+    /**
+     * @brief Writes the date and time into a buffer.
+     * @param buffer A buffer of at least 17 characters.
+     * @return The number of characters written, excluding the terminator.
+     */
+    int format(char *buffer) const
+    {
+        int length = formatDate(buffer);
+        int minute = minuteOfDay();
+        return length + snprintf(buffer + length, 7, " %02d:%02d", minute / 60, minute % 60);
+    }
+
+    /**
+     * @brief Formats the date part.
+     * @return The date in the format YYYY-MM-DD.
+     */
+    string dateString() const
+    {
+        char buffer[16];
+        return string(buffer, formatDate(buffer));
+    }
+
+    /**
+     * @brief Formats the date and time.
+     * @return The date and time in the format YYYY-MM-DD HH:MM.
+     */
+    string toString() const
+    {
+        char buffer[24];
+        return string(buffer, format(buffer));
+    }
+
+    bool operator==(const Timestamp &other) const { return _minutes == other._minutes; }
+    bool operator!=(const Timestamp &other) const { return _minutes != other._minutes; }
+    bool operator<(const Timestamp &other) const { return _minutes < other._minutes; }
+    bool operator<=(const Timestamp &other) const { return _minutes <= other._minutes; }
+    bool operator>(const Timestamp &other) const { return _minutes > other._minutes; }
+    bool operator>=(const Timestamp &other) const { return _minutes >= other._minutes; }
+};
+
+/**
+ * @brief Writes a timestamp in the format YYYY-MM-DD HH:MM.
+ * @param out The output stream.
+ * @param timestamp The timestamp to write.
+ * @return The output stream.
+ */
+inline std::ostream &operator<<(std::ostream &out, const Timestamp &timestamp)
+{
+    char buffer[24];
+    return out.write(buffer, timestamp.format(buffer));
+}
@@ -0,0 +1,141 @@
+/**
+ * @class WorkerPool
+ * @brief A fixed set of threads that run the chunks of a parallel loop.
+ *
+ * run() splits a loop into numbered chunks which the pool threads and the calling
+ * thread claim one at a time from a shared counter, so a slow chunk never leaves the
+ * other threads idle. Each chunk writes its own part of the result and the caller
+ * merges the parts in chunk order, which keeps the outcome identical to a serial loop.
+ * When the pool is already busy with another caller, the loop simply runs serially
+ * on the calling thread.
+ */
+class WorkerPool
+{
+private:
+    vector<std::thread> _threads;                       ///< The pool threads.
+    std::mutex _mutex;                                  ///< Guards the job state below.
+    std::condition_variable _wake;                      ///< Signals a new job or shutdown.
+    std::condition_variable _done;                      ///< Signals that every pool thread finished the job.
+    std::mutex _callMutex;                              ///< Held by the caller whose job is running.
+    const std::function<void(size_t)> *_task = nullptr; ///< The chunk function of the running job.
+    size_t _chunkCount = 0;                             ///< Number of chunks of the running job.
+    std::atomic<size_t> _nextChunk{0};                  ///< Next chunk to be claimed.
+    size_t _busyThreads = 0;                            ///< Pool threads still working on the running job.
+    uint64_t _generation = 0;                           ///< Incremented for every job.
+    bool _stopping = false;                             ///< Tells the pool threads to exit.
+
+    /**
+     * @brief Claims and runs chunks until none are left.
+     * @param task The chunk function.
+     */
+    void drain(const std::function<void(size_t)> &task)
+    {
+        for (size_t chunk = _nextChunk++; chunk < _chunkCount; chunk = _nextChunk++)
+            task(chunk);
+    }
+
+    /**
+     * @brief Runs a pool thread: waits for jobs and helps with their chunks.
+     */
+    void work()
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            const std::function<void(size_t)> *task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this, seen]
+                           { return _stopping || _generation != seen; });
+                if (_stopping)
+                    return;
+
+                seen = _generation;
+                task = _task;
+            }
+
+            drain(*task);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busyThreads == 0)
+                _done.notify_one();
+        }
+    }
+
+public:
+    /**
+     * @brief Starts a pool.
+     * @param threadCount The number of pool threads besides the calling thread.
+     */
+    explicit WorkerPool(unsigned threadCount)
+    {
+        for (unsigned i = 0; i < threadCount; ++i)
+            _threads.emplace_back(&WorkerPool::work, this);
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (std::thread &thread : _threads)
+            thread.join();
+    }
+
+    /**
+     * @brief Gets the pool shared by the whole process, sized to the machine.
+     * @return The shared pool.
+     */
+    static WorkerPool &shared()
+    {
+        static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    /**
+     * @brief Gets the number of threads that work on a job, including the caller.
+     * @return The degree of parallelism.
+     */
+    size_t concurrency() const
+    {
+        return _threads.size() + 1;
+    }
+
+    /**
+     * @brief Runs every chunk of a loop and returns when all of them finished.
+     * @param chunkCount The number of chunks.
+     * @param task Called once with each chunk number; it must not throw.
+     */
+    void run(size_t chunkCount, const std::function<void(size_t)> &task)
+    {
+        std::unique_lock<std::mutex> call(_callMutex, std::try_to_lock);
+        if (!call.owns_lock() || _threads.empty() || chunkCount < 2)
+        {
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+                task(chunk);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _chunkCount = chunkCount;
+            _nextChunk = 0;
+            _busyThreads = _threads.size();
+            _generation++;
+        }
+        _wake.notify_all();
+
+        drain(task);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]
+                   { return _busyThreads == 0; });
+        _task = nullptr;
+    }
+};
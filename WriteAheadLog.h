@@ -0,0 +1,602 @@
+/**
+ * @enum LogOperation
+ * @brief Enumerates the registry operations recorded in the write-ahead log.
+ */
+enum class LogOperation : uint8_t
+{
+    CHECKPOINT = 1,  ///< Marks the snapshot epoch a log or snapshot file belongs to.
+    ADD_PATIENT,     ///< A patient was added to the registry.
+    SCHEDULE,        ///< An appointment was scheduled.
+    CANCEL,          ///< An appointment was canceled.
+    ADD_VISIT_CARD,  ///< A hospital visit card was added.
+    ADD_SERIES,      ///< A recurring appointment series was added.
+    SKIP_OCCURRENCE, ///< An occurrence of a recurring series was skipped.
+    DOCTOR           ///< A doctor of the roster the following entries refer to by ID.
+};
+
+/**
+ * @struct LogRecord
+ * @brief A single decoded entry of the write-ahead log.
+ *
+ * Only the fields that belong to the operation are meaningful: patients carry a name
+ * and date of birth, appointments carry IDs and a timestamp, visit cards additionally
+ * carry the diagnosis in text, and checkpoints carry the epoch. A series carries the
+ * IDs, its first occurrence, its interval and its length; a skipped occurrence carries
+ * the IDs and timestamp of the occurrence. A roster entry carries the ID and name of a
+ * doctor, so a reader can check that the IDs in the entries mean the doctors it has.
+ */
+struct LogRecord
+{
+    LogOperation operation = LogOperation::CHECKPOINT; ///< The recorded operation.
+    uint32_t epoch = 0;                                ///< Snapshot epoch of a checkpoint.
+    PersonId doctorId = 0;                             ///< The doctor of the appointment or visit.
+    PersonId patientId = 0;                            ///< The patient of the appointment or visit.
+    Timestamp dateTime;                                ///< The date and time of the appointment or visit.
+    string text;                                       ///< Patient name, doctor name or diagnosis.
+    string extra;                                      ///< Patient date of birth.
+    uint32_t interval = 0;                             ///< Days between the occurrences of a series.
+    uint32_t count = 0;                                ///< Number of occurrences of a series.
+};
+
+/**
+ * @class WriteAheadLog
+ * @brief An append-only binary log of registry operations with group commit.
+ *
+ * Each entry is written as a length, an FNV-1a checksum and the encoded record, so a
+ * torn write at the end of the file is detected and dropped on replay. Appended entries
+ * are buffered and written with a single write and fsync, which keeps the write latency
+ * flat under load. The log has no timer of its own and append() never writes: the owner
+ * asks commitDue() after a change, which holds once GROUP_COMMIT_SIZE entries are
+ * pending or the oldest of them is older than GROUP_COMMIT_DELAY, and calls commit().
+ * Owners that promise durability commit before they acknowledge a change; the server
+ * does so before it releases the replies of the changes, and the menu and batch modes
+ * when the registry is closed.
+ *
+ * The log may be shared between threads. Appends only take a short buffer lock, and
+ * commits are serialized by a lock of their own, so threads keep appending while another
+ * one writes and fsyncs a batch; the batches reach the file and the commit listener in
+ * the order they were appended.
+ *
+ * A failed write or fsync rolls the file back to its last committed size and throws,
+ * leaving the batch pending, so the entries are neither acknowledged nor shipped and a
+ * later commit writes them again. The same format is used for snapshot files and for
+ * the stream shipped to read replicas, which a commit listener receives as the
+ * committed bytes.
+ */
+class WriteAheadLog
+{
+public:
+    static constexpr size_t GROUP_COMMIT_SIZE = 64;              ///< Entries per fsync batch.
+    static constexpr chrono::milliseconds GROUP_COMMIT_DELAY{5}; ///< Age of the oldest pending entry at which a commit is due.
+    static constexpr size_t HEADER_SIZE = 2 * sizeof(uint32_t);  ///< Length and checksum of an entry.
+    static constexpr size_t MAX_TEXT_SIZE = UINT16_MAX;          ///< Longest name, date of birth or diagnosis an entry can hold.
+
+private:
+    std::atomic<int> _fd{-1};                    ///< File descriptor of the open log, or -1.
+    string _path;                                ///< Path of the open log.
+    off_t _committedSize = 0;                    ///< Bytes of the file that were written and fsynced; guarded by _commitMutex.
+    string _writing;                             ///< The batch being written; guarded by _commitMutex.
+    std::function<void(string_view)> _committed; ///< Receives the entries of every commit, or empty; guarded by _commitMutex.
+    std::mutex _commitMutex;                     ///< Serializes commits and the changes of the open file.
+
+    string _pending;                          ///< Encoded entries not yet written.
+    size_t _pendingCount = 0;                 ///< Number of entries in _pending.
+    size_t _entryCount = 0;                   ///< Entries in the log file, written or pending.
+    off_t _endPosition = 0;                   ///< Position in the file the next appended entry will have.
+    chrono::steady_clock::time_point _oldest; ///< Time the oldest pending entry was appended.
+    mutable std::mutex _bufferMutex;          ///< Guards the pending entries and the counts above.
+
+    /**
+     * @brief Computes the FNV-1a checksum of a byte range.
+     * @param data The bytes to hash.
+     * @param size The number of bytes.
+     * @return The 32-bit checksum.
+     */
+    static uint32_t checksum(const char *data, size_t size)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief Appends the raw bytes of a fixed-width value.
+     * @param out The buffer to append to.
+     * @param value The value to append.
+     */
+    template <typename T>
+    static void put(string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    /**
+     * @brief Appends a length-prefixed string.
+     * @param out The buffer to append to.
+     * @param value The string to append, at most MAX_TEXT_SIZE bytes.
+     * @throws std::length_error If the string is too long to be logged.
+     */
+    static void putString(string &out, const string &value)
+    {
+        if (value.size() > MAX_TEXT_SIZE)
+            throw std::length_error("A logged text may hold at most " + std::to_string(MAX_TEXT_SIZE) + " bytes.");
+
+        put<uint16_t>(out, static_cast<uint16_t>(value.size()));
+        out.append(value);
+    }
+
+    /**
+     * @brief Drops the bytes written since the last commit and throws.
+     * @param action What failed, such as "write" or "fsync".
+     * @throws std::runtime_error Always.
+     */
+    [[noreturn]] void rollBack(const char *action)
+    {
+        string reason = strerror(errno);
+
+        if (::ftruncate(_fd, _committedSize) != 0 || ::lseek(_fd, _committedSize, SEEK_SET) < 0)
+            reason += "; the log could not be rolled back";
+
+        throw runtime_error(string("Cannot ") + action + " log " + _path + ": " + reason);
+    }
+
+    /**
+     * @brief Writes and fsyncs all pending entries, then hands them to the commit listener.
+     * @throws std::runtime_error If the entries cannot be written or fsynced; they stay pending.
+     *
+     * The caller holds _commitMutex. The batch is taken out of the buffer first, so
+     * appends go on while it is written, and put back in front of the newer entries if
+     * the write fails.
+     */
+    void commitLocked()
+    {
+        size_t count;
+        chrono::steady_clock::time_point oldest;
+        {
+            std::lock_guard<std::mutex> buffer(_bufferMutex);
+            if (!isOpen() || _pendingCount == 0)
+                return;
+
+            _writing.clear();
+            _writing.swap(_pending);
+            count = _pendingCount;
+            oldest = _oldest;
+            _pendingCount = 0;
+        }
+
+        try
+        {
+            const char *data = _writing.data();
+            size_t remaining = _writing.size();
+            while (remaining > 0)
+            {
+                ssize_t written = ::write(_fd, data, remaining);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    rollBack("write");
+                }
+                data += written;
+                remaining -= written;
+            }
+
+            if (::fsync(_fd) != 0)
+                rollBack("fsync");
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> buffer(_bufferMutex);
+            _writing.append(_pending);
+            _writing.swap(_pending);
+            _pendingCount += count;
+            _oldest = oldest;
+            throw;
+        }
+        _committedSize += _writing.size();
+
+        if (_committed)
+            _committed(_writing);
+    }
+
+    /**
+     * @brief Reads a fixed-width value and advances the cursor.
+     * @param data The read cursor.
+     * @param end The end of the readable bytes.
+     * @param value Receives the value.
+     * @return True if enough bytes were available, false otherwise.
+     */
+    template <typename T>
+    static bool get(const char *&data, const char *end, T &value)
+    {
+        if (end - data < static_cast<ptrdiff_t>(sizeof(value)))
+            return false;
+        memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+        return true;
+    }
+
+    /**
+     * @brief Reads a length-prefixed string and advances the cursor.
+     * @param data The read cursor.
+     * @param end The end of the readable bytes.
+     * @param value Receives the string.
+     * @return True if enough bytes were available, false otherwise.
+     */
+    static bool getString(const char *&data, const char *end, string &value)
+    {
+        uint16_t length;
+        if (!get(data, end, length) || end - data < length)
+            return false;
+        value.assign(data, length);
+        data += length;
+        return true;
+    }
+
+    /**
+     * @brief Encodes a record body.
+     * @param record The record to encode.
+     * @param out Receives the encoded bytes.
+     */
+    static void encode(const LogRecord &record, string &out)
+    {
+        put<uint8_t>(out, static_cast<uint8_t>(record.operation));
+
+        switch (record.operation)
+        {
+        case LogOperation::CHECKPOINT:
+            put<uint32_t>(out, record.epoch);
+            break;
+        case LogOperation::ADD_PATIENT:
+            putString(out, record.text);
+            putString(out, record.extra);
+            break;
+        case LogOperation::DOCTOR:
+            put<uint32_t>(out, record.doctorId);
+            putString(out, record.text);
+            break;
+        case LogOperation::SCHEDULE:
+        case LogOperation::CANCEL:
+        case LogOperation::ADD_VISIT_CARD:
+        case LogOperation::ADD_SERIES:
+        case LogOperation::SKIP_OCCURRENCE:
+            put<uint32_t>(out, record.doctorId);
+            put<uint32_t>(out, record.patientId);
+            put<int32_t>(out, record.dateTime.minutes());
+            if (record.operation == LogOperation::ADD_VISIT_CARD)
+                putString(out, record.text);
+            if (record.operation == LogOperation::ADD_SERIES)
+            {
+                put<uint32_t>(out, record.interval);
+                put<uint32_t>(out, record.count);
+            }
+            break;
+        }
+    }
+
+    /**
+     * @brief Decodes a record body.
+     * @param data The encoded bytes.
+     * @param end The end of the encoded bytes.
+     * @param record Receives the decoded record.
+     * @return True if the bytes form a valid record, false otherwise.
+     */
+    static bool decode(const char *data, const char *end, LogRecord &record)
+    {
+        uint8_t operation;
+        if (!get(data, end, operation))
+            return false;
+
+        record.operation = static_cast<LogOperation>(operation);
+
+        switch (record.operation)
+        {
+        case LogOperation::CHECKPOINT:
+            return get(data, end, record.epoch);
+        case LogOperation::ADD_PATIENT:
+            return getString(data, end, record.text) && getString(data, end, record.extra);
+        case LogOperation::DOCTOR:
+            return get(data, end, record.doctorId) && getString(data, end, record.text);
+        case LogOperation::SCHEDULE:
+        case LogOperation::CANCEL:
+        case LogOperation::ADD_VISIT_CARD:
+        case LogOperation::ADD_SERIES:
+        case LogOperation::SKIP_OCCURRENCE:
+        {
+            int32_t minutes;
+            if (!get(data, end, record.doctorId) || !get(data, end, record.patientId) || !get(data, end, minutes))
+                return false;
+            record.dateTime = Timestamp::fromMinutes(minutes);
+            if (record.operation == LogOperation::ADD_SERIES)
+                return get(data, end, record.interval) && get(data, end, record.count);
+            return record.operation != LogOperation::ADD_VISIT_CARD || getString(data, end, record.text);
+        }
+        }
+        return false;
+    }
+
+public:
+    WriteAheadLog() = default;
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    ~WriteAheadLog()
+    {
+        close();
+    }
+
+    /**
+     * @brief Appends a record as a log entry: its length, checksum and encoded body.
+     * @param record The record to append.
+     * @param out The buffer to append to.
+     */
+    static void frame(const LogRecord &record, string &out)
+    {
+        size_t start = out.size();
+        out.append(HEADER_SIZE, '\0');
+        encode(record, out);
+
+        uint32_t length = out.size() - start - HEADER_SIZE;
+        uint32_t sum = checksum(out.data() + start + HEADER_SIZE, length);
+        memcpy(&out[start], &length, sizeof(length));
+        memcpy(&out[start + sizeof(length)], &sum, sizeof(sum));
+    }
+
+    /**
+     * @brief Reads the intact entries at the start of a buffer.
+     * @tparam Callback A callable taking a const LogRecord reference.
+     * @param contents The entries.
+     * @param callback Called for each entry in order.
+     * @return The number of bytes of intact entries; a torn or incomplete tail is not counted.
+     */
+    template <typename Callback>
+    static size_t parse(string_view contents, Callback callback)
+    {
+        const char *data = contents.data();
+        const char *end = data + contents.size();
+        LogRecord record;
+
+        while (end - data >= static_cast<ptrdiff_t>(HEADER_SIZE))
+        {
+            uint32_t length, sum;
+            memcpy(&length, data, sizeof(length));
+            memcpy(&sum, data + sizeof(length), sizeof(sum));
+
+            const char *body = data + HEADER_SIZE;
+            if (end - body < static_cast<ptrdiff_t>(length) || checksum(body, length) != sum ||
+                !decode(body, body + length, record))
+                break;
+
+            callback(record);
+            data = body + length;
+        }
+
+        return data - contents.data();
+    }
+
+    /**
+     * @brief Reads every intact entry of a log file.
+     * @tparam Callback A callable taking a const LogRecord reference.
+     * @param path The path of the log file.
+     * @param callback Called for each entry in order.
+     * @return The number of bytes of intact entries; a torn tail is not counted.
+     */
+    template <typename Callback>
+    static size_t replay(const string &path, Callback callback)
+    {
+        ifstream in(path, std::ios::binary);
+        if (!in)
+            return 0;
+
+        string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return parse(contents, callback);
+    }
+
+    /**
+     * @brief Opens a log file for appending.
+     * @param path The path of the log file.
+     * @param validSize Bytes of intact entries as returned by replay(); anything beyond is discarded.
+     * @param entryCount The number of intact entries already in the file.
+     * @throws std::runtime_error If the file cannot be opened.
+     */
+    void open(const string &path, size_t validSize = 0, size_t entryCount = 0)
+    {
+        close();
+
+        _fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (_fd < 0 || ::ftruncate(_fd, validSize) != 0 || ::lseek(_fd, validSize, SEEK_SET) < 0)
+        {
+            close();
+            throw runtime_error("Cannot open log " + path + ": " + strerror(errno));
+        }
+
+        _path = path;
+        _entryCount = entryCount;
+        _committedSize = validSize;
+        _endPosition = validSize;
+    }
+
+    /**
+     * @brief Checks whether the log is open.
+     * @return True if entries are being recorded, false otherwise.
+     */
+    bool isOpen() const
+    {
+        return _fd >= 0;
+    }
+
+    /**
+     * @brief Gets the number of entries in the log, including pending ones.
+     * @return The number of entries.
+     */
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> buffer(_bufferMutex);
+        return _entryCount;
+    }
+
+    /**
+     * @brief Appends an entry to the pending batch.
+     * @param record The record to append.
+     * @throws std::length_error If a text of the record is too long to be logged; nothing is appended then.
+     */
+    void append(const LogRecord &record)
+    {
+        if (!isOpen())
+            return;
+
+        std::lock_guard<std::mutex> buffer(_bufferMutex);
+
+        size_t start = _pending.size();
+        try
+        {
+            frame(record, _pending);
+        }
+        catch (...)
+        {
+            _pending.resize(start);
+            throw;
+        }
+
+        if (_pendingCount++ == 0)
+            _oldest = chrono::steady_clock::now();
+        _entryCount++;
+        _endPosition += _pending.size() - start;
+    }
+
+    /**
+     * @brief Checks whether the pending batch is full or old enough to be committed.
+     * @return True if commit() should be called, false otherwise.
+     */
+    bool commitDue() const
+    {
+        std::lock_guard<std::mutex> buffer(_bufferMutex);
+        return _pendingCount >= GROUP_COMMIT_SIZE || (_pendingCount > 0 && chrono::steady_clock::now() - _oldest >= GROUP_COMMIT_DELAY);
+    }
+
+    /**
+     * @brief Gets the position in the file the next appended entry will have.
+     * @return The position, counting the pending entries.
+     */
+    off_t endPosition() const
+    {
+        std::lock_guard<std::mutex> buffer(_bufferMutex);
+        return _endPosition;
+    }
+
+    /**
+     * @brief Writes and fsyncs all pending entries, then hands them to the commit listener.
+     * @throws std::runtime_error If the entries cannot be written or fsynced; they stay pending.
+     */
+    void commit()
+    {
+        std::lock_guard<std::mutex> committing(_commitMutex);
+        commitLocked();
+    }
+
+    /**
+     * @brief Drops the entries before a position, keeping the ones from it on.
+     * @param position The position of an entry, as endPosition() returned it before the entry was appended.
+     * @throws std::runtime_error If the shortened log cannot be written.
+     *
+     * Pending entries are committed first. The kept entries are written to a new file
+     * that is renamed over the log, so a crash leaves either the whole log or the kept
+     * part. Entries appended meanwhile stay pending and go to the new file.
+     */
+    void dropBefore(off_t position)
+    {
+        std::lock_guard<std::mutex> committing(_commitMutex);
+        if (!isOpen())
+            return;
+
+        commitLocked();
+
+        string kept(_committedSize - position, '\0');
+        if (::pread(_fd, &kept[0], kept.size(), position) != static_cast<ssize_t>(kept.size()))
+            throw runtime_error("Cannot read log " + _path + ": " + strerror(errno));
+
+        size_t keptCount = 0;
+        parse(kept, [&keptCount](const LogRecord &)
+              { keptCount++; });
+
+        string temporaryPath = _path + ".tmp";
+        int fd = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        bool ok = fd >= 0 && ::write(fd, kept.data(), kept.size()) == static_cast<ssize_t>(kept.size()) && ::fsync(fd) == 0 &&
+                  std::rename(temporaryPath.c_str(), _path.c_str()) == 0;
+        if (!ok)
+        {
+            string reason = strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            ::unlink(temporaryPath.c_str());
+            throw runtime_error("Cannot shorten log " + _path + ": " + reason);
+        }
+
+        int dropped;
+        {
+            std::lock_guard<std::mutex> buffer(_bufferMutex);
+            dropped = _fd.exchange(fd);
+            _entryCount = keptCount + _pendingCount;
+            _endPosition -= position;
+        }
+        _committedSize = kept.size();
+        ::close(dropped);
+    }
+
+    /**
+     * @brief Sets the function that receives the entries of every commit once they are durable.
+     * @param listener Called with the committed entries by the committing thread, in commit order, or empty to stop.
+     */
+    void setCommitListener(std::function<void(string_view)> listener)
+    {
+        std::lock_guard<std::mutex> committing(_commitMutex);
+        _committed = std::move(listener);
+    }
+
+    /**
+     * @brief Discards every entry of the log, keeping it open.
+     * @throws std::runtime_error If the file cannot be truncated or fsynced.
+     */
+    void reset()
+    {
+        std::lock_guard<std::mutex> committing(_commitMutex);
+        if (!isOpen())
+            return;
+
+        {
+            std::lock_guard<std::mutex> buffer(_bufferMutex);
+            _pending.clear();
+            _pendingCount = 0;
+            _entryCount = 0;
+            _endPosition = 0;
+        }
+        _committedSize = 0;
+
+        if (::ftruncate(_fd, 0) != 0 || ::lseek(_fd, 0, SEEK_SET) < 0 || ::fsync(_fd) != 0)
+            throw runtime_error("Cannot truncate log " + _path + ": " + strerror(errno));
+    }
+
+    /**
+     * @brief Commits pending entries and closes the log.
+     */
+    void close()
+    {
+        if (!isOpen())
+            return;
+
+        try
+        {
+            commit();
+        }
+        catch (const std::exception &error)
+        {
+            std::cerr << error.what() << std::endl;
+        }
+        ::close(_fd);
+        _fd = -1;
+    }
+};
@@ -1,44 +1,295 @@
 /// @library
 /// @{
-#include <iostream>  //<! Used for std::cout, std::endl, std::cin.
-#include <string>    //<! Provides std::string class and related functions.
-#include <vector>    //<! Provides std::vector container for dynamic arrays.
-#include <utility>   //<! Provides utility std::pair.
-#include <iomanip>   //<! Provides std::put_time.
-#include <sstream>   //<! Provides std::ostringstream for string stream operations.
-#include <set>       //<! Provides std::set container for storing unique elements in a specific order.
-#include <algorithm> //<! Provides std::remove_if.
+#include <iostream>      //<! Used for std::cout, std::endl, std::cin.
+#include <string>        //<! Provides std::string class and related functions.
+#include <vector>        //<! Provides std::vector container for dynamic arrays.
+#include <deque>         //<! Provides std::deque container with stable element references.
+#include <unordered_map> //<! Provides std::unordered_map for name indices.
+#include <utility>       //<! Provides utility std::pair.
+#include <iomanip>       //<! Provides std::put_time.
+#include <sstream>       //<! Provides std::ostringstream for string stream operations.
+#include <stdexcept>     //<! Provides std::invalid_argument, std::length_error and std::runtime_error.
+#include <set>           //<! Provides std::set container for storing unique elements in a specific order.
+#include <queue>         //<! Provides std::priority_queue for the waiting list sweep.
+#include <algorithm>     //<! Provides std::remove_if.
+#include <cstdint>       //<! Provides fixed-width integer types such as uint64_t.
+#include <cstddef>       //<! Provides offsetof for versioned snapshot headers.
+#include <cstring>       //<! Provides std::memcpy, std::strcmp and std::strerror.
+#include <cerrno>        //<! Provides errno.
+#include <fstream>       //<! Provides std::ifstream for reading log files.
+#include <iterator>      //<! Provides std::istreambuf_iterator.
+#include <fcntl.h>       //<! Provides open and its flags.
+#include <unistd.h>      //<! Provides write, pread, fsync, ftruncate and close.
+#include <sys/stat.h>    //<! Provides mkdir and fstat.
+#include <sys/mman.h>    //<! Provides mmap and munmap.
+#include <dirent.h>      //<! Provides opendir and readdir for listing archive partitions.
+#include <string_view>   //<! Provides std::string_view for reading mapped strings.
+#include <array>         //<! Provides std::array for fixed sets of locks.
+#include <mutex>         //<! Provides std::unique_lock.
+#include <shared_mutex>  //<! Provides std::shared_mutex and std::shared_lock for reader-writer locking.
+#include <thread>        //<! Provides std::thread for the server worker pool.
+#include <condition_variable> //<! Provides std::condition_variable for handing jobs to workers.
+#include <atomic>        //<! Provides std::atomic for claiming work without locks.
+#include <functional>    //<! Provides std::function for worker pool tasks.
+#include <memory>        //<! Provides std::unique_ptr for arena blocks and std::shared_ptr for report views.
+#include <poll.h>        //<! Provides poll for the server event loop.
+#include <sys/socket.h>  //<! Provides socket, bind, listen, accept, recv and send.
+#include <netinet/in.h>  //<! Provides sockaddr_in and htons.
+#include <netinet/tcp.h> //<! Provides TCP_NODELAY.
+#include <netdb.h>       //<! Provides getaddrinfo for connecting replicas to their primary.
+#include <random>        //<! Provides std::mt19937 for generating benchmark data.
+#include <malloc.h>      //<! Provides malloc_usable_size for counting heap bytes in use.
 /// @}
 
+using std::deque;
 using std::pair;
 using std::string;
+using std::unordered_map;
 using std::vector;
 
+#include "Timestamp.h"
 #include "InputOutput.h"
-#include "AbstractPerson.h"
 #include "helpers.h"
+#include "WorkerPool.h"
+#include "Metrics.h"
+#include "AllocationCounter.h"
+#include "StringPool.h"
+#include "SlotCalendar.h"
+#include "Appointment.h"
+#include "PageStamps.h"
+#include "FreeSlotBoard.h"
+#include "AppointmentStore.h"
+#include "AppointmentArchive.h"
+#include "AppointmentSeries.h"
+#include "SearchIndex.h"
+#include "WriteAheadLog.h"
+#include "IRegistry.h"
+#include "AbstractPerson.h"
 #include "Doctor.h"
+#include "FreeSlotRange.h"
 #include "Patient.h"
 #include "HospitalVisitCard.h"
-#include "Appointment.h"
-#include "IRegistry.h"
+#include "Snapshot.h"
 #include "Registry.h"
+#include "ReportView.h"
+#include "ConcurrentRegistry.h"
+#include "AssignmentEngine.h"
 #include "Menu.h"
+#include "BatchRunner.h"
+#include "Server.h"
+#include "Replication.h"
+#include "RosterImporter.h"
+#include "Benchmark.h"
 
 /**
- * @fn int main()
+ * @fn int main(int argc, char *argv[])
  * @brief The main entry point for the application.
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
  *
  * Initializes the registry, user interface, and main menu.
- * Starts the application by invoking the start method on the menu.
+ * With --data-dir DIR the registry is restored from and logged to DIR; otherwise it
+ * lives in memory only. With --roster FILE the doctors and patients of a CSV or JSON-lines
+ * roster are added at startup; doctors, with their shifts, before storage is restored, so their IDs match
+ * the stored appointments, and patients after it. Default appointments are generated when nothing was restored
+ * and no roster was given, so they only ever pair up the built-in doctors and patients.
+ * Restored appointments of days before today are moved to the compressed archive in DIR,
+ * and recurring series are booked up to the end of their active window.
+ * With --batch FILE the commands in FILE (or standard input for "-") are applied
+ * without the interactive menu. With --serve PORT the registry is served over TCP by
+ * --workers N threads (one per core by default); otherwise the application starts the menu.
+ * A served registry with --data-dir ships its log to read replicas with --ship PORT. With
+ * --replica-of HOST:PORT the served registry is a read-only replica of that primary
+ * instead: it takes only the doctors of the roster, which must match the primary's, and
+ * gets everything else from the primary's log.
+ * With --bench [SETTINGS] a synthetic data set is generated in a fresh in-memory registry
+ * and the hot paths are timed instead, so --data-dir and --roster are refused with it;
+ * SETTINGS is a list such as "doctors=500,patients=100000,iterations=5000".
+ * Standard streams are unsynchronized from C stdio except in server mode, where worker
+ * threads may print concurrently.
+ * Building with -DREGISTRY_METRICS adds latency histograms and table statistics, shown by
+ * the registrator menu and the server's metrics request.
+ * Building with -DREGISTRY_ALLOCATION_CHECKS counts heap allocations; --bench then also
+ * checks the allocations per operation and the memory per appointment against their
+ * budgets and returns 1 if any is exceeded.
  * @return int Returns 0 upon successful execution.
  */
-int main()
+int main(int argc, char *argv[])
 {
     Registry registry;
 
     InputOutput interface;
 
+    bool restored = false;
+    const char *dataDirectory = nullptr;
+    const char *rosterFile = nullptr;
+    const char *batchFile = nullptr;
+    int port = -1;
+    int shipPort = -1;
+    const char *primary = nullptr;
+    unsigned workers = std::thread::hardware_concurrency();
+    const char *benchSettings = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--data-dir") == 0 && i + 1 < argc)
+        {
+            dataDirectory = argv[++i];
+        }
+        else if (strcmp(argv[i], "--roster") == 0 && i + 1 < argc)
+        {
+            rosterFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batchFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+        {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--ship") == 0 && i + 1 < argc)
+        {
+            shipPort = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--replica-of") == 0 && i + 1 < argc)
+        {
+            primary = argv[++i];
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            workers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+        {
+            benchSettings = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : "";
+        }
+    }
+
+    if (port < 0)
+    {
+        std::ios::sync_with_stdio(false);
+    }
+
+    if ((shipPort >= 0 && (dataDirectory == nullptr || port < 0)) ||
+        (primary != nullptr && (dataDirectory != nullptr || port < 0 || shipPort >= 0)))
+    {
+        std::cerr << "--ship needs --serve and --data-dir; --replica-of needs --serve without --data-dir or --ship" << endl;
+        return 1;
+    }
+
+    if (benchSettings != nullptr && (dataDirectory != nullptr || rosterFile != nullptr))
+    {
+        std::cerr << "--bench generates its own data set and takes neither --data-dir nor --roster" << endl;
+        return 1;
+    }
+
+    if (benchSettings != nullptr)
+    {
+        try
+        {
+            BenchmarkConfig config;
+            config.parse(benchSettings);
+
+            Benchmark benchmark(registry, config);
+            if (!benchmark.run(cout))
+                return 1;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    try
+    {
+        RosterImporter importer(registry);
+
+        if (dataDirectory == nullptr)
+        {
+            if (rosterFile != nullptr)
+                importer.import(rosterFile, primary != nullptr ? RosterImporter::DOCTORS : RosterImporter::EVERYONE, cout);
+        }
+        else
+        {
+            if (rosterFile != nullptr)
+            {
+                std::ostringstream discarded;
+                importer.import(rosterFile, RosterImporter::DOCTORS, discarded);
+            }
+
+            restored = registry.openStorage(dataDirectory);
+            registry.archivePastDays(Timestamp::parse(getTodayDate()));
+            registry.advanceSeriesWindow(Timestamp::parse(getTodayDate()));
+
+            if (rosterFile != nullptr)
+                importer.import(rosterFile, RosterImporter::PATIENTS, cout);
+        }
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << error.what() << endl;
+        return 1;
+    }
+
+    if (!restored && primary == nullptr && rosterFile == nullptr)
+    {
+        registry.generateDefaultAppointments();
+    }
+
+    if (batchFile != nullptr)
+    {
+        BatchRunner runner(registry);
+
+        if (strcmp(batchFile, "-") == 0)
+        {
+            runner.run(cin, cout);
+            return 0;
+        }
+
+        ifstream script(batchFile);
+        if (!script)
+        {
+            std::cerr << "Cannot open batch file " << batchFile << endl;
+            return 1;
+        }
+
+        runner.run(script, cout);
+        return 0;
+    }
+
+    if (port >= 0)
+    {
+        ConcurrentRegistry shared(registry);
+        RegistryServer server(shared);
+        LogShipper shipper(shared);
+        LogFollower follower(shared);
+
+        try
+        {
+            if (shipPort >= 0)
+                shipper.start(shipPort);
+
+            if (primary != nullptr)
+            {
+                follower.start(primary);
+                size_t entries = follower.waitUntilSynced();
+                cout << "Replica of " << primary << " synced with " << entries << " entries" << endl;
+                server.setReadOnly(true);
+            }
+
+            server.run(port, workers);
+        }
+        catch (const std::exception &error)
+        {
+            std::cerr << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     Menu menu(registry, interface);
 
     menu.start();